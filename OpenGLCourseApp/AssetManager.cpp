@@ -0,0 +1,237 @@
+#include <stdio.h>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <utility>
+
+#include "AssetManager.h"
+
+// Unreferenced assets may take this much before the oldest get evicted
+static const size_t DefaultBudgetBytes = 256 * 1024 * 1024;
+
+static size_t GetAssetBytes(Texture* Asset) { return Asset->GetByteSize(); }
+static size_t GetAssetBytes(Mesh* Asset) { return Asset->GetByteSize(); }
+static size_t GetAssetBytes(Model* Asset) { return Asset->GetByteSize(); }
+static size_t GetAssetBytes(Shader*) { return 0; }		// Programs live in driver memory
+
+AssetManager::AssetManager()
+{
+	BudgetBytes = DefaultBudgetBytes;
+	UseCounter = 0;
+	Statistics = {};
+}
+
+std::string AssetManager::MakeKey(const std::string& Path, const std::string& Parameters)
+{
+	// "Models/../Textures/a.png" & "Textures/a.png" are the same file
+	std::error_code Error;
+	std::filesystem::path Canonical = std::filesystem::weakly_canonical(Path, Error);
+	std::string Key = Error ? Path : Canonical.generic_string();
+
+#ifdef _WIN32
+	// Windows paths are case insensitive
+	std::transform(Key.begin(), Key.end(), Key.begin(), [](unsigned char Char) { return (char)std::tolower(Char); });
+#endif
+
+	return Key + "|" + Parameters;
+}
+
+template <typename T, typename... Args>
+std::shared_ptr<T> AssetManager::Acquire(AssetCache<T>* Cache, const std::string& Key, bool* bOutCreated, Args&&... ConstructorArgs)
+{
+	std::lock_guard<std::mutex> Guard(CacheLock);
+
+	Statistics.Requests++;
+	UseCounter++;
+
+	typename AssetCache<T>::iterator Found = Cache->find(Key);
+	if (Found != Cache->end())
+	{
+		Statistics.Hits++;
+		Statistics.BytesSaved += GetAssetBytes(Found->second.Asset.get());
+		Found->second.LastUsed = UseCounter;
+		*bOutCreated = false;
+		return Found->second.Asset;
+	}
+
+	CacheEntry<T>& Entry = (*Cache)[Key];
+	Entry.Asset = std::make_shared<T>(std::forward<Args>(ConstructorArgs)...);
+	Entry.LastUsed = UseCounter;
+	*bOutCreated = true;
+	return Entry.Asset;
+}
+
+std::shared_ptr<Texture> AssetManager::AcquireTexture(const std::string& Path, GLenum Format, bool* bOutCreated)
+{
+	return Acquire(&Textures, MakeKey(Path, Format == GL_RGBA ? "RGBA" : "RGB"), bOutCreated, Path.c_str());
+}
+
+std::shared_ptr<Texture> AssetManager::LoadTexture(const std::string& Path, GLenum Format)
+{
+	bool bCreated = false;
+	std::shared_ptr<Texture> Asset = AcquireTexture(Path, Format, &bCreated);
+	if (bCreated && Asset->DecodeTexture())
+	{
+		Asset->UploadTexture(Format);
+	}
+	return Asset;
+}
+
+std::shared_ptr<Mesh> AssetManager::AcquireMesh(const std::string& Name, bool* bOutCreated)
+{
+	return Acquire(&Meshes, "mesh:" + Name, bOutCreated);
+}
+
+std::shared_ptr<Model> AssetManager::AcquireModel(const std::string& Path, bool* bOutCreated)
+{
+	return Acquire(&Models, MakeKey(Path, ""), bOutCreated);
+}
+
+std::shared_ptr<Shader> AssetManager::LoadShader(const std::string& VertexPath, const std::string& FragmentPath,
+	const std::string& GeometryPath, const std::string& Defines)
+{
+	bool bCreated = false;
+	std::shared_ptr<Shader> Asset = Acquire(&Shaders, MakeShaderKey(VertexPath, FragmentPath, GeometryPath, Defines), &bCreated);
+	if (bCreated)
+	{
+		Asset->SetDefines(Defines);
+		if (GeometryPath.empty())
+		{
+			Asset->CreateFromFiles(VertexPath.c_str(), FragmentPath.c_str());
+		}
+		else
+		{
+			Asset->CreateFromFiles(VertexPath.c_str(), FragmentPath.c_str(), GeometryPath.c_str());
+		}
+	}
+	return Asset;
+}
+
+std::shared_ptr<Shader> AssetManager::LoadShaderAsync(const std::string& VertexPath, const std::string& FragmentPath,
+	const std::string& GeometryPath, const std::string& Defines)
+{
+	bool bCreated = false;
+	std::shared_ptr<Shader> Asset = Acquire(&Shaders, MakeShaderKey(VertexPath, FragmentPath, GeometryPath, Defines), &bCreated);
+	if (bCreated)
+	{
+		Asset->SetDefines(Defines);
+		Asset->CreateFromFilesAsync(VertexPath.c_str(), FragmentPath.c_str(), GeometryPath.c_str());
+	}
+	return Asset;
+}
+
+std::string AssetManager::MakeShaderKey(const std::string& VertexPath, const std::string& FragmentPath,
+	const std::string& GeometryPath, const std::string& Defines)
+{
+	std::string Key = MakeKey(VertexPath, "") + ";" + MakeKey(FragmentPath, "");
+	if (!GeometryPath.empty())
+	{
+		Key += ";" + MakeKey(GeometryPath, "");
+	}
+	Key += ";" + Defines;
+	return Key;
+}
+
+void AssetManager::SetBudget(size_t NewBudgetBytes)
+{
+	std::lock_guard<std::mutex> Guard(CacheLock);
+	BudgetBytes = NewBudgetBytes;
+}
+
+template <typename T>
+size_t AssetManager::CountBytes(const AssetCache<T>& Cache)
+{
+	size_t Bytes = 0;
+	for (typename AssetCache<T>::const_iterator It = Cache.begin(); It != Cache.end(); ++It)
+	{
+		Bytes += GetAssetBytes(It->second.Asset.get());
+	}
+	return Bytes;
+}
+
+template <typename T>
+void AssetManager::GatherUnused(const AssetCache<T>& Cache, AssetType Type, std::vector<EvictionCandidate>* OutCandidates)
+{
+	for (typename AssetCache<T>::const_iterator It = Cache.begin(); It != Cache.end(); ++It)
+	{
+		// Only the cache itself still holds it
+		if (It->second.Asset.use_count() == 1)
+		{
+			OutCandidates->push_back({ It->second.LastUsed, GetAssetBytes(It->second.Asset.get()), Type, It->first });
+		}
+	}
+}
+
+void AssetManager::CollectGarbage()
+{
+	std::lock_guard<std::mutex> Guard(CacheLock);
+
+	size_t Resident = CountBytes(Textures) + CountBytes(Meshes) + CountBytes(Models) + CountBytes(Shaders);
+	if (Resident <= BudgetBytes)
+	{
+		Statistics.ResidentBytes = Resident;
+		return;
+	}
+
+	std::vector<EvictionCandidate> Candidates;
+	GatherUnused(Textures, ASSET_TEXTURE, &Candidates);
+	GatherUnused(Meshes, ASSET_MESH, &Candidates);
+	GatherUnused(Models, ASSET_MODEL, &Candidates);
+	GatherUnused(Shaders, ASSET_SHADER, &Candidates);
+
+	// Least recently used first
+	std::sort(Candidates.begin(), Candidates.end(), [](const EvictionCandidate& A, const EvictionCandidate& B)
+	{
+		return A.LastUsed < B.LastUsed;
+	});
+
+	for (size_t i = 0; i < Candidates.size() && Resident > BudgetBytes; i++)
+	{
+		switch (Candidates[i].Type)
+		{
+		case ASSET_TEXTURE: Textures.erase(Candidates[i].Key); break;
+		case ASSET_MESH: Meshes.erase(Candidates[i].Key); break;
+		case ASSET_MODEL: Models.erase(Candidates[i].Key); break;
+		case ASSET_SHADER: Shaders.erase(Candidates[i].Key); break;
+		}
+
+		Resident -= Candidates[i].Bytes;
+		Statistics.Evictions++;
+	}
+
+	// Textures an evicted model was holding become candidates on the next collection
+	Statistics.ResidentBytes = Resident;
+}
+
+void AssetManager::Clear()
+{
+	std::lock_guard<std::mutex> Guard(CacheLock);
+
+	Models.clear();
+	Meshes.clear();
+	Textures.clear();
+	Shaders.clear();
+	Statistics.ResidentBytes = 0;
+}
+
+AssetManager::AssetStatistics AssetManager::GetStatistics()
+{
+	std::lock_guard<std::mutex> Guard(CacheLock);
+
+	Statistics.ResidentBytes = CountBytes(Textures) + CountBytes(Meshes) + CountBytes(Models) + CountBytes(Shaders);
+	return Statistics;
+}
+
+void AssetManager::PrintStatistics()
+{
+	AssetStatistics Current = GetStatistics();
+	double HitRate = Current.Requests > 0 ? 100.0 * (double)Current.Hits / (double)Current.Requests : 0.0;
+
+	printf("Assets: %llu requests, %llu hits (%.1f%%), %.2f MB saved, %.2f MB resident, %llu evicted\n",
+		Current.Requests, Current.Hits, HitRate,
+		Current.BytesSaved / (1024.0 * 1024.0), Current.ResidentBytes / (1024.0 * 1024.0), Current.Evictions);
+}
+
+AssetManager::~AssetManager()
+{
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "Texture.h"
+#include "Mesh.h"
+#include "Model.h"
+#include "Shader.h"
+
+// Shared cache for textures, meshes, models & shaders
+// Assets are keyed by canonical path plus whatever load parameters change the result (texture format,
+// shader defines), so asking for the same thing twice returns the same instance. Handles are shared_ptrs:
+// once only the cache holds an asset it stays resident for reuse until the budget forces it out,
+// least recently used first. Acquire* is thread safe, anything that creates or frees GL objects
+// (Load*, CollectGarbage, Clear) has to run on the context thread.
+class AssetManager
+{
+public:
+	struct AssetStatistics
+	{
+		unsigned long long Requests;
+		unsigned long long Hits;
+		unsigned long long Evictions;
+		size_t BytesSaved;			// Memory a duplicate load would have allocated
+		size_t ResidentBytes;
+	};
+
+	AssetManager();
+
+	// Returns the cached texture, or a new undecoded one with bOutCreated set so the caller loads it
+	std::shared_ptr<Texture> AcquireTexture(const std::string& Path, GLenum Format, bool* bOutCreated);
+	std::shared_ptr<Texture> LoadTexture(const std::string& Path, GLenum Format);
+
+	// Meshes built in code have no file, they are keyed by name
+	std::shared_ptr<Mesh> AcquireMesh(const std::string& Name, bool* bOutCreated);
+
+	// New models come back empty, the caller imports & uploads them (see Model::ImportModel)
+	std::shared_ptr<Model> AcquireModel(const std::string& Path, bool* bOutCreated);
+
+	std::shared_ptr<Shader> LoadShader(const std::string& VertexPath, const std::string& FragmentPath,
+		const std::string& GeometryPath, const std::string& Defines);
+	// Same cache entry as LoadShader, but a new program compiles in the background, see Shader::CreateFromFilesAsync
+	std::shared_ptr<Shader> LoadShaderAsync(const std::string& VertexPath, const std::string& FragmentPath,
+		const std::string& GeometryPath, const std::string& Defines);
+
+	// Unreferenced assets are evicted once everything cached takes more than this
+	void SetBudget(size_t NewBudgetBytes);
+	void CollectGarbage();
+	void Clear();
+
+	AssetStatistics GetStatistics();
+	void PrintStatistics();
+
+	~AssetManager();
+
+private:
+	template <typename T>
+	struct CacheEntry
+	{
+		std::shared_ptr<T> Asset;
+		unsigned long long LastUsed;
+	};
+
+	template <typename T>
+	using AssetCache = std::unordered_map<std::string, CacheEntry<T>>;
+
+	std::mutex CacheLock;
+	AssetCache<Texture> Textures;
+	AssetCache<Mesh> Meshes;
+	AssetCache<Model> Models;
+	AssetCache<Shader> Shaders;
+
+	size_t BudgetBytes;
+	unsigned long long UseCounter;
+	AssetStatistics Statistics;
+
+	// Arguments are forwarded to the constructor on a miss
+	template <typename T, typename... Args>
+	std::shared_ptr<T> Acquire(AssetCache<T>* Cache, const std::string& Key, bool* bOutCreated, Args&&... ConstructorArgs);
+
+	enum AssetType
+	{
+		ASSET_TEXTURE,
+		ASSET_MESH,
+		ASSET_MODEL,
+		ASSET_SHADER
+	};
+
+	struct EvictionCandidate
+	{
+		unsigned long long LastUsed;
+		size_t Bytes;
+		AssetType Type;
+		std::string Key;
+	};
+
+	template <typename T>
+	size_t CountBytes(const AssetCache<T>& Cache);
+
+	template <typename T>
+	void GatherUnused(const AssetCache<T>& Cache, AssetType Type, std::vector<EvictionCandidate>* OutCandidates);
+
+	static std::string MakeKey(const std::string& Path, const std::string& Parameters);
+	static std::string MakeShaderKey(const std::string& VertexPath, const std::string& FragmentPath,
+		const std::string& GeometryPath, const std::string& Defines);
+};
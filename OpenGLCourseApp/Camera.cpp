@@ -91,6 +91,17 @@ glm::vec3 Camera::GetCameraDirection()
 	return glm::normalize(Front);
 }
 
+Camera Camera::Interpolate(const Camera& From, const Camera& To, GLfloat Alpha)
+{
+	// Yaw isn't wrapped, so a plain blend never takes the long way round
+	Camera Result = To;
+	Result.Position = glm::mix(From.Position, To.Position, Alpha);
+	Result.Yaw = glm::mix(From.Yaw, To.Yaw, Alpha);
+	Result.Pitch = glm::mix(From.Pitch, To.Pitch, Alpha);
+	Result.Update();
+	return Result;
+}
+
 void Camera::Update()
 {
 	// Update Camera Vectors
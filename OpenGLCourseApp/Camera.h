@@ -21,6 +21,9 @@ public:
 
 	glm::mat4 CalculateViewMatrix();
 
+	// Camera between two simulation steps, Alpha 0 = From, 1 = To
+	static Camera Interpolate(const Camera& From, const Camera& To, GLfloat Alpha);
+
 private:
 	glm::vec3 Position;
 	glm::vec3 Front;
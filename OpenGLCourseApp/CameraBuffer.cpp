@@ -0,0 +1,43 @@
+#include "CameraBuffer.h"
+#include "GPUMemory.h"
+
+CameraBuffer::CameraBuffer()
+{
+	UBO = 0;
+}
+
+void CameraBuffer::Initialize()
+{
+	glGenBuffers(1, &UBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlockData), nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	GPUMemory::TrackAllocation(GPU_MEMORY_GEOMETRY, sizeof(CameraBlockData));
+}
+
+void CameraBuffer::Update(const CameraBlockData& Data)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlockData), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlockData), &Data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, UBO);
+}
+
+void CameraBuffer::Clear()
+{
+	if (UBO != 0)
+	{
+		glDeleteBuffers(1, &UBO);
+		UBO = 0;
+
+		GPUMemory::TrackRelease(GPU_MEMORY_GEOMETRY, sizeof(CameraBlockData));
+	}
+}
+
+CameraBuffer::~CameraBuffer()
+{
+	Clear();
+}
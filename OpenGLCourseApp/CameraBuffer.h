@@ -0,0 +1,36 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <GLM/glm.hpp>
+
+#include "CommonValues.h"
+
+// std140 layout of CameraBlock in Shaders/camera.glsl
+struct CameraBlockData
+{
+	glm::mat4 View;
+	glm::mat4 Projection;
+	glm::vec4 EyePosition;			// w unused, pads the vec3
+};
+
+// Uniform buffer holding the main view's camera, bound at CAMERA_BLOCK_BINDING
+// Written once per frame as late as possible, right before the draws that read it,
+// so the view can include input that arrived after the frame was prepared.
+class CameraBuffer
+{
+public:
+	CameraBuffer();
+
+	void Initialize();
+
+	// Uploads & binds, the previous contents are orphaned so the GPU never stalls on an older frame still reading them
+	void Update(const CameraBlockData& Data);
+
+	void Clear();
+
+	~CameraBuffer();
+
+private:
+	GLuint UBO;
+};
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <GLM/gtc/type_ptr.hpp>
+
+#include "CommandBuffer.h"
+#include "Log.h"
+
+// Commands are padded so every one starts on an 8 byte boundary
+static const size_t CommandAlignment = 8;
+
+static size_t AlignCommandSize(size_t Size)
+{
+	return (Size + CommandAlignment - 1) & ~(CommandAlignment - 1);
+}
+
+CommandBuffer::CommandBuffer()
+{
+	Used = 0;
+	CommandCount = 0;
+}
+
+void CommandBuffer::Reset()
+{
+	Used = 0;
+	CommandCount = 0;
+}
+
+template <typename T>
+void CommandBuffer::Push(const T& Command)
+{
+	size_t Size = AlignCommandSize(sizeof(T));
+
+	// Only grows while warming up, Reset() keeps the capacity for the following frames
+	if (Used + Size > Memory.size())
+	{
+		Memory.resize((Memory.size() + Size) * 2);
+	}
+
+	memcpy(&Memory[Used], &Command, sizeof(T));
+	Used += Size;
+	CommandCount++;
+}
+
+void CommandBuffer::BindProgram(GLuint Program)
+{
+	Push(BindCommand{ COMMAND_BIND_PROGRAM, 0, Program, 0 });
+}
+
+void CommandBuffer::BindVertexArray(GLuint VAO)
+{
+	Push(BindCommand{ COMMAND_BIND_VERTEX_ARRAY, 0, VAO, 0 });
+}
+
+void CommandBuffer::BindTexture(GLenum TextureUnit, GLenum Target, GLuint TextureID)
+{
+	Push(BindCommand{ COMMAND_BIND_TEXTURE, Target, TextureID, TextureUnit });
+}
+
+void CommandBuffer::BindUniformBufferRange(GLuint BindingIndex, GLuint Buffer, GLintptr Offset, GLsizeiptr Size)
+{
+	Push(BufferRangeCommand{ COMMAND_BIND_UNIFORM_BUFFER_RANGE, BindingIndex, Buffer, Offset, Size });
+}
+
+void CommandBuffer::SetUniform1i(GLuint Location, GLint Value)
+{
+	Push(UniformIntCommand{ COMMAND_UNIFORM_1I, Location, Value });
+}
+
+void CommandBuffer::SetUniform1f(GLuint Location, GLfloat Value)
+{
+	Push(UniformFloatCommand{ COMMAND_UNIFORM_1F, Location, { Value, 0.0f, 0.0f } });
+}
+
+void CommandBuffer::SetUniform3f(GLuint Location, const glm::vec3& Value)
+{
+	Push(UniformFloatCommand{ COMMAND_UNIFORM_3F, Location, { Value.x, Value.y, Value.z } });
+}
+
+void CommandBuffer::SetUniformMatrix4(GLuint Location, const glm::mat4& Value)
+{
+	Push(UniformMatrixCommand{ COMMAND_UNIFORM_MATRIX_4, Location, Value });
+}
+
+void CommandBuffer::DrawElements(GLenum Mode, GLsizei Count, GLenum IndexType)
+{
+	Push(DrawCommand{ COMMAND_DRAW_ELEMENTS, Mode, Count, IndexType });
+}
+
+void CommandBuffer::Execute()
+{
+	// Skip binds that wouldn't change anything, sub-meshes of a model often share a texture
+	GLuint CurrentProgram = 0;
+	GLuint CurrentVAO = 0;
+	GLenum CurrentUnit = 0;
+	GLuint CurrentTexture = 0;
+
+	size_t Offset = 0;
+	while (Offset < Used)
+	{
+		const unsigned char* Command = &Memory[Offset];
+
+		switch (*reinterpret_cast<const CommandType*>(Command))
+		{
+		case COMMAND_BIND_PROGRAM:
+		{
+			const BindCommand* Bind = reinterpret_cast<const BindCommand*>(Command);
+			if (Bind->Name != CurrentProgram)
+			{
+				glUseProgram(Bind->Name);
+				CurrentProgram = Bind->Name;
+			}
+			Offset += AlignCommandSize(sizeof(BindCommand));
+			break;
+		}
+		case COMMAND_BIND_VERTEX_ARRAY:
+		{
+			const BindCommand* Bind = reinterpret_cast<const BindCommand*>(Command);
+			if (Bind->Name != CurrentVAO)
+			{
+				glBindVertexArray(Bind->Name);
+				CurrentVAO = Bind->Name;
+			}
+			Offset += AlignCommandSize(sizeof(BindCommand));
+			break;
+		}
+		case COMMAND_BIND_TEXTURE:
+		{
+			const BindCommand* Bind = reinterpret_cast<const BindCommand*>(Command);
+			if (Bind->Unit != CurrentUnit || Bind->Name != CurrentTexture)
+			{
+				glActiveTexture(Bind->Unit);
+				glBindTexture(Bind->Target, Bind->Name);
+				CurrentUnit = Bind->Unit;
+				CurrentTexture = Bind->Name;
+			}
+			Offset += AlignCommandSize(sizeof(BindCommand));
+			break;
+		}
+		case COMMAND_BIND_UNIFORM_BUFFER_RANGE:
+		{
+			const BufferRangeCommand* Range = reinterpret_cast<const BufferRangeCommand*>(Command);
+			glBindBufferRange(GL_UNIFORM_BUFFER, Range->BindingIndex, Range->Buffer, Range->Offset, Range->Size);
+			Offset += AlignCommandSize(sizeof(BufferRangeCommand));
+			break;
+		}
+		case COMMAND_UNIFORM_1I:
+		{
+			const UniformIntCommand* Uniform = reinterpret_cast<const UniformIntCommand*>(Command);
+			glUniform1i(Uniform->Location, Uniform->Value);
+			Offset += AlignCommandSize(sizeof(UniformIntCommand));
+			break;
+		}
+		case COMMAND_UNIFORM_1F:
+		{
+			const UniformFloatCommand* Uniform = reinterpret_cast<const UniformFloatCommand*>(Command);
+			glUniform1f(Uniform->Location, Uniform->Value[0]);
+			Offset += AlignCommandSize(sizeof(UniformFloatCommand));
+			break;
+		}
+		case COMMAND_UNIFORM_3F:
+		{
+			const UniformFloatCommand* Uniform = reinterpret_cast<const UniformFloatCommand*>(Command);
+			glUniform3f(Uniform->Location, Uniform->Value[0], Uniform->Value[1], Uniform->Value[2]);
+			Offset += AlignCommandSize(sizeof(UniformFloatCommand));
+			break;
+		}
+		case COMMAND_UNIFORM_MATRIX_4:
+		{
+			const UniformMatrixCommand* Uniform = reinterpret_cast<const UniformMatrixCommand*>(Command);
+			glUniformMatrix4fv(Uniform->Location, 1, GL_FALSE, glm::value_ptr(Uniform->Value));
+			Offset += AlignCommandSize(sizeof(UniformMatrixCommand));
+			break;
+		}
+		case COMMAND_DRAW_ELEMENTS:
+		{
+			const DrawCommand* Draw = reinterpret_cast<const DrawCommand*>(Command);
+			glDrawElements(Draw->Mode, Draw->Count, Draw->IndexType, 0);
+			Offset += AlignCommandSize(sizeof(DrawCommand));
+			break;
+		}
+		default:
+			LOG_ERROR("Unknown render command at offset %zu!", Offset);
+			return;
+		}
+	}
+
+	// Leave the VAO unbound like Mesh::RenderMesh does
+	glBindVertexArray(0);
+}
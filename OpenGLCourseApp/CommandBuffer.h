@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <GLM/glm.hpp>
+
+// Recorded GL work, so draw generation can run on worker threads
+// Commands are packed back to back into one linear block of memory. Reset() rewinds the block
+// but keeps its capacity, so after the first few frames recording never allocates.
+// Each recording thread owns its buffer, only Execute() touches GL & must run on the context thread.
+class CommandBuffer
+{
+public:
+	CommandBuffer();
+
+	void Reset();
+
+	void BindProgram(GLuint Program);
+	void BindVertexArray(GLuint VAO);
+	void BindTexture(GLenum TextureUnit, GLenum Target, GLuint TextureID);
+	void BindUniformBufferRange(GLuint BindingIndex, GLuint Buffer, GLintptr Offset, GLsizeiptr Size);
+	void SetUniform1i(GLuint Location, GLint Value);
+	void SetUniform1f(GLuint Location, GLfloat Value);
+	void SetUniform3f(GLuint Location, const glm::vec3& Value);
+	void SetUniformMatrix4(GLuint Location, const glm::mat4& Value);
+	void DrawElements(GLenum Mode, GLsizei Count, GLenum IndexType);
+
+	// Replays every recorded command in order
+	void Execute();
+
+	size_t GetCommandCount() { return CommandCount; }
+	size_t GetUsedBytes() { return Used; }
+
+private:
+	enum CommandType : GLuint
+	{
+		COMMAND_BIND_PROGRAM,
+		COMMAND_BIND_VERTEX_ARRAY,
+		COMMAND_BIND_TEXTURE,
+		COMMAND_BIND_UNIFORM_BUFFER_RANGE,
+		COMMAND_UNIFORM_1I,
+		COMMAND_UNIFORM_1F,
+		COMMAND_UNIFORM_3F,
+		COMMAND_UNIFORM_MATRIX_4,
+		COMMAND_DRAW_ELEMENTS
+	};
+
+	// Every command starts with its type so Execute() can switch on it
+	struct BindCommand { CommandType Type; GLenum Target; GLuint Name; GLenum Unit; };
+	struct BufferRangeCommand { CommandType Type; GLuint BindingIndex; GLuint Buffer; GLintptr Offset; GLsizeiptr Size; };
+	struct UniformIntCommand { CommandType Type; GLuint Location; GLint Value; };
+	struct UniformFloatCommand { CommandType Type; GLuint Location; GLfloat Value[3]; };
+	struct UniformMatrixCommand { CommandType Type; GLuint Location; glm::mat4 Value; };
+	struct DrawCommand { CommandType Type; GLenum Mode; GLsizei Count; GLenum IndexType; };
+
+	std::vector<unsigned char> Memory;
+	size_t Used;
+	size_t CommandCount;
+
+	template <typename T>
+	void Push(const T& Command);
+};
@@ -6,4 +6,7 @@
 const int MAX_POINT_LIGHTS = 3;	
 const int MAX_SPOT_LIGHTS = 3;
 
+// Uniform buffer binding points shared by every program
+const unsigned int CAMERA_BLOCK_BINDING = 0;
+
 #endif
\ No newline at end of file
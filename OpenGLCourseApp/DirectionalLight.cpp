@@ -1,4 +1,5 @@
 #include "DirectionalLight.h"
+#include "Shader.h"
 
 DirectionalLight::DirectionalLight() : Light()
 {
@@ -22,13 +23,13 @@ DirectionalLight::~DirectionalLight()
 }
 
 // These uniforms pass the values into the bound ID in the shader
-void DirectionalLight::UseLight(GLuint AmbientIntensityLocation, GLuint AmbientColorLocation,
-								GLuint DiffuseIntensityLocation, GLuint DirectionLocation)
+void DirectionalLight::UseLight(Shader* TheShader, UniformHandle AmbientIntensityHandle, UniformHandle AmbientColorHandle,
+								UniformHandle DiffuseIntensityHandle, UniformHandle DirectionHandle)
 {
-	glUniform3f(AmbientColorLocation, Color.x, Color.y, Color.z);
-	glUniform1f(AmbientIntensityLocation, AmbientIntensity);
-	glUniform3f(DirectionLocation, Direction.x, Direction.y, Direction.z);
-	glUniform1f(DiffuseIntensityLocation, DiffuseIntensity);
+	TheShader->SetUniform(AmbientColorHandle, Color);
+	TheShader->SetUniform(AmbientIntensityHandle, AmbientIntensity);
+	TheShader->SetUniform(DirectionHandle, Direction);
+	TheShader->SetUniform(DiffuseIntensityHandle, DiffuseIntensity);
 }
 
 glm::mat4 DirectionalLight::CalculateLightTransform()
@@ -10,9 +10,9 @@ public:
 					GLfloat Intensity, GLfloat NewDiffuseIntensity,
 					GLfloat DirX, GLfloat DirY, GLfloat DirZ);
 
-	// Bind light values for use in the shader (Location here meaning the ID in the shader, not a position)
-	void UseLight(GLuint AmbientIntensityLocation, GLuint AmbientColorLocation,
-		GLuint DiffuseIntensityLocation, GLuint DirectionLocation);
+	// Set light values on the shader in use, through its cached setters
+	void UseLight(Shader* TheShader, UniformHandle AmbientIntensityHandle, UniformHandle AmbientColorHandle,
+		UniformHandle DiffuseIntensityHandle, UniformHandle DirectionHandle);
 
 	glm::mat4 CalculateLightTransform();
 
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cmath>
+
+#include "DynamicResolution.h"
+#include "Log.h"
+
+// Scale changes in steps, a size is kept for a while instead of being nudged every frame
+static const float ScaleStep = 0.05f;
+
+// Hysteresis band around the target: drop above the upper edge, consider growing only below the lower one
+static const double OverBudgetRatio = 1.05;
+static const double HeadroomRatio = 0.85;
+
+// Frames of headroom before a step up, & frames ignored after a change while queries still time the old size
+static const unsigned int HeadroomFramesToGrow = 30;
+static const unsigned int FramesToSettle = 8;
+
+// Weight of the newest sample in the smoothed GPU time
+static const double Smoothing = 0.1;
+
+DynamicResolution::DynamicResolution()
+{
+	TargetMilliseconds = 16.0;
+	MinScale = 0.5f;
+	MaxScale = 1.0f;
+	Scale = 1.0f;
+	bEnabled = true;
+
+	SmoothedMilliseconds = 0.0;
+	HeadroomFrames = 0;
+	SettleFrames = 0;
+}
+
+void DynamicResolution::Initialize(double NewTargetMilliseconds, float NewMinScale, float NewMaxScale)
+{
+	TargetMilliseconds = NewTargetMilliseconds;
+	MinScale = NewMinScale;
+	MaxScale = NewMaxScale;
+	Scale = MaxScale;
+
+	Queries.Initialize(GL_TIME_ELAPSED);
+}
+
+void DynamicResolution::BeginFrame()
+{
+	Queries.Begin();
+}
+
+void DynamicResolution::EndFrame()
+{
+	Queries.End(0.0);
+
+	GLuint64 Nanoseconds = 0;
+	double Work = 0.0;
+	while (Queries.ReadResult(&Nanoseconds, &Work))
+	{
+		Adjust(Nanoseconds / 1000000.0);
+	}
+}
+
+void DynamicResolution::SetEnabled(bool bNewEnabled)
+{
+	bEnabled = bNewEnabled;
+	if (!bEnabled)
+	{
+		SetScale(MaxScale);
+	}
+	LOG_INFO("Dynamic resolution %s", bEnabled ? "on" : "off");
+}
+
+GLsizei DynamicResolution::ScaleSize(GLsizei FullSize) const
+{
+	return std::max((GLsizei)1, (GLsizei)std::lround(FullSize * Scale));
+}
+
+void DynamicResolution::Adjust(double FrameMilliseconds)
+{
+	SmoothedMilliseconds = SmoothedMilliseconds > 0.0 ? SmoothedMilliseconds + (FrameMilliseconds - SmoothedMilliseconds) * Smoothing : FrameMilliseconds;
+
+	if (!bEnabled)
+	{
+		return;
+	}
+
+	if (SettleFrames > 0)
+	{
+		SettleFrames--;
+		return;
+	}
+
+	// Cost is taken to follow the pixel count, so the scale goes with the square root of the time
+	if (SmoothedMilliseconds > TargetMilliseconds * OverBudgetRatio)
+	{
+		float Fit = Scale * (float)std::sqrt(TargetMilliseconds * HeadroomRatio / SmoothedMilliseconds);
+		SetScale(std::floor(Fit / ScaleStep + 0.001f) * ScaleStep);
+		HeadroomFrames = 0;
+	}
+	else if (SmoothedMilliseconds < TargetMilliseconds * HeadroomRatio && Scale < MaxScale)
+	{
+		// Only grow when the next size up is predicted to stay inside the band too
+		float Grown = std::min(Scale + ScaleStep, MaxScale);
+		double Predicted = SmoothedMilliseconds * (Grown * Grown) / (Scale * Scale);
+		HeadroomFrames = Predicted < TargetMilliseconds ? HeadroomFrames + 1 : 0;
+		if (HeadroomFrames >= HeadroomFramesToGrow)
+		{
+			SetScale(Grown);
+			HeadroomFrames = 0;
+		}
+	}
+	else
+	{
+		HeadroomFrames = 0;
+	}
+}
+
+void DynamicResolution::SetScale(float NewScale)
+{
+	NewScale = std::min(std::max(NewScale, MinScale), MaxScale);
+	if (NewScale == Scale)
+	{
+		return;
+	}
+
+	// Assume the cost scales with the pixels until the queries catch up
+	if (SmoothedMilliseconds > 0.0)
+	{
+		SmoothedMilliseconds *= (NewScale * NewScale) / (Scale * Scale);
+	}
+	Scale = NewScale;
+	SettleFrames = FramesToSettle;
+
+	LOG_DEBUG("Resolution scale %.2f", Scale);
+}
+
+void DynamicResolution::Clear()
+{
+	Queries.Clear();
+}
+
+DynamicResolution::~DynamicResolution()
+{
+}
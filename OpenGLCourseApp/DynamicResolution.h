@@ -0,0 +1,52 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "GPUQueryRing.h"
+
+// Main pass resolution scale that holds a GPU frame time target
+// GPU time is measured with GL_TIME_ELAPSED queries read back a few frames late, never stalling on a result.
+// Over budget the scale drops straight to the size predicted to fit, with headroom it only climbs one step
+// after a run of frames that would still fit at the larger size, so it settles instead of hunting.
+class DynamicResolution
+{
+public:
+	DynamicResolution();
+
+	// Milliseconds of GPU time per frame to aim for, & the range the scale may move in (fractions of full size)
+	void Initialize(double NewTargetMilliseconds, float NewMinScale, float NewMaxScale);
+
+	// Bracket all of a frame's GL work, EndFrame() also reads finished queries & adjusts the scale
+	void BeginFrame();
+	void EndFrame();
+
+	// Disabled, the scale stays at the maximum but the GPU time is still measured
+	void SetEnabled(bool bNewEnabled);
+	bool IsEnabled() const { return bEnabled; }
+
+	float GetScale() const { return Scale; }
+	GLsizei ScaleSize(GLsizei FullSize) const;
+
+	// Smoothed GPU time of recent frames, 0 until the first query returns
+	double GetGPUMilliseconds() const { return SmoothedMilliseconds; }
+
+	void Clear();
+
+	~DynamicResolution();
+
+private:
+	GPUQueryRing Queries;
+
+	double TargetMilliseconds;
+	float MinScale;
+	float MaxScale;
+	float Scale;
+	bool bEnabled;
+
+	double SmoothedMilliseconds;
+	unsigned int HeadroomFrames;
+	unsigned int SettleFrames;
+
+	void Adjust(double FrameMilliseconds);
+	void SetScale(float NewScale);
+};
@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "FrameAllocator.h"
+
+// Counts every general heap allocation in the process, the two functions below are the only places it changes
+// Every replaceable global new ends up in one of them: plain, array, nothrow & over-aligned alike
+static std::atomic<unsigned long long> HeapAllocations{ 0 };
+
+static void* CountedAllocate(size_t Size)
+{
+	HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+	return malloc(Size > 0 ? Size : 1);
+}
+
+static void* CountedAllocateAligned(size_t Size, std::align_val_t Alignment)
+{
+	HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+
+	// aligned_alloc wants the size a multiple of the alignment, MSVC has no aligned_alloc & frees these apart
+	size_t Align = (size_t)Alignment;
+	size_t Rounded = ((Size > 0 ? Size : 1) + Align - 1) & ~(Align - 1);
+#ifdef _WIN32
+	return _aligned_malloc(Rounded, Align);
+#else
+	return aligned_alloc(Align, Rounded);
+#endif
+}
+
+static void FreeAligned(void* Pointer)
+{
+#ifdef _WIN32
+	_aligned_free(Pointer);
+#else
+	free(Pointer);
+#endif
+}
+
+void* operator new(size_t Size)
+{
+	void* Pointer = CountedAllocate(Size);
+	if (!Pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return Pointer;
+}
+
+void* operator new[](size_t Size)
+{
+	return operator new(Size);
+}
+
+void* operator new(size_t Size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(Size);
+}
+
+void* operator new[](size_t Size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(Size);
+}
+
+void* operator new(size_t Size, std::align_val_t Alignment)
+{
+	void* Pointer = CountedAllocateAligned(Size, Alignment);
+	if (!Pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return Pointer;
+}
+
+void* operator new[](size_t Size, std::align_val_t Alignment)
+{
+	return operator new(Size, Alignment);
+}
+
+void* operator new(size_t Size, std::align_val_t Alignment, const std::nothrow_t&) noexcept
+{
+	return CountedAllocateAligned(Size, Alignment);
+}
+
+void* operator new[](size_t Size, std::align_val_t Alignment, const std::nothrow_t&) noexcept
+{
+	return CountedAllocateAligned(Size, Alignment);
+}
+
+void operator delete(void* Pointer) noexcept
+{
+	free(Pointer);
+}
+
+void operator delete[](void* Pointer) noexcept
+{
+	free(Pointer);
+}
+
+void operator delete(void* Pointer, size_t) noexcept
+{
+	free(Pointer);
+}
+
+void operator delete[](void* Pointer, size_t) noexcept
+{
+	free(Pointer);
+}
+
+void operator delete(void* Pointer, const std::nothrow_t&) noexcept
+{
+	free(Pointer);
+}
+
+void operator delete[](void* Pointer, const std::nothrow_t&) noexcept
+{
+	free(Pointer);
+}
+
+void operator delete(void* Pointer, std::align_val_t) noexcept
+{
+	FreeAligned(Pointer);
+}
+
+void operator delete[](void* Pointer, std::align_val_t) noexcept
+{
+	FreeAligned(Pointer);
+}
+
+void operator delete(void* Pointer, size_t, std::align_val_t) noexcept
+{
+	FreeAligned(Pointer);
+}
+
+void operator delete[](void* Pointer, size_t, std::align_val_t) noexcept
+{
+	FreeAligned(Pointer);
+}
+
+void operator delete(void* Pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	FreeAligned(Pointer);
+}
+
+void operator delete[](void* Pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	FreeAligned(Pointer);
+}
+
+LinearArena::LinearArena()
+{
+	Memory = nullptr;
+	Capacity = 0;
+	Offset = 0;
+	Peak = 0;
+	Overflows = 0;
+}
+
+void LinearArena::Initialize(size_t NewCapacity)
+{
+	Reset();
+	delete[] Memory;
+
+	Memory = new unsigned char[NewCapacity];
+	Capacity = NewCapacity;
+}
+
+void LinearArena::Reset()
+{
+	size_t Used = GetUsed();
+	Peak = Used > Peak ? Used : Peak;
+	Offset.store(0, std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> Guard(OverflowLock);
+	for (size_t i = 0; i < OverflowBlocks.size(); i++)
+	{
+		std::pmr::new_delete_resource()->deallocate(OverflowBlocks[i].Pointer, OverflowBlocks[i].Bytes, OverflowBlocks[i].Alignment);
+	}
+	OverflowBlocks.clear();
+}
+
+size_t LinearArena::GetUsed() const
+{
+	size_t Used = Offset.load(std::memory_order_relaxed);
+	return Used < Capacity ? Used : Capacity;
+}
+
+void* LinearArena::do_allocate(size_t Bytes, size_t Alignment)
+{
+	// Reserve enough for the worst case padding, then align inside the reservation
+	size_t Start = Offset.fetch_add(Bytes + Alignment - 1, std::memory_order_relaxed);
+	if (Start + Bytes + Alignment - 1 <= Capacity)
+	{
+		uintptr_t Address = reinterpret_cast<uintptr_t>(Memory + Start);
+		Address = (Address + Alignment - 1) & ~(uintptr_t)(Alignment - 1);
+		return reinterpret_cast<void*>(Address);
+	}
+
+	Overflows.fetch_add(1, std::memory_order_relaxed);
+
+	void* Pointer = std::pmr::new_delete_resource()->allocate(Bytes, Alignment);
+	std::lock_guard<std::mutex> Guard(OverflowLock);
+	OverflowBlocks.push_back({ Pointer, Bytes, Alignment });
+	return Pointer;
+}
+
+void LinearArena::do_deallocate(void*, size_t, size_t)
+{
+	// Everything goes at once in Reset()
+}
+
+bool LinearArena::do_is_equal(const std::pmr::memory_resource& Other) const noexcept
+{
+	return this == &Other;
+}
+
+LinearArena::~LinearArena()
+{
+	Reset();
+	delete[] Memory;
+}
+
+FrameAllocator::FrameAllocator()
+{
+	CurrentArena = 0;
+}
+
+void FrameAllocator::Initialize(size_t BytesPerFrame)
+{
+	Arenas[0].Initialize(BytesPerFrame);
+	Arenas[1].Initialize(BytesPerFrame);
+	CurrentArena = 0;
+}
+
+void FrameAllocator::BeginFrame()
+{
+	CurrentArena ^= 1;
+	Arenas[CurrentArena].Reset();
+}
+
+unsigned long long FrameAllocator::GetHeapAllocationCount()
+{
+	return HeapAllocations.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+// Bump allocator for memory that lives no longer than a frame, usable as a std::pmr resource
+// Allocation is a single atomic add, so jobs may allocate concurrently. Nothing is freed individually,
+// Reset() releases everything at once. Running out of space falls back to the heap (counted as overflows)
+// rather than failing, raise the capacity if that ever shows up in steady state.
+class LinearArena : public std::pmr::memory_resource
+{
+public:
+	LinearArena();
+
+	void Initialize(size_t NewCapacity);
+	void Reset();
+
+	size_t GetUsed() const;
+	size_t GetCapacity() const { return Capacity; }
+	size_t GetPeak() const { return Peak; }
+	unsigned long long GetOverflowCount() const { return Overflows.load(std::memory_order_relaxed); }
+
+	// Uninitialized storage for Count trivially destructible objects
+	template <typename T>
+	T* Allocate(size_t Count)
+	{
+		return static_cast<T*>(allocate(sizeof(T) * Count, alignof(T)));
+	}
+
+	~LinearArena();
+
+protected:
+	void* do_allocate(size_t Bytes, size_t Alignment) override;
+	void do_deallocate(void* Pointer, size_t Bytes, size_t Alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& Other) const noexcept override;
+
+private:
+	struct OverflowBlock
+	{
+		void* Pointer;
+		size_t Bytes;
+		size_t Alignment;
+	};
+
+	unsigned char* Memory;
+	size_t Capacity;
+	std::atomic<size_t> Offset;
+	size_t Peak;
+
+	std::atomic<unsigned long long> Overflows;
+	std::mutex OverflowLock;
+	std::vector<OverflowBlock> OverflowBlocks;
+};
+
+// Two arenas used on alternate frames: memory from frame N stays valid through frame N + 1,
+// so data handed to the next frame (or still read by the GPU thread) survives one swap
+class FrameAllocator
+{
+public:
+	FrameAllocator();
+
+	void Initialize(size_t BytesPerFrame);
+
+	// Switches to the other arena & resets it, call once at the start of every frame
+	void BeginFrame();
+
+	LinearArena* GetArena() { return &Arenas[CurrentArena]; }
+
+	// Uninitialized storage for Count trivially destructible objects
+	template <typename T>
+	T* Allocate(size_t Count)
+	{
+		return Arenas[CurrentArena].Allocate<T>(Count);
+	}
+
+	// Calls to the global operator new since startup, diff it around a frame to find stray heap allocations
+	static unsigned long long GetHeapAllocationCount();
+
+private:
+	LinearArena Arenas[2];
+	unsigned int CurrentArena;
+};
@@ -0,0 +1,151 @@
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+#include <GLFW/glfw3.h>
+
+#include "FramePacer.h"
+#include "Log.h"
+#include "Profiler.h"
+
+// Spin margin limits, the margin grows straight to a bad overshoot & shrinks back slowly
+// Capped so a coarse timer (e.g. the 1ms period wasn't granted) costs a late frame now & then, not a core spinning every frame
+static const double MinSpinMargin = 0.0005;
+static const double MaxSpinMargin = 0.002;
+
+FramePacer::FramePacer()
+{
+	Mode = VSYNC_ON;
+	FrameLimit = 0.0;
+	FrameSeconds = 0.0;
+	NextFrameTime = 0.0;
+	SpinMargin = 0.002;
+	bFineTimer = false;
+}
+
+void FramePacer::SetVSync(VSyncMode NewMode)
+{
+	// Negative intervals need the swap_control_tear extensions
+	if (NewMode == VSYNC_ADAPTIVE &&
+		!glfwExtensionSupported("WGL_EXT_swap_control_tear") && !glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+	{
+		LOG_WARNING("Adaptive vsync isn't supported by this driver, using vsync on");
+		NewMode = VSYNC_ON;
+	}
+
+	Mode = NewMode;
+	glfwSwapInterval(Mode == VSYNC_OFF ? 0 : (Mode == VSYNC_ON ? 1 : -1));
+
+	LOG_INFO("VSync %s", GetVSyncName(Mode));
+}
+
+void FramePacer::SetFrameLimit(double FramesPerSecond)
+{
+	FrameLimit = FramesPerSecond > 0.0 ? FramesPerSecond : 0.0;
+	FrameSeconds = FrameLimit > 0.0 ? 1.0 / FrameLimit : 0.0;
+	SetFineTimer(FrameLimit > 0.0);
+	Reset();
+}
+
+void FramePacer::SetFineTimer(bool bEnable)
+{
+	if (bEnable == bFineTimer)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	// Sleeps otherwise round up to the system timer tick, overshooting a 60 FPS cap by about a frame
+	// It's a system wide setting that costs power, so it's only held while a cap is on
+	if (bEnable)
+	{
+		if (timeBeginPeriod(1) != TIMERR_NOERROR)
+		{
+			LOG_WARNING("1ms timer period not granted, the frame limit will be coarser");
+		}
+	}
+	else
+	{
+		timeEndPeriod(1);
+	}
+#endif
+	bFineTimer = bEnable;
+}
+
+void FramePacer::WaitForNextFrame()
+{
+	if (FrameSeconds <= 0.0)
+	{
+		return;
+	}
+
+	PROFILE_SCOPE("FramePacer::WaitForNextFrame");
+
+	double Now = glfwGetTime();
+
+	// More than a frame late, start a new schedule rather than rushing short frames to catch up
+	if (NextFrameTime == 0.0 || Now - NextFrameTime > FrameSeconds)
+	{
+		NextFrameTime = Now + FrameSeconds;
+		return;
+	}
+
+	// Sleep in small steps while the deadline is far enough away to absorb an overshoot
+	while (NextFrameTime - Now > SpinMargin)
+	{
+		double BeforeSleep = Now;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		Now = glfwGetTime();
+
+		double Overshoot = (Now - BeforeSleep) - 0.001;
+		if (Overshoot > SpinMargin)
+		{
+			SpinMargin = Overshoot < MaxSpinMargin ? Overshoot : MaxSpinMargin;
+		}
+		else
+		{
+			SpinMargin = SpinMargin * 0.99 > MinSpinMargin ? SpinMargin * 0.99 : MinSpinMargin;
+		}
+	}
+
+	while (Now < NextFrameTime)
+	{
+		std::this_thread::yield();
+		Now = glfwGetTime();
+	}
+
+	// Schedule from the deadline, not from now, so small wake up errors don't add up
+	NextFrameTime += FrameSeconds;
+}
+
+void FramePacer::Reset()
+{
+	NextFrameTime = 0.0;
+}
+
+FramePacer::~FramePacer()
+{
+	SetFineTimer(false);
+}
+
+const char* FramePacer::GetVSyncName(VSyncMode Mode)
+{
+	switch (Mode)
+	{
+	case VSYNC_OFF:
+		return "off";
+	case VSYNC_ON:
+		return "on";
+	case VSYNC_ADAPTIVE:
+		return "adaptive";
+	default:
+		return "unknown";
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+enum VSyncMode
+{
+	VSYNC_OFF = 0,
+	VSYNC_ON,
+	VSYNC_ADAPTIVE,			// Syncs when on time, tears instead of waiting a whole refresh when late
+	VSYNC_MODE_COUNT
+};
+
+// Swap interval & frame rate cap for the GL thread
+// The limiter sleeps while the deadline is far off, then spins for the last stretch, since a sleep
+// can overshoot by a millisecond or more. The spin margin tracks how much recent sleeps overshot.
+// On Windows the system timer is raised to 1ms while a cap is set, sleeps round up to ~15.6ms otherwise.
+class FramePacer
+{
+public:
+	FramePacer();
+
+	// Needs the GL context current, swap interval is per context
+	void SetVSync(VSyncMode NewMode);
+	VSyncMode GetVSync() { return Mode; }
+
+	// Frames per second, 0 = uncapped
+	void SetFrameLimit(double FramesPerSecond);
+	double GetFrameLimit() { return FrameLimit; }
+
+	// Blocks until the next frame may start, call at the top of the frame before sampling input
+	void WaitForNextFrame();
+
+	// Forget the schedule, e.g. after idling, so the next frame doesn't count the idle time as lateness
+	void Reset();
+
+	static const char* GetVSyncName(VSyncMode Mode);
+
+	~FramePacer();
+
+private:
+	VSyncMode Mode;
+	double FrameLimit;
+	double FrameSeconds;
+	double NextFrameTime;
+	double SpinMargin;			// Seconds left on the clock when sleeping stops & spinning starts
+	bool bFineTimer;			// Holding a 1ms system timer period
+
+	void SetFineTimer(bool bEnable);
+};
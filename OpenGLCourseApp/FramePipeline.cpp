@@ -0,0 +1,174 @@
+#include "FramePipeline.h"
+#include "Profiler.h"
+#include "Log.h"
+
+#include <GLFW/glfw3.h>
+
+FramePipeline::FramePipeline()
+{
+	Depth = 2;
+	WriteIndex = 0;
+	ReadIndex = 0;
+	InFlight = 0;
+	Queued = 0;
+	PacketsWritten = 0;
+	bStopped = false;
+	WritingPacket = nullptr;
+	ReadingPacket = nullptr;
+}
+
+void FramePipeline::Initialize(unsigned int NewDepth, size_t BytesPerPacket)
+{
+	Depth = NewDepth < 1 ? 1 : (NewDepth > MaxDepth ? MaxDepth : NewDepth);
+
+	for (unsigned int i = 0; i < Depth; i++)
+	{
+		Packets[i].Memory.Initialize(BytesPerPacket);
+	}
+}
+
+FramePacket* FramePipeline::BeginWrite()
+{
+	PROFILE_SCOPE("FramePipeline::BeginWrite");
+
+	std::unique_lock<std::mutex> Guard(Lock);
+	PacketReleased.wait(Guard, [this]() { return bStopped || InFlight < Depth; });
+	if (bStopped)
+	{
+		return nullptr;
+	}
+
+	InFlight++;
+	FramePacket* Packet = &Packets[WriteIndex];
+	WriteIndex = (WriteIndex + 1) % Depth;
+	WritingPacket = Packet;
+	Guard.unlock();
+
+	// Nothing else can see this packet until EndWrite
+	Packet->FrameNumber = PacketsWritten++;
+	Packet->Requests = 0;
+	Packet->Memory.Reset();
+	return Packet;
+}
+
+void FramePipeline::EndWrite(FramePacket* Packet)
+{
+	{
+		std::lock_guard<std::mutex> Guard(Lock);
+
+		// Packets are consumed in the order they were handed out, the count still has to move on
+		if (Packet != WritingPacket)
+		{
+			LOG_ERROR("FramePipeline::EndWrite was given a packet BeginWrite didn't hand out!");
+		}
+		WritingPacket = nullptr;
+		Queued++;
+	}
+	PacketWritten.notify_one();
+}
+
+FramePacket* FramePipeline::BeginRead()
+{
+	PROFILE_SCOPE("FramePipeline::BeginRead");
+
+	std::unique_lock<std::mutex> Guard(Lock);
+	PacketWritten.wait(Guard, [this]() { return bStopped || Queued > 0; });
+	if (bStopped)
+	{
+		return nullptr;
+	}
+
+	Queued--;
+	FramePacket* Packet = &Packets[ReadIndex];
+	ReadIndex = (ReadIndex + 1) % Depth;
+	ReadingPacket = Packet;
+	return Packet;
+}
+
+void FramePipeline::EndRead(FramePacket* Packet)
+{
+	{
+		std::lock_guard<std::mutex> Guard(Lock);
+		if (Packet != ReadingPacket)
+		{
+			LOG_ERROR("FramePipeline::EndRead was given a packet BeginRead didn't hand out!");
+		}
+		ReadingPacket = nullptr;
+		InFlight--;
+	}
+	PacketReleased.notify_one();
+}
+
+void FramePipeline::Stop()
+{
+	{
+		std::lock_guard<std::mutex> Guard(Lock);
+		bStopped = true;
+	}
+	PacketWritten.notify_all();
+	PacketReleased.notify_all();
+}
+
+GPUFenceRing::GPUFenceRing()
+{
+	for (unsigned int i = 0; i < MaxFences; i++)
+	{
+		Fences[i] = nullptr;
+	}
+	FramesInFlight = 2;
+	Current = 0;
+}
+
+void GPUFenceRing::Initialize(unsigned int NewFramesInFlight)
+{
+	Clear();
+	FramesInFlight = NewFramesInFlight < 1 ? 1 : (NewFramesInFlight > MaxFences ? MaxFences : NewFramesInFlight);
+}
+
+double GPUFenceRing::WaitForSlot()
+{
+	GLsync Fence = Fences[Current];
+	if (!Fence)
+	{
+		return 0.0;
+	}
+
+	PROFILE_SCOPE("GPUFenceRing::WaitForSlot");
+
+	double Start = glfwGetTime();
+
+	// The flush makes sure the fence was actually submitted, or the wait could never end
+	GLenum Result = glClientWaitSync(Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	while (Result == GL_TIMEOUT_EXPIRED)
+	{
+		Result = glClientWaitSync(Fence, 0, 1000000);		// 1ms
+	}
+
+	glDeleteSync(Fence);
+	Fences[Current] = nullptr;
+
+	return (glfwGetTime() - Start) * 1000.0;
+}
+
+void GPUFenceRing::Signal()
+{
+	if (Fences[Current])
+	{
+		glDeleteSync(Fences[Current]);
+	}
+	Fences[Current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	Current = (Current + 1) % FramesInFlight;
+}
+
+void GPUFenceRing::Clear()
+{
+	for (unsigned int i = 0; i < MaxFences; i++)
+	{
+		if (Fences[i])
+		{
+			glDeleteSync(Fences[i]);
+			Fences[i] = nullptr;
+		}
+	}
+	Current = 0;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <GLM/glm.hpp>
+
+#include "CommonValues.h"
+#include "FrameAllocator.h"
+#include "FramePrep.h"
+#include "DirectionalLight.h"
+#include "PointLight.h"
+#include "SpotLight.h"
+#include "ShaderPermutations.h"
+
+// One-off actions raised by input on the simulation thread that have to run on the GL thread
+enum FrameRequest
+{
+	FRAME_REQUEST_MEMORY_REPORT = 1 << 0,
+	FRAME_REQUEST_PROFILE_CAPTURE = 1 << 1,
+	FRAME_REQUEST_CYCLE_VSYNC = 1 << 2,
+	FRAME_REQUEST_CYCLE_FRAME_LIMIT = 1 << 3,
+	FRAME_REQUEST_TOGGLE_DYNAMIC_RESOLUTION = 1 << 4,
+	FRAME_REQUEST_CYCLE_DEPTH_PREPASS = 1 << 5
+};
+
+// Everything the GL thread needs to draw one frame
+// Written by the simulation thread, read-only once it is queued. The GL thread never looks at the
+// live camera or lights, only at the copies in here, so the next frame can be simulated meanwhile.
+struct FramePacket
+{
+	unsigned long long FrameNumber;
+
+	// Transforms, light matrices & draw lists from PrepareFrame
+	FrameData Frame;
+	glm::vec3 EyePosition;
+
+	// The camera Frame.View came from & the input it had seen, for late latching on the GL thread
+	Camera ViewCamera;
+	double InputMouseTotalX;
+	double InputMouseTotalY;
+	double InputSampleTime;
+	bool bLateLatch;
+
+	// Lights as the simulation left them, the shadow maps themselves are shared & only touched by the GL thread
+	DirectionalLight MainLight;
+	PointLight PointLights[MAX_POINT_LIGHTS];
+	SpotLight SpotLights[MAX_SPOT_LIGHTS];
+	std::vector<PointLight*> OmniLights;			// Into the arrays above, in shadow index order
+
+	ShadowFilter ShadowQuality;
+	unsigned int Requests;							// FrameRequest flags
+
+	// On demand rendering only draws packets that differ from the last one
+	bool bSceneChanged;
+	bool bOnDemand;
+
+	// Per-frame arrays in Frame, reset when the packet is reused
+	LinearArena Memory;
+};
+
+// Fixed ring of frame packets between the simulation thread (producer) & the GL thread (consumer)
+// Packets are handed over in order. The producer blocks while every packet is queued or being drawn,
+// which caps how far the simulation runs ahead of rendering.
+class FramePipeline
+{
+public:
+	static const unsigned int MaxDepth = 3;
+
+	FramePipeline();
+
+	void Initialize(unsigned int NewDepth, size_t BytesPerPacket);
+
+	// Producer side, nullptr once the pipeline is stopped
+	// Each End* takes back the packet the matching Begin* handed out, anything else is reported as an error
+	FramePacket* BeginWrite();
+	void EndWrite(FramePacket* Packet);
+
+	// Consumer side, nullptr once the pipeline is stopped
+	FramePacket* BeginRead();
+	void EndRead(FramePacket* Packet);
+
+	// Wakes up both sides for shutdown
+	void Stop();
+
+private:
+	FramePacket Packets[MaxDepth];
+	unsigned int Depth;
+
+	std::mutex Lock;
+	std::condition_variable PacketWritten;
+	std::condition_variable PacketReleased;
+
+	unsigned int WriteIndex;
+	unsigned int ReadIndex;
+	unsigned int InFlight;			// Being written, queued or being drawn
+	unsigned int Queued;			// Written & not yet picked up
+	unsigned long long PacketsWritten;
+	bool bStopped;
+
+	// Each side holds at most one packet between Begin & End
+	FramePacket* WritingPacket;
+	FramePacket* ReadingPacket;
+};
+
+// Bounds how many frames the GPU may lag behind the GL thread
+// A fence goes in after each frame's commands, before submitting a new frame the GL thread waits
+// for the fence from MaxFramesInFlight frames ago. Without it the driver queues frames at will.
+class GPUFenceRing
+{
+public:
+	static const unsigned int MaxFences = 4;
+
+	GPUFenceRing();
+
+	void Initialize(unsigned int NewFramesInFlight);
+
+	// Blocks until the GPU finished the frame that used this slot, returns the time waited in ms
+	double WaitForSlot();
+	void Signal();
+
+	void Clear();
+
+private:
+	GLsync Fences[MaxFences];
+	unsigned int FramesInFlight;
+	unsigned int Current;
+};
@@ -0,0 +1,190 @@
+#include <algorithm>
+
+#include "FramePrep.h"
+#include "Profiler.h"
+
+Frustum ExtractFrustum(const glm::mat4& ViewProjection)
+{
+	// GLM is column-major, so each "row" is gathered across the columns
+	glm::vec4 Row0(ViewProjection[0][0], ViewProjection[1][0], ViewProjection[2][0], ViewProjection[3][0]);
+	glm::vec4 Row1(ViewProjection[0][1], ViewProjection[1][1], ViewProjection[2][1], ViewProjection[3][1]);
+	glm::vec4 Row2(ViewProjection[0][2], ViewProjection[1][2], ViewProjection[2][2], ViewProjection[3][2]);
+	glm::vec4 Row3(ViewProjection[0][3], ViewProjection[1][3], ViewProjection[2][3], ViewProjection[3][3]);
+
+	Frustum Result;
+	Result.Planes[0] = Row3 + Row0;		// Left
+	Result.Planes[1] = Row3 - Row0;		// Right
+	Result.Planes[2] = Row3 + Row1;		// Bottom
+	Result.Planes[3] = Row3 - Row1;		// Top
+	Result.Planes[4] = Row3 + Row2;		// Near
+	Result.Planes[5] = Row3 - Row2;		// Far
+
+	for (size_t i = 0; i < 6; i++)
+	{
+		Result.Planes[i] /= glm::length(glm::vec3(Result.Planes[i]));
+	}
+
+	return Result;
+}
+
+bool SphereInFrustum(const Frustum& TheFrustum, const glm::vec4& Sphere)
+{
+	for (size_t i = 0; i < 6; i++)
+	{
+		if (glm::dot(glm::vec3(TheFrustum.Planes[i]), glm::vec3(Sphere)) + TheFrustum.Planes[i].w < -Sphere.w)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void CullFrustum(const Frustum& TheFrustum, const std::vector<glm::vec4>& Bounds, std::vector<unsigned int>* OutList)
+{
+	OutList->clear();
+	for (size_t i = 0; i < Bounds.size(); i++)
+	{
+		if (SphereInFrustum(TheFrustum, Bounds[i]))
+		{
+			OutList->push_back((unsigned int)i);
+		}
+	}
+}
+
+static void CullSphere(const glm::vec3& Center, GLfloat Radius, const std::vector<glm::vec4>& Bounds, std::vector<unsigned int>* OutList)
+{
+	OutList->clear();
+	for (size_t i = 0; i < Bounds.size(); i++)
+	{
+		if (glm::length(glm::vec3(Bounds[i]) - Center) < Radius + Bounds[i].w)
+		{
+			OutList->push_back((unsigned int)i);
+		}
+	}
+}
+
+static void UpdateTransform(const SceneObject& Object, glm::mat4* OutWorld, glm::vec4* OutBounds)
+{
+	glm::mat4 World = Object.BaseTransform;
+	if (Object.OrbitAngle != 0.0f)
+	{
+		World = glm::rotate(glm::mat4(1.0f), glm::radians(Object.OrbitAngle), Object.OrbitAxis) * World;
+	}
+
+	glm::vec3 LocalCenter(0.0f, 0.0f, 0.0f);
+	GLfloat LocalRadius = 0.0f;
+	if (Object.MyModel)
+	{
+		LocalCenter = Object.MyModel->GetBoundsCenter();
+		LocalRadius = Object.MyModel->GetBoundsRadius();
+	}
+	else if (Object.MyMesh)
+	{
+		LocalCenter = Object.MyMesh->GetBoundsCenter();
+		LocalRadius = Object.MyMesh->GetBoundsRadius();
+	}
+
+	// Scale the radius by the largest axis so non-uniform scales stay conservative
+	GLfloat MaxScale = glm::max(glm::length(glm::vec3(World[0])), glm::max(glm::length(glm::vec3(World[1])), glm::length(glm::vec3(World[2]))));
+
+	*OutWorld = World;
+	*OutBounds = glm::vec4(glm::vec3(World * glm::vec4(LocalCenter, 1.0f)), LocalRadius * MaxScale);
+}
+
+void PrepareFrame(JobSystem* Jobs, LinearArena* FrameMemory,
+					const std::vector<SceneObject>& Objects,
+					Camera* ViewCamera, const glm::mat4& Projection,
+					DirectionalLight* MainLight,
+					const std::vector<PointLight*>& OmniLights,
+					FrameData* OutFrame)
+{
+	PROFILE_SCOPE("PrepareFrame");
+
+	OutFrame->WorldTransforms.resize(Objects.size());
+	OutFrame->WorldBounds.resize(Objects.size());
+	OutFrame->OmniLightMatrices = FrameMemory->Allocate<glm::mat4>(OmniLights.size() * 6);
+	OutFrame->OmniDrawLists.resize(OmniLights.size());
+
+	OutFrame->Projection = Projection;
+	OutFrame->View = ViewCamera->CalculateViewMatrix();
+
+	// Stage 1: Transforms & light matrices, all independent of each other
+	JobCounter TransformCounter;
+
+	Jobs->ParallelFor(&TransformCounter, Objects.size(), 4, [&Objects, OutFrame](size_t Start, size_t End)
+	{
+		for (size_t i = Start; i < End; i++)
+		{
+			UpdateTransform(Objects[i], &OutFrame->WorldTransforms[i], &OutFrame->WorldBounds[i]);
+		}
+	}, "UpdateTransforms");
+
+	Jobs->Run(&TransformCounter, [MainLight, OutFrame]()
+	{
+		OutFrame->DirectionalLightTransform = MainLight->CalculateLightTransform();
+	}, "DirectionalLightTransform");
+
+	// Switched off lights cast no shadow, they get no matrices or draw list
+	for (size_t i = 0; i < OmniLights.size(); i++)
+	{
+		if (!OmniLights[i]->IsEnabled())
+		{
+			continue;
+		}
+
+		Jobs->Run(&TransformCounter, [&OmniLights, OutFrame, i]()
+		{
+			OmniLights[i]->CalculateLightTransforms(&OutFrame->OmniLightMatrices[i * 6]);
+		}, "OmniLightTransforms");
+	}
+
+	Jobs->Wait(&TransformCounter);
+
+	// Stage 2: Culling & draw lists, one job per view
+	JobCounter CullCounter;
+
+	Jobs->Run(&CullCounter, [ViewCamera, &Projection, OutFrame]()
+	{
+		Frustum CameraFrustum = ExtractFrustum(Projection * OutFrame->View);
+		CullFrustum(CameraFrustum, OutFrame->WorldBounds, &OutFrame->MainDrawList);
+
+		// Front to back so early depth testing rejects as much of the Phong shading as possible
+		glm::vec3 Eye = ViewCamera->GetCameraPosition();
+		const std::vector<glm::vec4>& Bounds = OutFrame->WorldBounds;
+		std::sort(OutFrame->MainDrawList.begin(), OutFrame->MainDrawList.end(), [&Eye, &Bounds](unsigned int A, unsigned int B)
+		{
+			return glm::length(glm::vec3(Bounds[A]) - Eye) < glm::length(glm::vec3(Bounds[B]) - Eye);
+		});
+	}, "CullCamera");
+
+	Jobs->Run(&CullCounter, [OutFrame]()
+	{
+		Frustum LightFrustum = ExtractFrustum(OutFrame->DirectionalLightTransform);
+		CullFrustum(LightFrustum, OutFrame->WorldBounds, &OutFrame->DirectionalDrawList);
+	}, "CullDirectionalLight");
+
+	for (size_t i = 0; i < OmniLights.size(); i++)
+	{
+		if (!OmniLights[i]->IsEnabled())
+		{
+			OutFrame->OmniDrawLists[i].clear();
+			continue;
+		}
+
+		Jobs->Run(&CullCounter, [&OmniLights, OutFrame, i]()
+		{
+			// Spot lights draw one perspective map, only what is inside its frustum is needed
+			if (OmniLights[i]->GetShadowMap()->GetTextureTarget() == GL_TEXTURE_CUBE_MAP)
+			{
+				CullSphere(OmniLights[i]->GetPosition(), OmniLights[i]->GetFarPlane(), OutFrame->WorldBounds, &OutFrame->OmniDrawLists[i]);
+			}
+			else
+			{
+				CullFrustum(ExtractFrustum(OutFrame->OmniLightMatrices[i * 6]), OutFrame->WorldBounds, &OutFrame->OmniDrawLists[i]);
+			}
+		}, "CullOmniLight");
+	}
+
+	Jobs->Wait(&CullCounter);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "JobSystem.h"
+#include "FrameAllocator.h"
+#include "Mesh.h"
+#include "Model.h"
+#include "Texture.h"
+#include "Material.h"
+#include "Camera.h"
+#include "DirectionalLight.h"
+#include "PointLight.h"
+
+// A renderable placed in the world, either a single Mesh + Texture or a Model (which owns its textures)
+struct SceneObject
+{
+	Mesh* MyMesh;
+	Model* MyModel;
+	Texture* MyTexture;
+	Material* MyMaterial;
+
+	// World = Rotate(OrbitAngle, OrbitAxis) * BaseTransform
+	glm::mat4 BaseTransform;
+	glm::vec3 OrbitAxis;
+	GLfloat OrbitAngle;
+};
+
+// Frustum planes as (normal, distance), extracted from a combined projection * view matrix
+struct Frustum
+{
+	glm::vec4 Planes[6];
+};
+
+Frustum ExtractFrustum(const glm::mat4& ViewProjection);
+
+// Sphere as xyz = center, w = radius, true if any part of it may be inside
+bool SphereInFrustum(const Frustum& TheFrustum, const glm::vec4& Sphere);
+
+// Everything the GL thread needs to submit one frame, produced by PrepareFrame
+struct FrameData
+{
+	// Per SceneObject
+	std::vector<glm::mat4> WorldTransforms;
+	std::vector<glm::vec4> WorldBounds;			// xyz = center, w = radius
+
+	// Camera
+	glm::mat4 Projection;
+	glm::mat4 View;
+
+	// Per light
+	glm::mat4 DirectionalLightTransform;
+	glm::mat4* OmniLightMatrices;				// 6 slots per light in the frame arena, spot lights use the first, switched off lights none
+
+	// Visible SceneObject indices per view
+	std::vector<unsigned int> MainDrawList;
+	std::vector<unsigned int> DirectionalDrawList;
+	std::vector<std::vector<unsigned int>> OmniDrawLists;
+};
+
+// Fans per-frame CPU work out over the job system & joins before returning:
+//  1. Object transforms + bounds, directional & omni light matrices
+//  2. Culling + draw list generation for the camera and every shadow casting light
+// Per-frame arrays come from FrameMemory, the draw lists keep their capacity from frame to frame.
+// Runs on whichever thread produces frames, it only reads the objects, camera & lights passed in.
+// OmniLights are ordered to match their shadow index in the shader (point lights, then spot lights)
+void PrepareFrame(JobSystem* Jobs, LinearArena* FrameMemory,
+					const std::vector<SceneObject>& Objects,
+					Camera* ViewCamera, const glm::mat4& Projection,
+					DirectionalLight* MainLight,
+					const std::vector<PointLight*>& OmniLights,
+					FrameData* OutFrame);
@@ -1,22 +1,21 @@
 #include "GLWindow.h"
+#include "Log.h"
 
 GLWindow::GLWindow() :
     Width(800),
     Height(600),
     LastX(0.0f),
     LastY(0.0f),
-    ChangeX(0.0f),
-    ChangeY(0.0f),
+    PendingX(0.0f),
+    PendingY(0.0f),
+    MouseTotalX(0.0),
+    MouseTotalY(0.0),
     MainWindow(nullptr),
     BufferHeight(0),
     BufferWidth(0)
 {
-
-    for (size_t i = 0; i < 1024; i++)
-    {
-        Keys[i] = 0;
-    }
     MouseInitialized = false;
+    bRefreshRequested = true;
 }
 
 GLWindow::GLWindow(GLint WindowWidth, GLint WindowHeight) : 
@@ -24,17 +23,16 @@ GLWindow::GLWindow(GLint WindowWidth, GLint WindowHeight) :
     Height(WindowHeight),
     LastX(0.0f),
     LastY(0.0f),
-    ChangeX(0.0f),
-    ChangeY(0.0f),
+    PendingX(0.0f),
+    PendingY(0.0f),
+    MouseTotalX(0.0),
+    MouseTotalY(0.0),
     MainWindow(nullptr),
     BufferHeight(0),
     BufferWidth(0)
 {
-    for (size_t i = 0; i < 1024; i++)
-    {
-        Keys[i] = 0;
-    }
     MouseInitialized = false;
+    bRefreshRequested = true;
 }
 
 int GLWindow::Initialize()
@@ -98,18 +96,31 @@ int GLWindow::Initialize()
     glfwSetWindowUserPointer(MainWindow, this);
 }
 
-GLfloat GLWindow::GetChangeX()
+void GLWindow::PushEvent(InputEventType Type, int Key, GLfloat DeltaX, GLfloat DeltaY)
 {
-    GLfloat TheChange = ChangeX;
-    ChangeX = 0.0f;
-    return TheChange;
-}
+    InputEvent Event = { Type, Key, DeltaX, DeltaY, glfwGetTime() };
 
-GLfloat GLWindow::GetChangeY()
-{
-    GLfloat TheChange = ChangeY;
-    ChangeY = 0.0f;
-    return TheChange;
+    if (Type == INPUT_MOUSE_MOVE)
+    {
+        Event.DeltaX += PendingX;
+        Event.DeltaY += PendingY;
+        PendingX = 0.0f;
+        PendingY = 0.0f;
+    }
+
+    if (!Events.Push(Event))
+    {
+        // Keep the motion for the next event, a lost key event can't be recovered
+        if (Type == INPUT_MOUSE_MOVE)
+        {
+            PendingX = Event.DeltaX;
+            PendingY = Event.DeltaY;
+        }
+        else
+        {
+            LOG_RATE_LIMITED(1000, LOG_LEVEL_WARNING, "Input queue full, dropped key %d", Key);
+        }
+    }
 }
 
 void GLWindow::HandleKeys(GLFWwindow* Window, int Key, int Code, int Action, int Mode)
@@ -126,13 +137,13 @@ void GLWindow::HandleKeys(GLFWwindow* Window, int Key, int Code, int Action, int
     {
         if (Action == GLFW_PRESS)
         {
-            TheWindow->Keys[Key] = true;
-            printf("Pressed %d\n", Key);
+            TheWindow->PushEvent(INPUT_KEY_PRESS, Key, 0.0f, 0.0f);
+            LOG_DEBUG("Pressed %d", Key);
         }
         else if (Action == GLFW_RELEASE)
         {
-            TheWindow->Keys[Key] = false;
-            printf("Released %d\n", Key);
+            TheWindow->PushEvent(INPUT_KEY_RELEASE, Key, 0.0f, 0.0f);
+            LOG_DEBUG("Released %d", Key);
         }
     }
 }
@@ -149,20 +160,33 @@ void GLWindow::HandleMouse(GLFWwindow* Window, double PosX, double PosY)
         TheWindow->MouseInitialized = true;
     }
 
-    TheWindow->ChangeX = PosX - TheWindow->LastX;
     // Inverted Y
-    TheWindow->ChangeY = TheWindow->LastY - PosY;
+    TheWindow->PushEvent(INPUT_MOUSE_MOVE, 0, PosX - TheWindow->LastX, TheWindow->LastY - PosY);
+    TheWindow->MouseTotalX += PosX - TheWindow->LastX;
+    TheWindow->MouseTotalY += TheWindow->LastY - PosY;
 
     TheWindow->LastX = PosX;
     TheWindow->LastY = PosY;
+}
 
-    //printf("X:%.2f, Y:%.2f\n",TheWindow->ChangeX, TheWindow->ChangeY);
+void GLWindow::HandleRefresh(GLFWwindow* Window)
+{
+    GLWindow* TheWindow = static_cast<GLWindow*>(glfwGetWindowUserPointer(Window));
+    TheWindow->bRefreshRequested = true;
+}
+
+bool GLWindow::ConsumeRefreshRequest()
+{
+    bool bRequested = bRefreshRequested;
+    bRefreshRequested = false;
+    return bRequested;
 }
 
 void GLWindow::CreateCallbacks()
 {
     glfwSetKeyCallback(MainWindow, HandleKeys);
     glfwSetCursorPosCallback(MainWindow, HandleMouse);
+    glfwSetWindowRefreshCallback(MainWindow, HandleRefresh);
 }
 
 GLWindow::~GLWindow()
@@ -4,22 +4,34 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "InputQueue.h"
+
 class GLWindow
 {
 public:
 	GLWindow();
 	GLWindow(GLint WindowWidth, GLint WindowHeight);
 
+	// Window size used by Initialize, the window owns its input queue so it can't be reassigned
+	void SetSize(GLint WindowWidth, GLint WindowHeight) { Width = WindowWidth; Height = WindowHeight; }
+
 	int Initialize();
 
 	GLfloat GetBufferWidth() { return BufferWidth; }
 	GLfloat GetBufferHeight() { return BufferHeight; }
 
-	bool* GetKeys() { return Keys; }
-	GLfloat GetChangeX();
-	GLfloat GetChangeY();
+	// Filled by the GLFW callbacks during glfwPollEvents, drained by the simulation
+	InputQueue* GetInputQueue() { return &Events; }
+
+	// All mouse motion seen so far, compared against InputState's totals to find motion not yet simulated
+	double GetMouseTotalX() { return MouseTotalX; }
+	double GetMouseTotalY() { return MouseTotalY; }
 
 	bool GetShouldCloseWindow() { return glfwWindowShouldClose(MainWindow); }
+	bool IsIconified() { return glfwGetWindowAttrib(MainWindow, GLFW_ICONIFIED) != 0; }
+
+	// True once after the system asked for the window contents to be redrawn (uncovered, resized)
+	bool ConsumeRefreshRequest();
 
 	void SwapBuffers() { glfwSwapBuffers(MainWindow); };
 
@@ -32,19 +44,25 @@ private:
 	GLint BufferWidth;
 	GLint BufferHeight;
 
-	// Key Presses
-	bool Keys[1024];
+	// Timestamped key & mouse events
+	InputQueue Events;
 
 	// Mouse Positions
 	GLfloat LastX;
 	GLfloat LastY;
-	GLfloat ChangeX;
-	GLfloat ChangeY;
+	GLfloat PendingX;			// Motion that didn't fit in a full queue, sent with the next move
+	GLfloat PendingY;
+	double MouseTotalX;
+	double MouseTotalY;
 	bool MouseInitialized;
+	bool bRefreshRequested;
+
+	void PushEvent(InputEventType Type, int Key, GLfloat DeltaX, GLfloat DeltaY);
 
 	// Static allows calls with GLWindow::HandleKeys without a reference to this window object
 	static void HandleKeys(GLFWwindow* Window, int Key, int Code, int Action, int Mode);
 	static void HandleMouse(GLFWwindow* Window, double PosX, double PosY);
+	static void HandleRefresh(GLFWwindow* Window);
 	void CreateCallbacks();
 
 };
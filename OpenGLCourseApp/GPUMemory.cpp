@@ -0,0 +1,172 @@
+#include <stdio.h>
+
+#include "GPUMemory.h"
+#include "Log.h"
+
+// Shadow maps never shrink below a quarter of their requested size
+static const unsigned int MaxShadowSizeShift = 2;
+
+// Restore shadows only if the bigger maps would leave this much of the budget free, so it doesn't flip every frame
+static const double RestoreHeadroom = 0.9;
+
+static const char* CategoryNames[GPU_MEMORY_CATEGORY_COUNT] = { "Geometry", "Material textures", "Shadow maps", "Render targets" };
+
+std::atomic<size_t> GPUMemory::Usage[GPU_MEMORY_CATEGORY_COUNT] = {};
+size_t GPUMemory::BudgetBytes = 512 * 1024 * 1024;
+unsigned int GPUMemory::ShadowSizeShift = 0;
+
+void GPUMemory::TrackAllocation(GPUMemoryCategory Category, size_t Bytes)
+{
+	Usage[Category].fetch_add(Bytes, std::memory_order_relaxed);
+}
+
+void GPUMemory::TrackRelease(GPUMemoryCategory Category, size_t Bytes)
+{
+	Usage[Category].fetch_sub(Bytes, std::memory_order_relaxed);
+}
+
+size_t GPUMemory::GetTotalUsage()
+{
+	size_t Total = 0;
+	for (size_t i = 0; i < GPU_MEMORY_CATEGORY_COUNT; i++)
+	{
+		Total += Usage[i].load(std::memory_order_relaxed);
+	}
+	return Total;
+}
+
+void GPUMemory::SetBudget(size_t NewBudgetBytes)
+{
+	BudgetBytes = NewBudgetBytes;
+}
+
+unsigned int GPUMemory::CalculateMipDrop(size_t Bytes, unsigned int MaxDrop)
+{
+	size_t Total = GetTotalUsage();
+
+	// Every dropped level quarters the size
+	unsigned int Drop = 0;
+	while (Drop < MaxDrop && Total + Bytes > BudgetBytes)
+	{
+		Bytes /= 4;
+		Drop++;
+	}
+	return Drop;
+}
+
+void GPUMemory::Update()
+{
+	size_t Total = GetTotalUsage();
+
+	if (Total > BudgetBytes && ShadowSizeShift < MaxShadowSizeShift)
+	{
+		ShadowSizeShift++;
+		LOG_WARNING("Over GPU memory budget (%.1f of %.1f MB), shadow maps reduced to 1/%u resolution",
+			Total / (1024.0 * 1024.0), BudgetBytes / (1024.0 * 1024.0), 1u << ShadowSizeShift);
+		return;
+	}
+
+	// Doubling the resolution quadruples the shadow memory
+	size_t Restored = Total + GetUsage(GPU_MEMORY_SHADOW_MAPS) * 3;
+	if (ShadowSizeShift > 0 && Restored < BudgetBytes * RestoreHeadroom)
+	{
+		ShadowSizeShift--;
+		LOG_INFO("GPU memory available again, shadow maps restored to 1/%u resolution", 1u << ShadowSizeShift);
+	}
+}
+
+size_t GPUMemory::CalculateTextureBytes(GLsizei Width, GLsizei Height, GLenum InternalFormat, unsigned int Faces, bool bMipmapped)
+{
+	size_t Bytes = (size_t)Width * Height * GetBytesPerPixel(InternalFormat) * Faces;
+
+	// A full mip chain adds a third
+	return bMipmapped ? Bytes * 4 / 3 : Bytes;
+}
+
+unsigned int GPUMemory::GetBytesPerPixel(GLenum InternalFormat)
+{
+	switch (InternalFormat)
+	{
+	case GL_RED:
+	case GL_R8:
+		return 1;
+	case GL_RG:
+	case GL_RG8:
+	case GL_DEPTH_COMPONENT16:
+		return 2;
+	case GL_RGB:
+	case GL_RGB8:
+		return 3;
+	case GL_RGBA16F:
+	case GL_RG32F:
+		return 8;
+	case GL_RGBA32F:
+		return 16;
+	default:
+		// RGBA8, 24/32-bit depth & unsized depth (most drivers store it as 32 bits)
+		return 4;
+	}
+}
+
+bool GPUMemory::QueryDriverMemory(size_t* OutTotalBytes, size_t* OutAvailableBytes)
+{
+	// Both extensions report in KB
+	if (GLEW_NVX_gpu_memory_info)
+	{
+		GLint TotalKB = 0;
+		GLint AvailableKB = 0;
+		glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &TotalKB);
+		glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &AvailableKB);
+		*OutTotalBytes = (size_t)TotalKB * 1024;
+		*OutAvailableBytes = (size_t)AvailableKB * 1024;
+		return true;
+	}
+
+	if (GLEW_ATI_meminfo)
+	{
+		// Free memory in the texture pool, then the largest free block & the same for auxiliary memory
+		GLint TextureFree[4] = { 0 };
+		glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, TextureFree);
+		*OutTotalBytes = 0;		// Not exposed by ATI_meminfo
+		*OutAvailableBytes = (size_t)TextureFree[0] * 1024;
+		return true;
+	}
+
+	return false;
+}
+
+void GPUMemory::PrintReport()
+{
+	size_t Total = GetTotalUsage();
+
+	printf("GPU memory: %.1f of %.1f MB budget%s\n", Total / (1024.0 * 1024.0), BudgetBytes / (1024.0 * 1024.0),
+		Total > BudgetBytes ? " (over budget)" : "");
+
+	for (size_t i = 0; i < GPU_MEMORY_CATEGORY_COUNT; i++)
+	{
+		printf("  %-18s %8.1f MB\n", CategoryNames[i], GetUsage((GPUMemoryCategory)i) / (1024.0 * 1024.0));
+	}
+
+	if (ShadowSizeShift > 0)
+	{
+		printf("  Shadow maps at 1/%u resolution\n", 1u << ShadowSizeShift);
+	}
+
+	size_t DriverTotal = 0;
+	size_t DriverAvailable = 0;
+	if (QueryDriverMemory(&DriverTotal, &DriverAvailable))
+	{
+		if (DriverTotal > 0)
+		{
+			printf("  Driver: %.1f MB free of %.1f MB dedicated\n", DriverAvailable / (1024.0 * 1024.0), DriverTotal / (1024.0 * 1024.0));
+		}
+		else
+		{
+			printf("  Driver: %.1f MB free for textures\n", DriverAvailable / (1024.0 * 1024.0));
+		}
+	}
+	else
+	{
+		printf("  Driver memory info not available\n");
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+
+#include <GL/glew.h>
+
+enum GPUMemoryCategory
+{
+	GPU_MEMORY_GEOMETRY = 0,			// Vertex, index & uniform buffers
+	GPU_MEMORY_MATERIAL_TEXTURES,		// Model, mesh & skybox textures
+	GPU_MEMORY_SHADOW_MAPS,				// Depth targets
+	GPU_MEMORY_RENDER_TARGETS,			// Color targets
+	GPU_MEMORY_CATEGORY_COUNT
+};
+
+// Accounting for every buffer & texture the app creates, by category
+// GL doesn't say how much memory an object really takes, so sizes are estimated from dimensions & format.
+// Once the total passes the budget new textures lose their top mips & shadow maps drop to a lower resolution,
+// which is restored when there is room again. Driver totals come from GL_NVX_gpu_memory_info or GL_ATI_meminfo.
+class GPUMemory
+{
+public:
+	static void TrackAllocation(GPUMemoryCategory Category, size_t Bytes);
+	static void TrackRelease(GPUMemoryCategory Category, size_t Bytes);
+
+	static size_t GetUsage(GPUMemoryCategory Category) { return Usage[Category].load(std::memory_order_relaxed); }
+	static size_t GetTotalUsage();
+
+	static void SetBudget(size_t NewBudgetBytes);
+	static size_t GetBudget() { return BudgetBytes; }
+	static bool IsOverBudget() { return GetTotalUsage() > BudgetBytes; }
+
+	// Mip levels to skip so a texture of Bytes (full mip chain) still fits, at most MaxDrop
+	static unsigned int CalculateMipDrop(size_t Bytes, unsigned int MaxDrop);
+
+	// Shadow map size after the current budget reduction
+	static GLsizei ScaleShadowSize(GLsizei Size) { return Size >> ShadowSizeShift; }
+
+	// Once per frame, lowers or restores the shadow resolution
+	static void Update();
+
+	// Estimated bytes of a texture, Faces is 6 for cube maps
+	static size_t CalculateTextureBytes(GLsizei Width, GLsizei Height, GLenum InternalFormat, unsigned int Faces, bool bMipmapped);
+
+	// Dedicated memory reported by the driver, false without either extension
+	static bool QueryDriverMemory(size_t* OutTotalBytes, size_t* OutAvailableBytes);
+
+	static void PrintReport();
+
+private:
+	static std::atomic<size_t> Usage[GPU_MEMORY_CATEGORY_COUNT];
+	static size_t BudgetBytes;
+	static unsigned int ShadowSizeShift;
+
+	static unsigned int GetBytesPerPixel(GLenum InternalFormat);
+};
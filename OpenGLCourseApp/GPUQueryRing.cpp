@@ -0,0 +1,136 @@
+#include "GPUQueryRing.h"
+
+GPUQueryRing::GPUQueryRing()
+{
+	Target = GL_TIME_ELAPSED;
+	for (unsigned int i = 0; i < QueryCount; i++)
+	{
+		Queries[i][0] = 0;
+		Queries[i][1] = 0;
+		QueryWork[i] = 0.0;
+		bQueryPending[i] = false;
+		bQueryStale[i] = false;
+	}
+	NextQuery = 0;
+	bQueryActive = false;
+}
+
+void GPUQueryRing::Initialize(GLenum NewTarget)
+{
+	Target = NewTarget;
+	glGenQueries(QueryCount * 2, &Queries[0][0]);
+}
+
+void GPUQueryRing::Begin()
+{
+	if (bQueryActive || bQueryPending[NextQuery] || Queries[NextQuery][0] == 0)
+	{
+		return;
+	}
+
+	if (Target == GL_TIMESTAMP)
+	{
+		glQueryCounter(Queries[NextQuery][0], GL_TIMESTAMP);
+	}
+	else
+	{
+		glBeginQuery(Target, Queries[NextQuery][0]);
+	}
+	bQueryActive = true;
+}
+
+void GPUQueryRing::End(double Work)
+{
+	if (!bQueryActive)
+	{
+		return;
+	}
+
+	if (Target == GL_TIMESTAMP)
+	{
+		glQueryCounter(Queries[NextQuery][1], GL_TIMESTAMP);
+	}
+	else
+	{
+		glEndQuery(Target);
+	}
+	QueryWork[NextQuery] = Work;
+	bQueryPending[NextQuery] = true;
+	bQueryStale[NextQuery] = false;
+	NextQuery = (NextQuery + 1) % QueryCount;
+	bQueryActive = false;
+}
+
+bool GPUQueryRing::ReadResult(GLuint64* OutResult, double* OutWork)
+{
+	// Oldest first, results come back in submission order
+	for (unsigned int i = 0; i < QueryCount; i++)
+	{
+		unsigned int Index = (NextQuery + i) % QueryCount;
+		if (!bQueryPending[Index])
+		{
+			continue;
+		}
+
+		// The end timestamp is written last, once it's there both are
+		GLint bAvailable = GL_FALSE;
+		glGetQueryObjectiv(Queries[Index][Target == GL_TIMESTAMP ? 1 : 0], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+		if (!bAvailable)
+		{
+			return false;
+		}
+
+		GLuint64 Result = 0;
+		glGetQueryObjectui64v(Queries[Index][0], GL_QUERY_RESULT, &Result);
+		if (Target == GL_TIMESTAMP)
+		{
+			GLuint64 End = 0;
+			glGetQueryObjectui64v(Queries[Index][1], GL_QUERY_RESULT, &End);
+			Result = End > Result ? End - Result : 0;
+		}
+		bQueryPending[Index] = false;
+
+		if (bQueryStale[Index])
+		{
+			continue;
+		}
+
+		*OutResult = Result;
+		*OutWork = QueryWork[Index];
+		return true;
+	}
+	return false;
+}
+
+void GPUQueryRing::Discard()
+{
+	for (unsigned int i = 0; i < QueryCount; i++)
+	{
+		bQueryStale[i] = bQueryPending[i];
+	}
+}
+
+void GPUQueryRing::Clear()
+{
+	if (bQueryActive && Target != GL_TIMESTAMP)
+	{
+		glEndQuery(Target);
+	}
+	bQueryActive = false;
+
+	if (Queries[0][0] != 0)
+	{
+		glDeleteQueries(QueryCount * 2, &Queries[0][0]);
+		for (unsigned int i = 0; i < QueryCount; i++)
+		{
+			Queries[i][0] = 0;
+			Queries[i][1] = 0;
+			bQueryPending[i] = false;
+			bQueryStale[i] = false;
+		}
+	}
+}
+
+GPUQueryRing::~GPUQueryRing()
+{
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// A few GL queries of one kind used in turn, so results are read back a few frames late without stalling
+// Takes GL_TIME_ELAPSED, GL_SAMPLES_PASSED or GL_TIMESTAMP. A timestamp measurement is a pair of queries,
+// which unlike GL_TIME_ELAPSED can sit inside another timer query. Each measurement carries the work
+// it covered (e.g. pixels or faces) for the owner to divide by.
+class GPUQueryRing
+{
+public:
+	GPUQueryRing();
+
+	void Initialize(GLenum NewTarget);
+
+	// Bracket the work to measure, skipped while every query is still in flight rather than wait on the oldest
+	void Begin();
+	void End(double Work);
+
+	// Oldest finished measurement, nanoseconds for the timers & samples for GL_SAMPLES_PASSED
+	// False once the next one is still in flight, call until it is to drain what has come back
+	bool ReadResult(GLuint64* OutResult, double* OutWork);
+
+	// Measurements in flight are thrown away when they come back, e.g. after switching what is measured
+	void Discard();
+
+	void Clear();
+
+	~GPUQueryRing();
+
+private:
+	static const unsigned int QueryCount = 4;
+
+	GLenum Target;
+	GLuint Queries[QueryCount][2];		// The second only for GL_TIMESTAMP
+	double QueryWork[QueryCount];
+	bool bQueryPending[QueryCount];
+	bool bQueryStale[QueryCount];
+	unsigned int NextQuery;
+	bool bQueryActive;
+};
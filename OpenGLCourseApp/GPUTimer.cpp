@@ -0,0 +1,65 @@
+#include "GPUTimer.h"
+
+// Weight of the newest sample in the smoothed times
+static const double Smoothing = 0.1;
+
+GPUTimer::GPUTimer()
+{
+	SmoothedMilliseconds = 0.0;
+	SmoothedPerWork = 0.0;
+}
+
+void GPUTimer::Initialize()
+{
+	Queries.Initialize(GL_TIMESTAMP);
+}
+
+void GPUTimer::Begin()
+{
+	Update();
+	Queries.Begin();
+}
+
+void GPUTimer::End(double Work)
+{
+	Queries.End(Work);
+}
+
+void GPUTimer::Update()
+{
+	GLuint64 Nanoseconds = 0;
+	double Work = 0.0;
+	while (Queries.ReadResult(&Nanoseconds, &Work))
+	{
+		if (Nanoseconds == 0)
+		{
+			continue;
+		}
+
+		double Milliseconds = Nanoseconds / 1000000.0;
+		SmoothedMilliseconds = SmoothedMilliseconds > 0.0 ? SmoothedMilliseconds + (Milliseconds - SmoothedMilliseconds) * Smoothing : Milliseconds;
+
+		if (Work > 0.0)
+		{
+			double PerWork = Milliseconds / Work;
+			SmoothedPerWork = SmoothedPerWork > 0.0 ? SmoothedPerWork + (PerWork - SmoothedPerWork) * Smoothing : PerWork;
+		}
+	}
+}
+
+void GPUTimer::Reset()
+{
+	// Queries in flight timed the old work, they are read back & thrown away
+	Queries.Discard();
+	SmoothedMilliseconds = 0.0;
+	SmoothedPerWork = 0.0;
+}
+
+void GPUTimer::Clear()
+{
+	Queries.Clear();
+}
+
+GPUTimer::~GPUTimer()
+{
+}
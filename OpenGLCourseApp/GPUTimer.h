@@ -0,0 +1,42 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "GPUQueryRing.h"
+
+// GPU time of one stretch of a frame's GL work, e.g. a single pass
+// Measured with GL_TIMESTAMP pairs rather than GL_TIME_ELAPSED, which can't nest inside the whole frame
+// query dynamic resolution runs. Results are read back a few frames late, never stalling.
+// Each sample can be weighed by the work it did (e.g. pixels shaded), so the cost per unit can be compared
+// across resolution changes.
+class GPUTimer
+{
+public:
+	GPUTimer();
+
+	void Initialize();
+
+	// Bracket the work to time, Begin() also reads finished queries
+	void Begin();
+	void End(double Work);
+
+	// Reads finished queries, for frames that may not time anything
+	void Update();
+
+	// Smoothed over recent samples, 0 until the first query returns
+	double GetMilliseconds() const { return SmoothedMilliseconds; }
+	double GetMillisecondsPerWork() const { return SmoothedPerWork; }
+
+	// Forgets the averages & results still in flight, e.g. after switching what is being measured
+	void Reset();
+
+	void Clear();
+
+	~GPUTimer();
+
+private:
+	GPUQueryRing Queries;
+
+	double SmoothedMilliseconds;
+	double SmoothedPerWork;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+
+enum InputEventType
+{
+	INPUT_KEY_PRESS = 0,
+	INPUT_KEY_RELEASE,
+	INPUT_MOUSE_MOVE
+};
+
+struct InputEvent
+{
+	InputEventType Type;
+	int Key;
+	float DeltaX;
+	float DeltaY;
+	double Time;			// Seconds on the glfwGetTime() clock, when the callback saw it
+};
+
+// Lock-free single producer, single consumer queue of input events
+// The GLFW callbacks push, whichever thread steps the simulation pops. Neither side ever waits.
+// A full queue refuses the push, the producer decides what to do with the event.
+class InputQueue
+{
+public:
+	static const size_t Capacity = 1024;		// Power of two
+
+	bool Push(const InputEvent& Event)
+	{
+		size_t CurrentHead = Head.load(std::memory_order_relaxed);
+		if (CurrentHead - Tail.load(std::memory_order_acquire) >= Capacity)
+		{
+			return false;
+		}
+
+		Events[CurrentHead & (Capacity - 1)] = Event;
+		Head.store(CurrentHead + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Oldest event without removing it, nullptr if the queue is empty
+	const InputEvent* Peek()
+	{
+		size_t CurrentTail = Tail.load(std::memory_order_relaxed);
+		if (CurrentTail == Head.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+		return &Events[CurrentTail & (Capacity - 1)];
+	}
+
+	void Pop()
+	{
+		Tail.store(Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+private:
+	InputEvent Events[Capacity];
+
+	// Separate cache lines so the two threads don't fight over them
+	alignas(64) std::atomic<size_t> Head{ 0 };			// Written by the producer
+	alignas(64) std::atomic<size_t> Tail{ 0 };			// Written by the consumer
+};
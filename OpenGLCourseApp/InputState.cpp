@@ -0,0 +1,69 @@
+#include <algorithm>
+
+#include "InputState.h"
+
+InputState::InputState()
+{
+	for (size_t i = 0; i < 1024; i++)
+	{
+		Keys[i] = false;
+	}
+	KeysDown = 0;
+	EventCount = 0;
+	ChangeX = 0.0f;
+	ChangeY = 0.0f;
+	LastEventTime = 0.0;
+	MouseTotalX = 0.0;
+	MouseTotalY = 0.0;
+}
+
+void InputState::Update(InputQueue* Queue, double UpToTime)
+{
+	Pressed.clear();
+	EventCount = 0;
+
+	for (const InputEvent* Event = Queue->Peek(); Event && Event->Time <= UpToTime; Event = Queue->Peek())
+	{
+		switch (Event->Type)
+		{
+		case INPUT_KEY_PRESS:
+			KeysDown += Keys[Event->Key] ? 0 : 1;
+			Keys[Event->Key] = true;
+			Pressed.push_back(Event->Key);
+			break;
+		case INPUT_KEY_RELEASE:
+			KeysDown -= Keys[Event->Key] ? 1 : 0;
+			Keys[Event->Key] = false;
+			break;
+		case INPUT_MOUSE_MOVE:
+			ChangeX += Event->DeltaX;
+			ChangeY += Event->DeltaY;
+			MouseTotalX += Event->DeltaX;
+			MouseTotalY += Event->DeltaY;
+			break;
+		}
+
+		LastEventTime = Event->Time;
+		EventCount++;
+		Queue->Pop();
+	}
+}
+
+bool InputState::WasPressed(int Key)
+{
+	return std::find(Pressed.begin(), Pressed.end(), Key) != Pressed.end();
+}
+
+float InputState::ConsumeChangeX()
+{
+	float TheChange = ChangeX;
+	ChangeX = 0.0f;
+	return TheChange;
+}
+
+float InputState::ConsumeChangeY()
+{
+	float TheChange = ChangeY;
+	ChangeY = 0.0f;
+	return TheChange;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include "InputQueue.h"
+
+// Consumer side of the input queue
+// Rebuilds key state & accumulates mouse motion from the events in order, so nothing is lost
+// however long a frame takes. Key presses are also kept as edges, a toggle fires once per press.
+class InputState
+{
+public:
+	InputState();
+
+	// Applies every queued event up to UpToTime (seconds), later events stay queued
+	void Update(InputQueue* Queue, double UpToTime);
+
+	bool* GetKeys() { return Keys; }
+
+	// True if the key went down during the last Update
+	bool WasPressed(int Key);
+
+	// Events applied by the last Update, & whether anything is held down, for on-demand rendering
+	unsigned int GetEventCount() { return EventCount; }
+	bool IsAnyKeyDown() { return KeysDown > 0; }
+
+	// Motion accumulated since the last call
+	float ConsumeChangeX();
+	float ConsumeChangeY();
+
+	double GetLastEventTime() { return LastEventTime; }
+
+	// All mouse motion consumed so far
+	double GetMouseTotalX() { return MouseTotalX; }
+	double GetMouseTotalY() { return MouseTotalY; }
+
+private:
+	bool Keys[1024];
+	std::vector<int> Pressed;
+	unsigned int KeysDown;
+	unsigned int EventCount;
+
+	float ChangeX;
+	float ChangeY;
+	double LastEventTime;
+	double MouseTotalX;
+	double MouseTotalY;
+};
@@ -0,0 +1,229 @@
+#include <stdio.h>
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+thread_local unsigned int JobSystem::ThreadIndex = 0;
+
+JobSystem::JobSystem()
+{
+	bRunning = false;
+	QueuedJobs = 0;
+	FirstExternalQueue = 1;
+}
+
+void JobSystem::Initialize(unsigned int NumWorkers, unsigned int ExternalThreads)
+{
+	if (NumWorkers == 0)
+	{
+		unsigned int HardwareThreads = std::thread::hardware_concurrency();
+		NumWorkers = HardwareThreads > 1 ? HardwareThreads - 1 : 1;
+	}
+
+	// Queue 0 is owned by the calling (main) thread
+	ThreadIndex = 0;
+	for (size_t i = 0; i < NumWorkers + 1 + ExternalThreads; i++)
+	{
+		Queues.push_back(new WorkerQueue());
+	}
+	FirstExternalQueue = NumWorkers + 1;
+
+	bRunning = true;
+	for (unsigned int i = 1; i <= NumWorkers; i++)
+	{
+		Workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+
+	printf("Job System started with %d worker threads\n", NumWorkers);
+}
+
+void JobSystem::AttachThread(unsigned int External)
+{
+	ThreadIndex = FirstExternalQueue + External;
+}
+
+void JobSystem::Shutdown()
+{
+	if (!bRunning)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> Guard(SleepLock);
+		bRunning = false;
+	}
+	WakeCondition.notify_all();
+
+	for (size_t i = 0; i < Workers.size(); i++)
+	{
+		Workers[i].join();
+	}
+	Workers.clear();
+
+	for (size_t i = 0; i < Queues.size(); i++)
+	{
+		delete Queues[i];
+	}
+	Queues.clear();
+}
+
+void JobSystem::Run(JobCounter* Counter, std::function<void()> Task, const char* Name)
+{
+	Counter->Pending.fetch_add(1);
+
+	// Push onto the calling thread's own queue, other threads steal it if they're idle
+	WorkerQueue* Queue = Queues[ThreadIndex];
+	{
+		std::lock_guard<std::mutex> Guard(Queue->Lock);
+		Queue->PushBack({ std::move(Task), Counter, Name });
+	}
+
+	{
+		std::lock_guard<std::mutex> Guard(SleepLock);
+		QueuedJobs.fetch_add(1);
+	}
+	WakeCondition.notify_one();
+}
+
+void JobSystem::ParallelFor(JobCounter* Counter, size_t Count, size_t BatchSize,
+							std::function<void(size_t Start, size_t End)> Task, const char* Name)
+{
+	if (BatchSize == 0)
+	{
+		BatchSize = 1;
+	}
+
+	for (size_t Start = 0; Start < Count; Start += BatchSize)
+	{
+		size_t End = Start + BatchSize < Count ? Start + BatchSize : Count;
+		Run(Counter, [Task, Start, End]() { Task(Start, End); }, Name);
+	}
+}
+
+void JobSystem::Wait(JobCounter* Counter)
+{
+	PROFILE_SCOPE("JobSystem::Wait");
+
+	while (Counter->Pending.load(std::memory_order_acquire) > 0)
+	{
+		Job NextJob;
+		if (TryGetJob(NextJob))
+		{
+			Execute(NextJob);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool JobSystem::PopLocal(unsigned int Index, Job& OutJob)
+{
+	WorkerQueue* Queue = Queues[Index];
+	std::lock_guard<std::mutex> Guard(Queue->Lock);
+
+	if (Queue->Count == 0)
+	{
+		return false;
+	}
+
+	Queue->PopBack(OutJob);
+	return true;
+}
+
+bool JobSystem::Steal(unsigned int Thief, Job& OutJob)
+{
+	// Start at the neighbouring queue so thieves spread out over the victims
+	size_t QueueCount = Queues.size();
+	for (size_t i = 1; i < QueueCount; i++)
+	{
+		WorkerQueue* Victim = Queues[(Thief + i) % QueueCount];
+		std::lock_guard<std::mutex> Guard(Victim->Lock);
+
+		if (Victim->Count > 0)
+		{
+			Victim->PopFront(OutJob);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JobSystem::TryGetJob(Job& OutJob)
+{
+	if (PopLocal(ThreadIndex, OutJob) || Steal(ThreadIndex, OutJob))
+	{
+		QueuedJobs.fetch_sub(1);
+		return true;
+	}
+
+	return false;
+}
+
+void JobSystem::Execute(Job& TheJob)
+{
+	{
+		PROFILE_SCOPE(TheJob.Name);
+		TheJob.Task();
+	}
+
+	TheJob.Counter->Pending.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::WorkerLoop(unsigned int Index)
+{
+	ThreadIndex = Index;
+
+	while (bRunning)
+	{
+		Job NextJob;
+		if (TryGetJob(NextJob))
+		{
+			Execute(NextJob);
+			continue;
+		}
+
+		// Nothing to do, sleep until new work is queued
+		std::unique_lock<std::mutex> Guard(SleepLock);
+		WakeCondition.wait(Guard, [this]() { return !bRunning || QueuedJobs.load() > 0; });
+	}
+}
+
+void JobSystem::WorkerQueue::PushBack(Job&& NewJob)
+{
+	if (Count == Ring.size())
+	{
+		// Unwrap into a buffer twice the size
+		std::vector<Job> Grown(Ring.size() > 0 ? Ring.size() * 2 : 64);
+		for (size_t i = 0; i < Count; i++)
+		{
+			Grown[i] = std::move(Ring[(Head + i) % Ring.size()]);
+		}
+		Ring.swap(Grown);
+		Head = 0;
+	}
+
+	Ring[(Head + Count) % Ring.size()] = std::move(NewJob);
+	Count++;
+}
+
+void JobSystem::WorkerQueue::PopBack(Job& OutJob)
+{
+	OutJob = std::move(Ring[(Head + Count - 1) % Ring.size()]);
+	Count--;
+}
+
+void JobSystem::WorkerQueue::PopFront(Job& OutJob)
+{
+	OutJob = std::move(Ring[Head]);
+	Head = (Head + 1) % Ring.size();
+	Count--;
+}
+
+JobSystem::~JobSystem()
+{
+	Shutdown();
+}
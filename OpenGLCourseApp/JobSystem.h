@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tracks a group of jobs so the caller can wait for all of them to finish
+struct JobCounter
+{
+	std::atomic<int> Pending{ 0 };
+};
+
+// Work-stealing job system
+// Each thread owns a queue: it pushes & pops its own jobs from the back (LIFO, cache-warm),
+// idle threads steal from the front of other queues (FIFO, oldest/biggest work first).
+// Queue 0 belongs to the main (GL context) thread, which helps run jobs while it waits. Other
+// threads that submit jobs (e.g. the simulation thread) get their own queues after the workers.
+class JobSystem
+{
+public:
+	JobSystem();
+
+	// 0 workers = one per hardware thread, minus the main thread
+	// ExternalThreads reserves queues for threads besides main that will call AttachThread
+	void Initialize(unsigned int NumWorkers = 0, unsigned int ExternalThreads = 0);
+
+	// Gives the calling thread the External-th reserved queue, call before it runs or waits on jobs
+	void AttachThread(unsigned int External);
+	void Shutdown();
+
+	void Run(JobCounter* Counter, std::function<void()> Task, const char* Name);
+
+	// Splits [0, Count) into batches of BatchSize, each batch is a separate job
+	void ParallelFor(JobCounter* Counter, size_t Count, size_t BatchSize,
+					std::function<void(size_t Start, size_t End)> Task, const char* Name);
+
+	// Blocks until the counter reaches 0, executing queued jobs in the meantime
+	void Wait(JobCounter* Counter);
+
+	unsigned int GetThreadCount() { return (unsigned int)Queues.size(); }
+	static unsigned int GetThreadIndex() { return ThreadIndex; }
+
+	~JobSystem();
+
+private:
+	struct Job
+	{
+		std::function<void()> Task;
+		JobCounter* Counter;
+		const char* Name;
+	};
+
+	// Ring buffer of jobs, only grows (a std::deque would allocate as jobs come & go)
+	struct WorkerQueue
+	{
+		std::mutex Lock;
+		std::vector<Job> Ring;
+		size_t Head = 0;
+		size_t Count = 0;
+
+		void PushBack(Job&& NewJob);
+		void PopBack(Job& OutJob);
+		void PopFront(Job& OutJob);
+	};
+
+	std::vector<WorkerQueue*> Queues;
+	std::vector<std::thread> Workers;
+	unsigned int FirstExternalQueue;
+
+	std::atomic<bool> bRunning;
+	std::atomic<int> QueuedJobs;
+	std::mutex SleepLock;
+	std::condition_variable WakeCondition;
+
+	static thread_local unsigned int ThreadIndex;
+
+	bool PopLocal(unsigned int Index, Job& OutJob);
+	bool Steal(unsigned int Thief, Job& OutJob);
+	bool TryGetJob(Job& OutJob);
+	void Execute(Job& TheJob);
+	void WorkerLoop(unsigned int Index);
+};
@@ -5,6 +5,9 @@
 #include <GLM/gtc/matrix_transform.hpp>
 
 #include "ShadowMap.h"
+#include "ShaderReflection.h"
+
+class Shader;
 
 class Light
 {
@@ -17,6 +20,9 @@ public:
 
 	ShadowMap* GetShadowMap() { return MyShadowMap; }
 
+	glm::vec3 GetColor() { return Color; }
+	GLfloat GetDiffuseIntensity() { return DiffuseIntensity; }
+
 	~Light();
 
 protected:
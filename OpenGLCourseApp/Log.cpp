@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <chrono>
+
+#include "Log.h"
+
+// How long the logger thread sleeps between drains, messages show up at most this late
+static const int DrainIntervalMillis = 5;
+
+static const char* LevelNames[LOG_LEVEL_NONE] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR" };
+
+std::atomic<bool> Log::bRunning{ false };
+std::thread Log::LoggerThread;
+std::mutex Log::RingLock;
+std::vector<Log::ThreadRing*> Log::Rings;
+std::vector<Log::ThreadRing*> Log::DrainRings;
+std::vector<size_t> Log::DrainHeads;
+thread_local Log::ThreadRing* Log::LocalRing = nullptr;
+thread_local LogRecord Log::DirectRecord;
+
+void Log::Start()
+{
+	if (bRunning)
+	{
+		return;
+	}
+
+	bRunning = true;
+	LoggerThread = std::thread(&Log::LoggerLoop);
+}
+
+void Log::Stop()
+{
+	if (!bRunning)
+	{
+		return;
+	}
+
+	bRunning = false;
+	LoggerThread.join();
+
+	// Whatever arrived after the last drain
+	Drain();
+	fflush(stdout);
+}
+
+long long Log::GetTimeMicros()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool Log::Allow(RateLimit* Limit, long long IntervalMicros, unsigned int* OutSuppressed)
+{
+	long long Now = GetTimeMicros();
+	long long Next = Limit->NextMicros.load(std::memory_order_relaxed);
+
+	// Only the thread that moves the deadline forward gets to log
+	if (Now < Next || !Limit->NextMicros.compare_exchange_strong(Next, Now + IntervalMicros, std::memory_order_relaxed))
+	{
+		Limit->Suppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	*OutSuppressed = Limit->Suppressed.exchange(0, std::memory_order_relaxed);
+	return true;
+}
+
+Log::ThreadRing* Log::RegisterThread()
+{
+	// Once per thread, the only lock a logging thread ever takes
+	ThreadRing* Ring = new ThreadRing();
+
+	std::lock_guard<std::mutex> Guard(RingLock);
+	Ring->ThreadID = (unsigned int)Rings.size();
+	Rings.push_back(Ring);
+	return Ring;
+}
+
+LogRecord* Log::BeginRecord()
+{
+	LogRecord* Record = &DirectRecord;
+
+	if (bRunning.load(std::memory_order_relaxed))
+	{
+		if (!LocalRing)
+		{
+			LocalRing = RegisterThread();
+		}
+
+		size_t Head = LocalRing->Head.load(std::memory_order_relaxed);
+		if (Head - LocalRing->Tail.load(std::memory_order_acquire) >= RingSize)
+		{
+			LocalRing->Dropped.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Record = &LocalRing->Records[Head & (RingSize - 1)];
+		Record->ThreadID = LocalRing->ThreadID;
+	}
+	else
+	{
+		Record->ThreadID = LocalRing ? LocalRing->ThreadID : 0;
+	}
+
+	Record->TimeMicros = GetTimeMicros();
+	return Record;
+}
+
+void Log::EndRecord(LogRecord* Record)
+{
+	if (Record == &DirectRecord)
+	{
+		Print(*Record);
+		return;
+	}
+
+	// Publish, the logger thread only reads records below Head
+	LocalRing->Head.store(LocalRing->Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void Log::Drain()
+{
+	// Rings are never removed, only the ones registered since the last drain are copied
+	{
+		std::lock_guard<std::mutex> Guard(RingLock);
+		if (DrainRings.size() < Rings.size())
+		{
+			DrainRings.insert(DrainRings.end(), Rings.begin() + DrainRings.size(), Rings.end());
+			DrainHeads.resize(DrainRings.size());
+		}
+	}
+	std::vector<ThreadRing*>& Snapshot = DrainRings;
+	std::vector<size_t>& Heads = DrainHeads;
+
+	// Merge by time across threads, oldest first, within what has been published so far
+	for (size_t i = 0; i < Snapshot.size(); i++)
+	{
+		Heads[i] = Snapshot[i]->Head.load(std::memory_order_acquire);
+	}
+
+	while (true)
+	{
+		ThreadRing* Oldest = nullptr;
+		for (size_t i = 0; i < Snapshot.size(); i++)
+		{
+			size_t Tail = Snapshot[i]->Tail.load(std::memory_order_relaxed);
+			if (Tail == Heads[i])
+			{
+				continue;
+			}
+
+			const LogRecord& Candidate = Snapshot[i]->Records[Tail & (RingSize - 1)];
+			if (!Oldest || Candidate.TimeMicros < Oldest->Records[Oldest->Tail.load(std::memory_order_relaxed) & (RingSize - 1)].TimeMicros)
+			{
+				Oldest = Snapshot[i];
+			}
+		}
+
+		if (!Oldest)
+		{
+			break;
+		}
+
+		size_t Tail = Oldest->Tail.load(std::memory_order_relaxed);
+		Print(Oldest->Records[Tail & (RingSize - 1)]);
+
+		// Hands the slot back to the producer
+		Oldest->Tail.store(Tail + 1, std::memory_order_release);
+	}
+
+	for (size_t i = 0; i < Snapshot.size(); i++)
+	{
+		unsigned long long Dropped = Snapshot[i]->Dropped.exchange(0, std::memory_order_relaxed);
+		if (Dropped > 0)
+		{
+			printf("[WARN] Log ring of thread %u was full, %llu messages dropped\n", Snapshot[i]->ThreadID, Dropped);
+		}
+	}
+}
+
+void Log::LoggerLoop()
+{
+	while (bRunning)
+	{
+		Drain();
+		fflush(stdout);
+		std::this_thread::sleep_for(std::chrono::milliseconds(DrainIntervalMillis));
+	}
+}
+
+void Log::Print(const LogRecord& Record)
+{
+	char Message[512] = { '\0' };
+	Record.Formatter(Record, Message, sizeof(Message));
+
+	// Callers keep the printf habit of ending with a newline, the prefix goes in front of the message
+	size_t Length = strlen(Message);
+	while (Length > 0 && Message[Length - 1] == '\n')
+	{
+		Message[--Length] = '\0';
+	}
+
+	if (Record.Suppressed > 0)
+	{
+		printf("[%s] [T%u] %s (%u similar suppressed)\n", LevelNames[Record.Level], Record.ThreadID, Message, Record.Suppressed);
+	}
+	else
+	{
+		printf("[%s] [T%u] %s\n", LevelNames[Record.Level], Record.ThreadID, Message);
+	}
+}
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+enum LogLevel
+{
+	LOG_LEVEL_TRACE = 0,
+	LOG_LEVEL_DEBUG,
+	LOG_LEVEL_INFO,
+	LOG_LEVEL_WARNING,
+	LOG_LEVEL_ERROR,
+	LOG_LEVEL_NONE
+};
+
+// Messages below this level compile to nothing
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+// One message waiting for the logger thread: the format string & raw arguments, formatted later
+struct LogRecord
+{
+	static const size_t ArgumentBytes = 64;
+	static const size_t StringBytes = 192;
+
+	const char* Format;
+	LogLevel Level;
+	unsigned int ThreadID;
+	unsigned int Suppressed;			// Rate limited repeats dropped before this one
+	long long TimeMicros;
+	void (*Formatter)(const LogRecord& Record, char* Out, size_t OutSize);
+
+	alignas(8) unsigned char Arguments[ArgumentBytes];
+	char Strings[StringBytes];			// Copies of string arguments, the originals may be gone by the time it's formatted
+	size_t StringsUsed;
+};
+
+// Arguments are stored as they are, except strings which are copied into the record
+template <typename T>
+struct LogArgument
+{
+	typedef T Stored;
+	typedef T Decoded;
+	static Stored Encode(T Value, LogRecord*) { return Value; }
+	static Decoded Decode(Stored Value, const LogRecord&) { return Value; }
+};
+
+template <>
+struct LogArgument<const char*>
+{
+	typedef uint16_t Stored;
+	typedef const char* Decoded;
+
+	static Stored Encode(const char* Value, LogRecord* Record)
+	{
+		if (!Value)
+		{
+			Value = "(null)";
+		}
+
+		// Truncate rather than fail when the string area runs out
+		size_t Offset = Record->StringsUsed;
+		size_t Space = LogRecord::StringBytes - Offset;
+		size_t Length = strlen(Value);
+		Length = Length < Space - 1 ? Length : Space - 1;
+		memcpy(Record->Strings + Offset, Value, Length);
+		Record->Strings[Offset + Length] = '\0';
+		Record->StringsUsed = Offset + Length + 1 < LogRecord::StringBytes ? Offset + Length + 1 : LogRecord::StringBytes - 1;
+		return (Stored)Offset;
+	}
+
+	static const char* Decode(Stored Value, const LogRecord& Record) { return Record.Strings + Value; }
+};
+
+template <>
+struct LogArgument<char*> : LogArgument<const char*>
+{
+};
+
+// Asynchronous logger
+// Each thread writes records into its own lock-free single producer ring, a background thread drains
+// the rings, formats & writes to stdout. A call on the render thread is a few stores, nothing waits on I/O.
+// A full ring drops the message (counted) rather than blocking. Before Start() & after Stop() messages
+// are printed directly.
+class Log
+{
+public:
+	static void Start();
+	static void Stop();
+
+	template <typename... Args>
+	static void Write(LogLevel Level, unsigned int Suppressed, const char* Format, Args... Arguments)
+	{
+		static_assert(std::conjunction<std::is_trivially_copyable<typename LogArgument<typename std::decay<Args>::type>::Stored>...>::value,
+					  "Log arguments must be trivially copyable, pass strings as const char*");
+		static_assert(PackedSize<typename LogArgument<typename std::decay<Args>::type>::Stored...>() <= LogRecord::ArgumentBytes,
+					  "Too many log arguments");
+
+		LogRecord* Record = BeginRecord();
+		if (!Record)
+		{
+			return;
+		}
+
+		Record->Format = Format;
+		Record->Level = Level;
+		Record->Suppressed = Suppressed;
+		Record->Formatter = &FormatRecord<typename std::decay<Args>::type...>;
+		Record->StringsUsed = 0;
+
+		// Braced lists evaluate left to right, so the arguments are packed in order
+		size_t Offset = 0;
+		int Packed[] = { 0, (WriteArgument(Record, &Offset, LogArgument<typename std::decay<Args>::type>::Encode(Arguments, Record)), 0)... };
+		(void)Packed;
+
+		EndRecord(Record);
+	}
+
+	// Lets one message through per Interval, counting the ones it holds back
+	struct RateLimit
+	{
+		std::atomic<long long> NextMicros{ 0 };
+		std::atomic<unsigned int> Suppressed{ 0 };
+	};
+	static bool Allow(RateLimit* Limit, long long IntervalMicros, unsigned int* OutSuppressed);
+
+	static long long GetTimeMicros();
+
+private:
+	static const size_t RingSize = 1024;		// Records per thread, power of two
+
+	struct ThreadRing
+	{
+		LogRecord Records[RingSize];
+		std::atomic<size_t> Head{ 0 };			// Written by the owning thread
+		std::atomic<size_t> Tail{ 0 };			// Written by the logger thread
+		std::atomic<unsigned long long> Dropped{ 0 };
+		unsigned int ThreadID = 0;
+	};
+
+	static std::atomic<bool> bRunning;
+	static std::thread LoggerThread;
+	static std::mutex RingLock;
+	static std::vector<ThreadRing*> Rings;
+
+	// The logger thread's copy of Rings & their published heads, only growing when a thread registers
+	// so a drain doesn't allocate
+	static std::vector<ThreadRing*> DrainRings;
+	static std::vector<size_t> DrainHeads;
+	static thread_local ThreadRing* LocalRing;
+	static thread_local LogRecord DirectRecord;
+
+	static LogRecord* BeginRecord();
+	static void EndRecord(LogRecord* Record);
+	static ThreadRing* RegisterThread();
+	static void Drain();
+	static void LoggerLoop();
+	static void Print(const LogRecord& Record);
+
+	// Worst case bytes with alignment padding
+	template <typename... Stored>
+	static constexpr size_t PackedSize()
+	{
+		size_t Sizes[] = { 0, (sizeof(Stored) + alignof(Stored) - 1)... };
+		size_t Total = 0;
+		for (size_t Size : Sizes)
+		{
+			Total += Size;
+		}
+		return Total;
+	}
+
+	template <typename Stored>
+	static void WriteArgument(LogRecord* Record, size_t* Offset, const Stored& Value)
+	{
+		*Offset = (*Offset + alignof(Stored) - 1) & ~(alignof(Stored) - 1);
+		memcpy(Record->Arguments + *Offset, &Value, sizeof(Stored));
+		*Offset += sizeof(Stored);
+	}
+
+	template <typename T>
+	static typename LogArgument<T>::Decoded ReadArgument(const LogRecord& Record, size_t* Offset)
+	{
+		typedef typename LogArgument<T>::Stored Stored;
+		*Offset = (*Offset + alignof(Stored) - 1) & ~(alignof(Stored) - 1);
+		Stored Value;
+		memcpy(&Value, Record.Arguments + *Offset, sizeof(Stored));
+		*Offset += sizeof(Stored);
+		return LogArgument<T>::Decode(Value, Record);
+	}
+
+	template <typename... Args>
+	static void FormatRecord(const LogRecord& Record, char* Out, size_t OutSize)
+	{
+		size_t Offset = 0;
+		std::tuple<typename LogArgument<Args>::Decoded...> Values{ ReadArgument<Args>(Record, &Offset)... };
+		FormatValues(Record, Out, OutSize, Values, std::index_sequence_for<Args...>());
+	}
+
+	template <typename Tuple, size_t... Indices>
+	static void FormatValues(const LogRecord& Record, char* Out, size_t OutSize, const Tuple& Values, std::index_sequence<Indices...>)
+	{
+		snprintf(Out, OutSize, Record.Format, std::get<Indices>(Values)...);
+	}
+};
+
+#define LOG_AT(Level, ...) do { if ((Level) >= LOG_MIN_LEVEL) { Log::Write((Level), 0, __VA_ARGS__); } } while (0)
+
+#define LOG_TRACE(...) LOG_AT(LOG_LEVEL_TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(LOG_LEVEL_WARNING, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+// At most one message per IntervalMs from this call site, the next one reports how many were skipped
+#define LOG_RATE_LIMITED(IntervalMs, Level, ...) \
+	do \
+	{ \
+		if ((Level) >= LOG_MIN_LEVEL) \
+		{ \
+			static Log::RateLimit CallSiteLimit; \
+			unsigned int SuppressedCount = 0; \
+			if (Log::Allow(&CallSiteLimit, (IntervalMs) * 1000LL, &SuppressedCount)) \
+			{ \
+				Log::Write((Level), SuppressedCount, __VA_ARGS__); \
+			} \
+		} \
+	} while (0)
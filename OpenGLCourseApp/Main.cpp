@@ -4,6 +4,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include <cmath>
+#include <chrono>
+#include <thread>
 #include <vector>
 
 #include <GL/glew.h>
@@ -26,54 +28,166 @@
 #include "Material.h"
 #include "Skybox.h"
 #include "Model.h"
+#include "JobSystem.h"
+#include "FramePrep.h"
+#include "Profiler.h"
+#include "CommandBuffer.h"
+#include "ShaderWatcher.h"
+#include "ShaderPermutations.h"
+#include "RenderGraph.h"
+#include "AssetManager.h"
+#include "GPUMemory.h"
+#include "FrameAllocator.h"
+#include "Log.h"
+#include "InputState.h"
+#include "SimulationClock.h"
+#include "FramePipeline.h"
+#include "CameraBuffer.h"
+#include "FramePacer.h"
+#include "DynamicResolution.h"
+#include "Upscaler.h"
+#include "OverdrawMonitor.h"
+#include "GPUTimer.h"
+#include "ShadowMomentFilter.h"
+#include "ShadowScheduler.h"
 
 #include "assimp/Importer.hpp"
 
 const float ToRadians = 3.14159265f / 180.0f;
+const size_t GPUMemoryBudget = 512 * 1024 * 1024;
+const size_t AssetCacheBudget = 256 * 1024 * 1024;		// Assets nothing refers to any more are evicted past this
+const size_t FrameArenaSize = 1024 * 1024;
+
+// Frames the simulation may have queued or in progress ahead of the one being drawn, & frames the GPU may lag behind
+const unsigned int PipelineDepth = 3;
+const unsigned int MaxGPUFramesInFlight = 2;
+
+// Frames after this many are expected to make no general heap allocations
+const unsigned int WarmupFrames = 120;
+const unsigned int HeapReportInterval = 300;
+const unsigned int LatencyReportInterval = 300;
+const unsigned int ResolutionReportInterval = 300;
 
 GLWindow MainWindow;
-std::vector<Mesh*> Meshes;
-std::vector<Shader> Shaders;
+InputState Input;
+
+// Declared before everything holding its assets, so it is destroyed after them
+AssetManager Assets;
+
+std::vector<std::shared_ptr<Mesh>> Meshes;
+ShaderPermutations LitShaders;
+Shader* LitShader = nullptr;
 Shader DirectionalShadowShader;
 Shader OmniShadowShader;
+Shader SpotShadowShader;
+Shader DepthPrepassShader;
 
+// Stepped by the simulation, the render camera sits between the last two steps
+// The camera & lights belong to the simulation thread, the GL thread draws from the packet copies
 Camera MyCamera;
+Camera PreviousCamera;
+Camera RenderCamera;
 
 DirectionalLight MainLight;
 PointLight PointLights[MAX_POINT_LIGHTS];
 SpotLight SpotLights[MAX_SPOT_LIGHTS];
 
-Texture BrickTexture;
-Texture DirtTexture;
-Texture PlainTexture;
-Texture SoilTexture;
+std::shared_ptr<Texture> BrickTexture;
+std::shared_ptr<Texture> DirtTexture;
+std::shared_ptr<Texture> PlainTexture;
+std::shared_ptr<Texture> SoilTexture;
 
 Material ShinyMaterial;
 Material DullMaterial;
 
 Skybox MySkybox;
 
-Model XWing;
-Model Chopper;
+std::shared_ptr<Model> XWing;
+std::shared_ptr<Model> Chopper;
 
-GLfloat DeltaTime = 0.0f;
-GLfloat LastTime = 0.0f;
+// Simulation runs at a fixed rate whatever the frame rate, rendering blends the last two steps
+SimulationClock SimClock;
+const double SimulationRate = 120.0;
+const unsigned int MaxSimulationSteps = 8;
 
 GLfloat ChopperAngle = 0.0f;
+GLfloat PreviousChopperAngle = 0.0f;
+
+// Degrees per second, the old 0.8 per frame at 60 FPS
+const GLfloat ChopperSpeed = 48.0f;
+
+// Scene description & per-frame prepared data
+JobSystem Jobs;
+FrameAllocator FrameMemory;
+// The simulation thread only writes OrbitAngle, the GL thread only reads the other members
+std::vector<SceneObject> SceneObjects;
+size_t ChopperIndex = 0;
+std::vector<PointLight*> OmniLights;
+
+// Frames are simulated & prepared on their own thread while the GL thread draws the previous one
+FramePipeline Pipeline;
+GPUFenceRing FrameFences;
+FramePacket* RenderPacket = nullptr;
+std::thread SimulationThread;
+
+// Recorded draws per pass, built on worker threads & replayed on the GL thread
+CommandBuffer DirectionalCommands;
+std::vector<CommandBuffer> OmniCommands;
+CommandBuffer MainCommands;
+CommandBuffer PrepassCommands;
+
+// Passes & their shadow map targets, declared every frame & recompiled only when the topology changes
+RenderGraph FrameGraph;
+RenderResource DirectionalShadowTarget = INVALID_RENDER_RESOURCE;
+std::vector<RenderResource> OmniShadowTargets;
+RenderResource SceneColorTarget = INVALID_RENDER_RESOURCE;
+
+// The main pass renders SceneWidth x SceneHeight, scaled to hold the GPU frame time, & is upscaled to the window
+DynamicResolution ResolutionScaler;
+Upscaler SceneUpscaler;
+const double TargetGPUFrameMilliseconds = 14.0;		// Some slack under a 60Hz refresh
+const float MinResolutionScale = 0.5f;
+const GLfloat MaxUpscaleSharpness = 0.6f;			// Reached at the minimum scale
+GLsizei SceneWidth = 0;
+GLsizei SceneHeight = 0;
+
+// Depth-only pass over the opaque scene before the main pass, so the Phong shader runs once per pixel
+// Worth it only with enough overdraw to pay for drawing the geometry twice
+OverdrawMonitor SceneOverdraw;
+DepthPrepassMode PrepassMode = DEPTH_PREPASS_AUTO;
+const float PrepassEnableOverdraw = 1.6f;
+const float PrepassDisableOverdraw = 1.3f;
+bool bFramePrepass = false;
+
+// Shader hot reload
+ShaderWatcher MyShaderWatcher;
+std::vector<Shader*> ReloadableShaders;
+std::vector<Shader*> FrameShaders;
 
 // Light Settings
 unsigned int PointLightCount = 3;
 unsigned int SpotLightCount = 3;
 
-// Default values for Uniform IDs, updates in While loop per-shader.
-GLuint UniformProjection = 0;
-GLuint UniformView = 0;
-GLuint UniformModel = 0;
-GLuint UniformEyePosition = 0;
-GLuint UniformSpecularIntensity = 0;
-GLuint UniformShininess = 0;
-GLuint UniformOmniLightPosition = 0;
-GLuint UniformFarPlane = 0;
+// Lighting shader settings, compiled into the permutation picked each frame
+ShadowFilter ShadowQuality = SHADOW_FILTER_PCF_HIGH;
+unsigned int ShaderFeatures = SHADER_FEATURE_ALL;
+static const char* ShadowFilterNames[] = { "hard", "PCF low", "PCF high", "EVSM" };
+static_assert(sizeof(ShadowFilterNames) / sizeof(ShadowFilterNames[0]) == SHADOW_FILTER_COUNT, "A shadow filter has no name");
+
+// GPU time of the lit draws alone, per megapixel too, so shadow filters compare without shadow passes or the scale in it
+GPUTimer LitPassTimer;
+
+// Exponent, light bleed reduction, variance bias, blur radius & moments resolution divisor for the EVSM filter
+// Moments are 8 bytes a texel & mipmapped, at full size six point & spot cube maps alone would take ~400MB
+ShadowMomentFilter MomentFilter;
+const ShadowMomentSettings MomentSettings = { 40.0f, 0.2f, 0.00002f, 2, 2 };
+
+// Refreshes per frame, GPU milliseconds for them, importance below which a light goes unshadowed,
+// the intensity a light's range ends at, the spot light atlas size, the smallest map a light gets & the cube map budget.
+// Omni maps not refreshed keep their last contents. The atlas holds four spot maps at their full 1024,
+// the cube map budget two omni maps at their full 1024 & a third at 512.
+ShadowScheduler OmniShadows;
+const ShadowSchedulerSettings SchedulerSettings = { 2, 1.5, 0.01f, 0.02f, 2048, 128, 4096 };
 
 // Shader code file paths
 static const char* VertexShader = "Shaders/shader.vert";
@@ -89,6 +203,25 @@ int ViewportHeight = 768;
 
 bool bEnableFlashlight = false;
 
+// Swap interval, frame cap & on-demand rendering, a kiosk showing a still scene idles instead of redrawing it
+FramePacer Pacer;
+const VSyncMode DefaultVSync = VSYNC_ON;
+const double FrameLimits[] = { 0.0, 30.0, 60.0, 120.0 };		// Frames per second, 0 = uncapped
+const double IdleWaitSeconds = 0.1;								// Longest sleep while idle, pending shader reloads are checked this often
+unsigned int FrameLimitIndex = 0;
+bool bOnDemandRendering = false;
+bool bAnimateScene = true;
+
+// Main pass camera, uploaded right before its draws & optionally turned by input newer than the frame packet
+CameraBuffer MainCameraBuffer;
+bool bLateLatchCamera = true;
+
+// Input-to-present latency of the camera, averaged on the GL thread
+double FrameInputTime = 0.0;
+bool bFrameLateLatched = true;
+double LatencySum = 0.0;
+unsigned int LatencyFrames = 0;
+
 // Vertex Shader
 /*
 Version must match our Major and Minor versions as set in GLFW_CONTEXT_VERSION_MAJOR/MINOR
@@ -197,189 +330,294 @@ void CreateObjects()
 
     CalculateAverageNormals(Indicies, 12, GeometryVertices, 32, 8, 5);
 
-    Mesh* Object1 = new Mesh();
-    Object1->CreateMesh(GeometryVertices, Indicies, 32, 12);
-    Meshes.push_back(Object1);
-
-    Mesh* Object2 = new Mesh();
-    Object2->CreateMesh(GeometryVertices, Indicies, 32, 12);
-    Meshes.push_back(Object2);
+    // Both pyramids draw the same geometry, so they share one set of buffers
+    bool bCreated = false;
+    std::shared_ptr<Mesh> Pyramid = Assets.AcquireMesh("Pyramid", &bCreated);
+    if (bCreated)
+    {
+        Pyramid->CreateMesh(GeometryVertices, Indicies, 32, 12);
+    }
+    Meshes.push_back(Pyramid);
+    Meshes.push_back(Assets.AcquireMesh("Pyramid", &bCreated));
 
-    Mesh* Object3 = new Mesh();
-    Object3->CreateMesh(FloorVertices, FloorIndicies, 32, 6);
-    Meshes.push_back(Object3);
+    std::shared_ptr<Mesh> Floor = Assets.AcquireMesh("Floor", &bCreated);
+    if (bCreated)
+    {
+        Floor->CreateMesh(FloorVertices, FloorIndicies, 32, 6);
+    }
+    Meshes.push_back(Floor);
 }
 
 void CreateShaders()
 {
-    // Base Shader for Phong shading
-    Shader* Shader1 = new Shader();
-    Shader1->CreateFromFiles(VertexShader, FragmentShader);
-    Shaders.push_back(*Shader1);
+    // Base Shader for Phong shading, one permutation per light count & shadow setting
+    // Build the default one up front, then start the other shadow filters in the background so switching doesn't wait
+    LitShaders.Initialize(VertexShader, FragmentShader, &Assets);
+    ShaderPermutationKey LitKey;
+    LitShader = LitShaders.GetShader({ PointLightCount, SpotLightCount, ShadowQuality, ShaderFeatures }, &LitKey);
+
+    ShaderPermutationKey FilterKeys[SHADOW_FILTER_COUNT];
+    for (int i = 0; i < SHADOW_FILTER_COUNT; i++)
+    {
+        FilterKeys[i] = { PointLightCount, SpotLightCount, (ShadowFilter)i, ShaderFeatures };
+    }
+    LitShaders.Prewarm(FilterKeys, SHADOW_FILTER_COUNT);
 
     // Shader for the Directional Shadow Map
-    DirectionalShadowShader = Shader();
     DirectionalShadowShader.CreateFromFiles(DirectionalVertexShader, DirectionalFragmentShader);
 
     // Shader for the Omnidirectional Shadows CubeMap
-    OmniShadowShader = Shader();
     OmniShadowShader.CreateFromFiles(OmniVertexShader, OmniFragmentShader, OmniGeometryShader);
+
+    // The same distance output for a spot light's single perspective map, without the cube's geometry shader
+    SpotShadowShader.SetDefines("#define SPOT_SHADOW\n");
+    SpotShadowShader.CreateFromFiles(OmniVertexShader, OmniFragmentShader);
+
+    // The directional shadow shader again, transformed by the main camera for the depth pre-pass
+    DepthPrepassShader.SetDefines("#define DEPTH_PREPASS\n");
+    DepthPrepassShader.CreateFromFiles(DirectionalVertexShader, DirectionalFragmentShader);
 }
 
-void RenderScene()
+void CreateSceneObjects()
 {
-    //----------------[Start Pyramid 1]--------------------------------
-    // Defines a 4x4 matrix for the Model Matrix (1.0f) initializes as a Identity Matrix
-    glm::mat4 Model(1.0f);
-
-    // Update the Transform by the Model Matrix
+    // Pyramid 1
+    SceneObjects.push_back({ Meshes[0].get(), nullptr, BrickTexture.get(), &DullMaterial,
+                             glm::translate(glm::mat4(1.0f), glm::vec3(-2.0f, 0.0f, -2.5f)),
+                             glm::vec3(0.0f, 1.0f, 0.0f), 0.0f });
+
+    // Pyramid 2
+    SceneObjects.push_back({ Meshes[1].get(), nullptr, DirtTexture.get(), &DullMaterial,
+                             glm::translate(glm::mat4(1.0f), glm::vec3(2.0f, 0.0f, -2.5f)),
+                             glm::vec3(0.0f, 1.0f, 0.0f), 0.0f });
+
+    // Ground
+    SceneObjects.push_back({ Meshes[2].get(), nullptr, SoilTexture.get(), &ShinyMaterial,
+                             glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f)),
+                             glm::vec3(0.0f, 1.0f, 0.0f), 0.0f });
+
+    // X-Wing
+    glm::mat4 XWingTransform(1.0f);
+    XWingTransform = glm::translate(XWingTransform, glm::vec3(-7.0f, 0.0f, 5.0f));
+    XWingTransform = glm::scale(XWingTransform, glm::vec3(0.006f, 0.006f, 0.006f));
+    SceneObjects.push_back({ nullptr, XWing.get(), nullptr, &ShinyMaterial,
+                             XWingTransform,
+                             glm::vec3(0.0f, 1.0f, 0.0f), 0.0f });
+
+    // Chopper, orbits around the world Y axis
     // Note these are applied in reverse order to the object
-    Model = glm::translate(Model, glm::vec3(-2.0f, 0.0f, -2.5f));
-
-    // Bind the Uniform Model Matrix
-    glUniformMatrix4fv(UniformModel, 1, GL_FALSE, glm::value_ptr(Model));
-
-    // Use Brick Texture
-    BrickTexture.UseTexture();
+    glm::mat4 ChopperTransform(1.0f);
+    ChopperTransform = glm::translate(ChopperTransform, glm::vec3(-8.0f, 2.0f, 0.0f));
+    ChopperTransform = glm::rotate(ChopperTransform, 270 * ToRadians, glm::vec3(1.0f, 0.0f, 0.0f));
+    ChopperTransform = glm::rotate(ChopperTransform, 180 * ToRadians, glm::vec3(0.0f, 0.0f, 1.0f));
+    ChopperTransform = glm::rotate(ChopperTransform, -30 * ToRadians, glm::vec3(0.0f, 1.0f, 0.0f));
+    ChopperTransform = glm::scale(ChopperTransform, glm::vec3(0.2f, 0.2f, 0.2f));
+    SceneObjects.push_back({ nullptr, Chopper.get(), nullptr, &DullMaterial,
+                             ChopperTransform,
+                             glm::vec3(0.0f, 1.0f, 0.0f), ChopperAngle });
+    ChopperIndex = SceneObjects.size() - 1;
+}
 
-    // Use shiny Material
-    DullMaterial.UseMaterial(UniformSpecularIntensity, UniformShininess);
+void RecordScene(const std::vector<unsigned int>& DrawList, Shader* PassShader, bool bDepthOnly, CommandBuffer* Commands)
+{
+    PROFILE_SCOPE("RecordScene");
 
-    // Render mesh 0
-    Meshes[0]->RenderMesh();
-    //----------------[End Pyramid 1]--------------------------------
+    // Safe on any thread, only reads prepared frame data & records into this pass' own buffer
+    Commands->Reset();
+    Commands->BindProgram(PassShader->GetShaderID());
 
-    //----------------[Start Pyramid 2]--------------------------------
-    // Refresh & create new Model info for 2nd Mesh, View & Projection is re-used
-    Model = glm::mat4(1.0f);
-    Model = glm::translate(Model, glm::vec3(2.0f, 0.0f, -2.5f));
-    glUniformMatrix4fv(UniformModel, 1, GL_FALSE, glm::value_ptr(Model));
+    GLuint ModelLocation = PassShader->GetModelLocation();
+    GLuint SpecularIntensityLocation = PassShader->GetSpecularIntensityLocation();
+    GLuint ShininessLocation = PassShader->GetShininessLocation();
 
-    // Use Dirt Texture
-    DirtTexture.UseTexture();
+    for (size_t i = 0; i < DrawList.size(); i++)
+    {
+        unsigned int ObjectIndex = DrawList[i];
+        const SceneObject& Object = SceneObjects[ObjectIndex];
 
-    // Use dull Material
-    DullMaterial.UseMaterial(UniformSpecularIntensity, UniformShininess);
+        // Bind the Uniform Model Matrix
+        Commands->SetUniformMatrix4(ModelLocation, RenderPacket->Frame.WorldTransforms[ObjectIndex]);
 
-    // Render mesh
-    Meshes[1]->RenderMesh();
-    //----------------[End Pyramid 2]--------------------------------
+        // Depth passes have no texture or material uniforms
+        if (!bDepthOnly)
+        {
+            // Models bind their own textures per sub-mesh
+            if (Object.MyTexture)
+            {
+                Object.MyTexture->RecordTexture(Commands);
+            }
 
-    //----------------[Start Ground]--------------------------------
-    // Refresh & create new Model info for floor Mesh, View & Projection is re-used
-    Model = glm::mat4(1.0f);
-    Model = glm::translate(Model, glm::vec3(0.0f, -1.0f, 0.0f));
-    glUniformMatrix4fv(UniformModel, 1, GL_FALSE, glm::value_ptr(Model));
+            Object.MyMaterial->RecordMaterial(Commands, SpecularIntensityLocation, ShininessLocation);
+        }
 
-    // Use Dirt Texture
-    SoilTexture.UseTexture();
+        if (Object.MyModel)
+        {
+            Object.MyModel->RecordModel(Commands, !bDepthOnly);
+        }
+        else
+        {
+            Object.MyMesh->RecordMesh(Commands);
+        }
+    }
+}
 
-    // Use dull Material
-    ShinyMaterial.UseMaterial(UniformSpecularIntensity, UniformShininess);
+// Point lights draw a cube map, spot lights one perspective map
+Shader* GetLightShadowShader(PointLight* Light)
+{
+    return Light->GetShadowMap()->GetTextureTarget() == GL_TEXTURE_CUBE_MAP ? &OmniShadowShader : &SpotShadowShader;
+}
 
-    // Render mesh
-    Meshes[2]->RenderMesh();
+void RecordPasses()
+{
+    PROFILE_SCOPE("RecordPasses");
 
-    //----------------[End Ground]--------------------------------
+    // Every pass records into its own buffer, so shadow & main passes build concurrently
+    OmniCommands.resize(RenderPacket->OmniLights.size());
+    JobCounter RecordCounter;
 
-    //----------------[Start X-Wing]--------------------------------
-    // Refresh & create new Model info for floor Mesh, View & Projection is re-used
-    Model = glm::mat4(1.0f);
-    Model = glm::translate(Model, glm::vec3(-7.0f, 0.0f, 5.0f));
-    Model = glm::scale(Model, glm::vec3(0.006f, 0.006f, 0.006f));
-    glUniformMatrix4fv(UniformModel, 1, GL_FALSE, glm::value_ptr(Model));
+    Jobs.Run(&RecordCounter, []()
+    {
+        RecordScene(RenderPacket->Frame.DirectionalDrawList, &DirectionalShadowShader, true, &DirectionalCommands);
+    }, "RecordDirectionalShadowPass");
 
-    // Use shiny Material
-    ShinyMaterial.UseMaterial(UniformSpecularIntensity, UniformShininess);
+    // Only the shadow maps being refreshed draw anything this frame
+    for (size_t i = 0; i < RenderPacket->OmniLights.size(); i++)
+    {
+        if (!OmniShadows.IsRefreshing(i))
+        {
+            continue;
+        }
 
-    // Render mesh
-    XWing.RenderModel();
-    //----------------[End X-Wing]--------------------------------
+        Jobs.Run(&RecordCounter, [i]()
+        {
+            RecordScene(RenderPacket->Frame.OmniDrawLists[i], GetLightShadowShader(RenderPacket->OmniLights[i]), true, &OmniCommands[i]);
+        }, "RecordOmniShadowPass");
+    }
 
+    Jobs.Run(&RecordCounter, []()
+    {
+        RecordScene(RenderPacket->Frame.MainDrawList, LitShader, false, &MainCommands);
+    }, "RecordMainPass");
 
-    //----------------[Start Chopper]--------------------------------
-    // Refresh & create new Model info for floor Mesh, View & Projection is re-used
-    ChopperAngle += 0.1f;
-    if (ChopperAngle > 360)
+    if (bFramePrepass)
     {
-        ChopperAngle = 0.1;
+        Jobs.Run(&RecordCounter, []()
+        {
+            RecordScene(RenderPacket->Frame.MainDrawList, &DepthPrepassShader, true, &PrepassCommands);
+        }, "RecordDepthPrepass");
     }
 
-    Model = glm::mat4(1.0f);
-    Model = glm::rotate(Model, ChopperAngle * ToRadians, glm::vec3(0.0f, 1.0f, 0.0f));
-    Model = glm::translate(Model, glm::vec3(-8.0f, 2.0f, 0.0f));
-    Model = glm::rotate(Model, 270 * ToRadians, glm::vec3(1.0f, 0.0f, 0.0f));
-    Model = glm::rotate(Model, 180 * ToRadians, glm::vec3(0.0f, 0.0f, 1.0f));
-    Model = glm::rotate(Model, -30 * ToRadians, glm::vec3(0.0f, 1.0f, 0.0f));
-    Model = glm::scale(Model, glm::vec3(0.2f, 0.2f, 0.2f));
-    glUniformMatrix4fv(UniformModel, 1, GL_FALSE, glm::value_ptr(Model));
-
-    // Use shiny Material
-    DullMaterial.UseMaterial(UniformSpecularIntensity, UniformShininess);
-
-    // Render mesh
-    Chopper.RenderModel();
-    //----------------[End Chopper]--------------------------------
+    Jobs.Wait(&RecordCounter);
 }
 
-void DirectionalShadowMapPass(DirectionalLight* Light)
+void DirectionalShadowMapPass()
 {
-    DirectionalShadowShader.UseShader();
+    PROFILE_SCOPE("DirectionalShadowMapPass");
 
-    // Sets the viewport to the same dimensions as the framebuffer
-    glViewport(0, 0, Light->GetShadowMap()->GetShadowWidth(), Light->GetShadowMap()->GetShadowHeight());
+    DirectionalShadowShader.UseShader();
 
-    // Enable depth buffer writing to shadow map
-    Light->GetShadowMap()->Write();
+    // The graph already bound the shadow map target & matched the viewport to it
     glClear(GL_DEPTH_BUFFER_BIT);
 
     // Set up uniforms for shader
-    UniformModel = DirectionalShadowShader.GetModelLocation();
-    DirectionalShadowShader.SetDirectionalLightTransform(&Light->CalculateLightTransform());
+    DirectionalShadowShader.SetDirectionalLightTransform(&RenderPacket->Frame.DirectionalLightTransform);
 
     // Validate the Shader before Rendering
     DirectionalShadowShader.ValidateShader();
 
     // Render the depth pass
-    RenderScene();
-
-    // Unbinds frame buffer
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    DirectionalCommands.Execute();
 }
 
-void OmniShadowMapPass(PointLight* Light)
+// bAtlasTile: a spot light drawing straight into its tile of the atlas
+void OmniShadowMapPass(PointLight* Light, size_t ShadowIndex, bool bAtlasTile)
 {
-    OmniShadowShader.UseShader();
+    // Declared for cached maps too so the graph keeps its topology, only a refresh draws
+    if (!OmniShadows.IsRefreshing(ShadowIndex))
+    {
+        return;
+    }
 
-    // Sets the viewport to the same dimensions as the framebuffer
-    glViewport(0, 0, Light->GetShadowMap()->GetShadowWidth(), Light->GetShadowMap()->GetShadowHeight());
+    PROFILE_SCOPE("OmniShadowMapPass");
+    OmniShadows.BeginRefreshTiming();
 
-    // Enable depth buffer writing to shadow map
-    Light->GetShadowMap()->Write();
+    bool bCube = Light->GetShadowMap()->GetTextureTarget() == GL_TEXTURE_CUBE_MAP;
+    Shader* PassShader = GetLightShadowShader(Light);
+    PassShader->UseShader();
+
+    // The graph already bound the cube or spot map target & matched the viewport to it
+    // Into the atlas both the viewport & the clear are narrowed to the light's tile
+    if (bAtlasTile)
+    {
+        ShadowTile Tile = OmniShadows.GetTile(ShadowIndex);
+        glViewport(Tile.X, Tile.Y, Tile.Size, Tile.Size);
+        glScissor(Tile.X, Tile.Y, Tile.Size, Tile.Size);
+        glEnable(GL_SCISSOR_TEST);
+    }
     glClear(GL_DEPTH_BUFFER_BIT);
 
     // Set up uniforms for shader
-    UniformModel = OmniShadowShader.GetModelLocation();
-    UniformOmniLightPosition = OmniShadowShader.GetOmniLightPositionLocation();
-    UniformFarPlane = OmniShadowShader.GetFarPlaneLocation();
-    glUniform3f(UniformOmniLightPosition, Light->GetPosition().x, Light->GetPosition().y, Light->GetPosition().z);
-    glUniform1f(UniformFarPlane, Light->GetFarPlane());
-    OmniShadowShader.SetOmniLightMatrices(Light->CalculateLightTransforms());
+    PassShader->SetOmniLight(Light->GetPosition(), Light->GetFarPlane());
+    PassShader->SetOmniLightMatrices(&RenderPacket->Frame.OmniLightMatrices[ShadowIndex * 6], bCube ? 6 : 1);
 
     // Validate the Shader before Rendering
-    OmniShadowShader.ValidateShader();
+    PassShader->ValidateShader();
 
     // Render the depth pass
-    RenderScene();
+    OmniCommands[ShadowIndex].Execute();
+
+    if (bAtlasTile)
+    {
+        glDisable(GL_SCISSOR_TEST);
+    }
+}
+
+// View matrix for the main pass, sampled as late as possible
+// Polls input once more & turns the packet's camera by the mouse motion the simulation hasn't seen yet.
+// Only the orientation is latched, movement stays as simulated. Culling used the packet's view,
+// so during a fast turn an object can pop in at the screen edge for a frame.
+glm::mat4 LatchViewMatrix(FramePacket* Packet)
+{
+    bFrameLateLatched = Packet->bLateLatch;
+    if (!Packet->bLateLatch)
+    {
+        FrameInputTime = Packet->InputSampleTime;
+        return Packet->Frame.View;
+    }
 
-    // Unbinds frame buffer
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glfwPollEvents();
+    FrameInputTime = glfwGetTime();
+
+    Camera Latched = Packet->ViewCamera;
+    Latched.MouseControl((GLfloat)(MainWindow.GetMouseTotalX() - Packet->InputMouseTotalX),
+                         (GLfloat)(MainWindow.GetMouseTotalY() - Packet->InputMouseTotalY));
+    return Latched.CalculateViewMatrix();
 }
 
-void RenderPass(glm::mat4 ProjectionMatrix, glm::mat4 ViewMatrix)
+void RenderPass()
 {
-    // Verify viewport settings (In case they were changed by depth buffer/etc
-    glViewport(0, 0, ViewportWidth, ViewportHeight);
+    PROFILE_SCOPE("RenderPass");
+
+    // Every omni refresh ran before this pass
+    OmniShadows.EndRefreshTiming();
+
+    // The directional map is a transient graph target, the point & spot maps are the scheduler's cached ones
+    // or its fallback, hand this frame's textures to the lights before binding them
+    bool bShadowMoments = RenderPacket->ShadowQuality == SHADOW_FILTER_EVSM;
+    RenderPacket->MainLight.GetShadowMap()->SetTexture(FrameGraph.GetTexture(DirectionalShadowTarget));
+    for (size_t i = 0; i < RenderPacket->OmniLights.size(); i++)
+    {
+        RenderPacket->OmniLights[i]->GetShadowMap()->SetTexture(OmniShadows.GetTexture(i, bShadowMoments));
+    }
+
+    // The graph matched the viewport to the full size target, the scaled frame covers only its corner
+    glViewport(0, 0, SceneWidth, SceneHeight);
+
+    // Camera block for the skybox & lit draws below, written as late as the frame allows
+    CameraBlockData CameraData;
+    CameraData.View = LatchViewMatrix(RenderPacket);
+    CameraData.Projection = RenderPacket->Frame.Projection;
+    CameraData.EyePosition = glm::vec4(RenderPacket->EyePosition, 1.0f);
+    MainCameraBuffer.Update(CameraData);
 
     // Clear window
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -387,88 +625,529 @@ void RenderPass(glm::mat4 ProjectionMatrix, glm::mat4 ViewMatrix)
     // Clear the color & depth buffer bits
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    // Lay down the scene's depth first, the first depth tested scene draw is the one counting overdraw
+    unsigned long long ScenePixels = (unsigned long long)SceneWidth * SceneHeight;
+    if (bFramePrepass)
+    {
+        PROFILE_SCOPE("DepthPrepass");
+
+        DepthPrepassShader.UseShader();
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+        SceneOverdraw.BeginMeasure();
+        PrepassCommands.Execute();
+        SceneOverdraw.EndMeasure(ScenePixels);
+
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    }
+
     // Draw Skybox
-    printf("Drawing Skybox...\n");
-    MySkybox.DrawSkybox(ViewMatrix, ProjectionMatrix);
+    LOG_TRACE("Drawing Skybox...");
+    MySkybox.DrawSkybox(CameraData.View, CameraData.Projection);
 
     // Assign the Shader Program
-    Shaders[0].UseShader();
+    LitShader->UseShader();
 
-    // Set uniform IDs based on shader IDs
-    UniformModel = Shaders[0].GetModelLocation();
-    UniformProjection = Shaders[0].GetProjectionLocation();
-    UniformView = Shaders[0].GetViewLocation();
-    UniformEyePosition = Shaders[0].GetEyePositionLocation();
-    UniformSpecularIntensity = Shaders[0].GetSpecularIntensityLocation();
-    UniformShininess = Shaders[0].GetShininessLocation();
+    // Spot maps are sampled through the projection they were drawn with, which may be a few frames old,
+    // narrowed to the light's tile of the atlas, with filter taps kept inside the tile
+    glm::mat4 SpotShadowTransforms[MAX_SPOT_LIGHTS];
+    glm::vec4 SpotShadowBounds[MAX_SPOT_LIGHTS];
+    for (size_t i = 0; i < SpotLightCount; i++)
+    {
+        SpotShadowTransforms[i] = OmniShadows.GetTransform(PointLightCount + i);
+        SpotShadowBounds[i] = OmniShadows.GetTileBounds(PointLightCount + i);
+    }
 
     // Sets up light in shaders
-    Shaders[0].SetDirectionalLight(&MainLight);
-    Shaders[0].SetPointLights(PointLights, PointLightCount, 3, 0);
-    Shaders[0].SetSpotLights(SpotLights, SpotLightCount, 3 + PointLightCount, PointLightCount);
-    Shaders[0].SetDirectionalLightTransform(&MainLight.CalculateLightTransform());
+    LitShader->SetDirectionalLight(&RenderPacket->MainLight);
+    LitShader->SetPointLights(RenderPacket->PointLights, PointLightCount, 3, 0);
+    LitShader->SetSpotLights(RenderPacket->SpotLights, SpotLightCount, 3 + PointLightCount, SpotShadowTransforms, SpotShadowBounds);
+    LitShader->SetDirectionalLightTransform(&RenderPacket->Frame.DirectionalLightTransform);
+    if (RenderPacket->ShadowQuality == SHADOW_FILTER_EVSM)
+    {
+        MomentFilter.SetLightingUniforms(LitShader);
+    }
 
-    MainLight.GetShadowMap()->Read(GL_TEXTURE2);
+    RenderPacket->MainLight.GetShadowMap()->Read(GL_TEXTURE2);
 
     // Set GL_TEXTURE1 as Texture and GL_TEXTURE2 as the Shadow Map (0 reserved for defaults)
-    Shaders[0].SetTexture(1);
-    Shaders[0].SetDirectionalShadowMap(2);
-
-    // Bind the Uniform Perspective / Projection Matrix
-    glUniformMatrix4fv(UniformProjection, 1, GL_FALSE, glm::value_ptr(ProjectionMatrix));
+    LitShader->SetTexture(1);
+    LitShader->SetDirectionalShadowMap(2);
 
-    // Bind the Camera / View Matrix
-    glUniformMatrix4fv(UniformView, 1, GL_FALSE, glm::value_ptr(ViewMatrix));
+    // Projection, View & Eye Position come from the camera block bound above
 
-    // Bind the Eye Position based on the Camera location
-    glUniform3f(UniformEyePosition, MyCamera.GetCameraPosition().x, MyCamera.GetCameraPosition().y, MyCamera.GetCameraPosition().z);
+    // Validate the Shader before Rendering
+    LitShader->ValidateShader();
 
-    // Attach Flashlight Spotlight
-    if (bEnableFlashlight)
+    // Render the scene
+    // After a pre-pass only the nearest fragment of each pixel matches the depth buffer, so only it gets shaded
+    LitPassTimer.Begin();
+    if (bFramePrepass)
     {
-        glm::vec3 FlashlightOffset = MyCamera.GetCameraPosition();
-        FlashlightOffset.y -= 0.1f;
-        SpotLights[1].SetFlash(FlashlightOffset, MyCamera.GetCameraDirection());
-        SpotLights[1].ToggleSpotlight(bEnableFlashlight);
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+        MainCommands.Execute();
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
     }
     else
     {
-        SpotLights[1].ToggleSpotlight(bEnableFlashlight);
+        SceneOverdraw.BeginMeasure();
+        MainCommands.Execute();
+        SceneOverdraw.EndMeasure(ScenePixels);
     }
+    LitPassTimer.End(ScenePixels / 1000000.0);
+}
 
-    
-    // Validate the Shader before Rendering
-    Shaders[0].ValidateShader();
+// Warps a depth shadow map into blurred, mipmapped moments for the EVSM filter, returns the moments target
+// With a ShadowIndex the moments go to the scheduler's map for that light & are only rebuilt when it refreshes
+RenderResource AddShadowMomentPasses(RenderResource DepthTarget, const RenderTargetDesc& DepthDesc, int ShadowIndex)
+{
+    bool bCube = DepthDesc.Target == GL_TEXTURE_CUBE_MAP;
+    GLsizei Width = MomentFilter.ScaleSize(DepthDesc.Width);
+    GLsizei Height = MomentFilter.ScaleSize(DepthDesc.Height);
+    RenderTargetDesc BlurredDesc = { DepthDesc.Target, Width, Height, GL_RG32F, 0 };
+    RenderTargetDesc MomentsDesc = { DepthDesc.Target, Width, Height, GL_RG32F, RenderGraph::CalculateMipLevels(Width, Height) };
 
-    // Render the depth pass
-    RenderScene();
+    RenderResource BlurredTarget = FrameGraph.CreateTarget("ShadowMomentsBlurX", BlurredDesc);
+    RenderResource MomentsTarget = ShadowIndex < 0 ? FrameGraph.CreateTarget("ShadowMoments", MomentsDesc) :
+        FrameGraph.ImportTarget("ShadowMoments", MomentsDesc, OmniShadows.AcquireMap(ShadowIndex, MomentsDesc));
+
+    FrameGraph.AddPass("ShadowMomentsBlurXPass", { DepthTarget }, { BlurredTarget }, [DepthTarget, bCube, Width, Height, ShadowIndex]()
+    {
+        if (ShadowIndex >= 0 && !OmniShadows.IsRefreshing(ShadowIndex))
+        {
+            return;
+        }
+        MomentFilter.Blur(FrameGraph.GetTexture(DepthTarget), bCube, true, false, 0, 0, Width, Height);
+    });
+    FrameGraph.AddPass("ShadowMomentsBlurYPass", { BlurredTarget }, { MomentsTarget }, [BlurredTarget, MomentsTarget, bCube, Width, Height, ShadowIndex]()
+    {
+        if (ShadowIndex >= 0 && !OmniShadows.IsRefreshing(ShadowIndex))
+        {
+            return;
+        }
+        MomentFilter.Blur(FrameGraph.GetTexture(BlurredTarget), bCube, false, true, 0, 0, Width, Height);
+        MomentFilter.GenerateMips(bCube ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D, FrameGraph.GetTexture(MomentsTarget));
+    });
+
+    return MomentsTarget;
+}
+
+// A spot light's map is its tile of the scheduler's atlas, drawn straight into it, or for EVSM drawn into
+// a transient depth target the tile's size & blurred into the moments atlas
+void AddSpotShadowPasses(size_t ShadowIndex, RenderResource AtlasTarget, bool bShadowMoments)
+{
+    if (!bShadowMoments)
+    {
+        FrameGraph.AddPass("SpotShadowMapPass", {}, { AtlasTarget }, [ShadowIndex]()
+        {
+            OmniShadowMapPass(RenderPacket->OmniLights[ShadowIndex], ShadowIndex, true);
+        });
+        return;
+    }
+
+    // The moments atlas & its tiles are scaled down alike, tiles are aligned to their size so the corner scales exactly
+    ShadowTile Tile = OmniShadows.GetTile(ShadowIndex);
+    GLsizei Size = MomentFilter.ScaleSize(Tile.Size);
+    GLint X = Tile.X / Tile.Size * Size;
+    GLint Y = Tile.Y / Tile.Size * Size;
+
+    RenderResource DepthTarget = FrameGraph.CreateTarget("SpotShadowMap", { GL_TEXTURE_2D, Tile.Size, Tile.Size, GL_DEPTH_COMPONENT, 0 });
+    RenderResource BlurredTarget = FrameGraph.CreateTarget("ShadowMomentsBlurX", { GL_TEXTURE_2D, Size, Size, GL_RG32F, 0 });
+
+    FrameGraph.AddPass("SpotShadowMapPass", {}, { DepthTarget }, [ShadowIndex]()
+    {
+        OmniShadowMapPass(RenderPacket->OmniLights[ShadowIndex], ShadowIndex, false);
+    });
+    FrameGraph.AddPass("ShadowMomentsBlurXPass", { DepthTarget }, { BlurredTarget }, [DepthTarget, Size, ShadowIndex]()
+    {
+        if (!OmniShadows.IsRefreshing(ShadowIndex))
+        {
+            return;
+        }
+        MomentFilter.Blur(FrameGraph.GetTexture(DepthTarget), false, true, false, 0, 0, Size, Size);
+    });
+    FrameGraph.AddPass("ShadowMomentsBlurYPass", { BlurredTarget }, { AtlasTarget }, [BlurredTarget, X, Y, Size, ShadowIndex]()
+    {
+        if (!OmniShadows.IsRefreshing(ShadowIndex))
+        {
+            return;
+        }
+        MomentFilter.Blur(FrameGraph.GetTexture(BlurredTarget), false, false, true, X, Y, Size, Size);
+    });
+}
+
+void UpscalePass()
+{
+    PROFILE_SCOPE("UpscalePass");
+
+    // Sharpen more the further the frame was scaled down, at full scale it is a straight copy
+    GLfloat Sharpness = MaxUpscaleSharpness * (1.0f - ResolutionScaler.GetScale()) / (1.0f - MinResolutionScale);
+    SceneUpscaler.Draw(FrameGraph.GetTexture(SceneColorTarget), SceneWidth, SceneHeight, ViewportWidth, ViewportHeight, Sharpness);
+}
+
+void BuildFrameGraph()
+{
+    PROFILE_SCOPE("BuildFrameGraph");
+
+    FrameGraph.BeginFrame(FrameMemory.GetArena());
+    RenderResource Backbuffer = FrameGraph.ImportBackbuffer("Backbuffer", ViewportWidth, ViewportHeight);
+
+    // EVSM lights from moments built out of each depth map, the other filters sample the depth maps directly
+    bool bShadowMoments = RenderPacket->ShadowQuality == SHADOW_FILTER_EVSM;
+
+    // Directional Shadow Pass, shadow maps shrink while over the GPU memory budget
+    ShadowMap* DirectionalMap = RenderPacket->MainLight.GetShadowMap();
+    RenderTargetDesc DirectionalDesc = { DirectionalMap->GetTextureTarget(), GPUMemory::ScaleShadowSize(DirectionalMap->GetShadowWidth()),
+                                         GPUMemory::ScaleShadowSize(DirectionalMap->GetShadowHeight()), GL_DEPTH_COMPONENT, 0 };
+    RenderResource DirectionalDepth = FrameGraph.CreateTarget("DirectionalShadowMap", DirectionalDesc);
+    FrameGraph.AddPass("DirectionalShadowMapPass", {}, { DirectionalDepth }, []()
+    {
+        DirectionalShadowMapPass();
+    });
+    DirectionalShadowTarget = bShadowMoments ? AddShadowMomentPasses(DirectionalDepth, DirectionalDesc, -1) : DirectionalDepth;
+
+    std::pmr::vector<RenderResource> LitReads({ DirectionalShadowTarget }, FrameMemory.GetArena());
+
+    // Omnidirectional Cube Map Passes for Point Lights, then a single perspective map per Spot Light
+    // Maps the lit pass reads are the scheduler's, they keep their contents in the frames they aren't refreshed.
+    // Only EVSM's depth & blur targets in between are transient. Every spot light shares the one atlas.
+    RenderResource SpotAtlas = INVALID_RENDER_RESOURCE;
+    OmniShadowTargets.resize(RenderPacket->OmniLights.size());
+    for (size_t i = 0; i < RenderPacket->OmniLights.size(); i++)
+    {
+        // Unshadowed & switched off lights read the scheduler's fallback map, nothing is drawn for them
+        ShadowState State = OmniShadows.GetState(i);
+        if (State == SHADOW_STATE_FALLBACK || State == SHADOW_STATE_DISABLED)
+        {
+            OmniShadowTargets[i] = INVALID_RENDER_RESOURCE;
+            continue;
+        }
+
+        if (RenderPacket->OmniLights[i]->GetShadowMap()->GetTextureTarget() != GL_TEXTURE_CUBE_MAP)
+        {
+            if (SpotAtlas == INVALID_RENDER_RESOURCE)
+            {
+                GLsizei AtlasSize = bShadowMoments ? MomentFilter.ScaleSize(OmniShadows.GetAtlasSize()) : OmniShadows.GetAtlasSize();
+                RenderTargetDesc AtlasDesc = { GL_TEXTURE_2D, AtlasSize, AtlasSize, bShadowMoments ? (GLenum)GL_RG32F : (GLenum)GL_DEPTH_COMPONENT,
+                                               bShadowMoments ? RenderGraph::CalculateMipLevels(AtlasSize, AtlasSize) : 0 };
+                SpotAtlas = FrameGraph.ImportTarget("SpotShadowAtlas", AtlasDesc, OmniShadows.AcquireAtlas(AtlasDesc));
+                LitReads.push_back(SpotAtlas);
+            }
+            AddSpotShadowPasses(i, SpotAtlas, bShadowMoments);
+            OmniShadowTargets[i] = SpotAtlas;
+            continue;
+        }
+
+        // Sized by the scheduler from the light's screen coverage
+        GLsizei OmniSize = OmniShadows.GetResolution(i);
+        RenderTargetDesc OmniDesc = { GL_TEXTURE_CUBE_MAP, OmniSize, OmniSize, GL_DEPTH_COMPONENT, 0 };
+        RenderResource OmniDepth = bShadowMoments ? FrameGraph.CreateTarget("OmniShadowMap", OmniDesc) :
+            FrameGraph.ImportTarget("OmniShadowMap", OmniDesc, OmniShadows.AcquireMap(i, OmniDesc));
+        FrameGraph.AddPass("OmniShadowMapPass", {}, { OmniDepth }, [i]()
+        {
+            OmniShadowMapPass(RenderPacket->OmniLights[i], i, false);
+        });
+        OmniShadowTargets[i] = bShadowMoments ? AddShadowMomentPasses(OmniDepth, OmniDesc, (int)i) : OmniDepth;
+        LitReads.push_back(OmniShadowTargets[i]);
+    }
+
+    // The moments atlas is mipmapped once, after every tile refreshed this frame was blurred into it
+    if (bShadowMoments && SpotAtlas != INVALID_RENDER_RESOURCE)
+    {
+        FrameGraph.AddPass("SpotShadowAtlasMipsPass", { SpotAtlas }, { SpotAtlas }, [SpotAtlas]()
+        {
+            if (OmniShadows.IsAtlasRefreshing())
+            {
+                MomentFilter.GenerateMips(GL_TEXTURE_2D, FrameGraph.GetTexture(SpotAtlas));
+            }
+        });
+    }
+
+    // Scene targets are allocated at full size & only the scaled corner is drawn, so a new scale
+    // moves the viewport instead of recompiling the graph & reallocating its textures
+    SceneColorTarget = FrameGraph.CreateTarget("SceneColor", { GL_TEXTURE_2D, ViewportWidth, ViewportHeight, GL_RGBA8, 0 });
+    RenderResource SceneDepthTarget = FrameGraph.CreateTarget("SceneDepth", { GL_TEXTURE_2D, ViewportWidth, ViewportHeight, GL_DEPTH_COMPONENT24, 0 });
+
+    // Phong Shader Render Pass
+    // Captures stay small enough for std::function's inline storage, the camera is latched inside the pass
+    FrameGraph.AddPass("RenderPass", LitReads, { SceneColorTarget, SceneDepthTarget }, []()
+    {
+        RenderPass();
+    });
+
+    FrameGraph.AddPass("UpscalePass", { SceneColorTarget }, { Backbuffer }, []()
+    {
+        UpscalePass();
+    });
+}
+
+// One fixed step of everything that changes over time: input, camera, toggles & animation
+void SimulateStep(GLfloat StepSeconds, double StepEndTime, unsigned int* OutRequests)
+{
+    PreviousCamera = MyCamera;
+    PreviousChopperAngle = ChopperAngle;
+
+    Input.Update(MainWindow.GetInputQueue(), StepEndTime);
+
+    // Pass key inputs from Window to the Camera
+    MyCamera.KeyControl(Input.GetKeys(), StepSeconds);
+    MyCamera.MouseControl(Input.ConsumeChangeX(), Input.ConsumeChangeY());
+
+    // Toggles Flashlight Spotlight on & off
+    if (Input.WasPressed(GLFW_KEY_F))
+    {
+        bEnableFlashlight = !bEnableFlashlight;
+    }
+
+    // Switches late latching of the camera on & off, to compare the reported latency
+    if (Input.WasPressed(GLFW_KEY_L))
+    {
+        bLateLatchCamera = !bLateLatchCamera;
+    }
+
+    // Switches between redrawing every frame & only when something changed
+    if (Input.WasPressed(GLFW_KEY_O))
+    {
+        bOnDemandRendering = !bOnDemandRendering;
+        LOG_INFO("On demand rendering %s", bOnDemandRendering ? "on" : "off");
+    }
+
+    // Pauses & resumes the animation, a paused scene lets on demand rendering idle
+    if (Input.WasPressed(GLFW_KEY_SPACE))
+    {
+        bAnimateScene = !bAnimateScene;
+    }
+
+    // Cycles vsync off -> on -> adaptive, & the frame rate cap, both set on the GL thread
+    if (Input.WasPressed(GLFW_KEY_V))
+    {
+        *OutRequests |= FRAME_REQUEST_CYCLE_VSYNC;
+    }
+    if (Input.WasPressed(GLFW_KEY_C))
+    {
+        *OutRequests |= FRAME_REQUEST_CYCLE_FRAME_LIMIT;
+    }
+
+    // Cycles the depth pre-pass auto -> off -> on
+    if (Input.WasPressed(GLFW_KEY_Z))
+    {
+        *OutRequests |= FRAME_REQUEST_CYCLE_DEPTH_PREPASS;
+    }
+
+    // Switches dynamic resolution on & off, off renders at full size
+    if (Input.WasPressed(GLFW_KEY_R))
+    {
+        *OutRequests |= FRAME_REQUEST_TOGGLE_DYNAMIC_RESOLUTION;
+    }
+
+    // Cycles the shadow filter quality, hard -> low PCF -> high PCF -> EVSM
+    if (Input.WasPressed(GLFW_KEY_G))
+    {
+        ShadowQuality = (ShadowFilter)((ShadowQuality + 1) % SHADOW_FILTER_COUNT);
+    }
+
+    // Prints GPU memory use by category & what the driver reports, queries the driver so it runs on the GL thread
+    if (Input.WasPressed(GLFW_KEY_M))
+    {
+        *OutRequests |= FRAME_REQUEST_MEMORY_REPORT;
+    }
+
+    // Captures a CPU timeline of the next frames, open the trace in chrome://tracing
+    if (Input.WasPressed(GLFW_KEY_P))
+    {
+        *OutRequests |= FRAME_REQUEST_PROFILE_CAPTURE;
+    }
+
+    // Animate the chopper
+    if (bAnimateScene)
+    {
+        ChopperAngle += ChopperSpeed * StepSeconds;
+        if (ChopperAngle >= 360.0f)
+        {
+            ChopperAngle -= 360.0f;
+        }
+    }
+}
+
+// Blends angles in degrees the short way across the 360 wrap
+GLfloat InterpolateAngle(GLfloat From, GLfloat To, GLfloat Alpha)
+{
+    GLfloat Difference = To - From;
+    if (Difference > 180.0f)
+    {
+        Difference -= 360.0f;
+    }
+    else if (Difference < -180.0f)
+    {
+        Difference += 360.0f;
+    }
+    return From + Difference * Alpha;
+}
+
+// Sleeps until the input queue has something for the simulation, or Timeout passes
+void WaitForInput(double TimeoutSeconds)
+{
+    double Deadline = glfwGetTime() + TimeoutSeconds;
+    while (!MainWindow.GetInputQueue()->Peek() && glfwGetTime() < Deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+// Simulation thread: steps the simulation & prepares one frame packet per rendered frame
+// Blocks while the pipeline is full, so it never runs more than PipelineDepth frames ahead of the GL thread
+void SimulationLoop(glm::mat4 Projection)
+{
+    // PrepareFrame's jobs go to this thread's own queue
+    Jobs.AttachThread(0);
+
+    // What the last packet showed, to tell whether the next one differs
+    bool bLastPacketChanged = true;
+    glm::mat4 LastView(0.0f);
+    GLfloat LastChopperAngle = -1.0f;
+
+    while (FramePacket* Packet = Pipeline.BeginWrite())
+    {
+        // Nothing moved last time, so don't queue up identical frames, wait for input (or a timeout) instead
+        // The wait is longer than the clock catches up in one frame, skip it rather than simulate it
+        if (bOnDemandRendering && !bLastPacketChanged)
+        {
+            WaitForInput(IdleWaitSeconds);
+            SimClock.Resync(glfwGetTime());
+        }
+
+        PROFILE_SCOPE("SimulateFrame");
+
+        // Run every simulation step that is due, each one sees only the input that arrived before it ends
+        bool bInputArrived = false;
+        SimClock.BeginFrame(glfwGetTime());
+        while (SimClock.Step())
+        {
+            SimulateStep((GLfloat)SimClock.GetStepSeconds(), SimClock.GetTime(), &Packet->Requests);
+            bInputArrived = bInputArrived || Input.GetEventCount() > 0;
+        }
+
+        // Blend the last two steps for rendering
+        GLfloat Alpha = (GLfloat)SimClock.GetAlpha();
+        RenderCamera = Camera::Interpolate(PreviousCamera, MyCamera, Alpha);
+        SceneObjects[ChopperIndex].OrbitAngle = InterpolateAngle(PreviousChopperAngle, ChopperAngle, Alpha);
+
+        // Attach Flashlight Spotlight, before shadows are prepared so its shadow matches this frame
+        if (bEnableFlashlight)
+        {
+            glm::vec3 FlashlightOffset = RenderCamera.GetCameraPosition();
+            FlashlightOffset.y -= 0.1f;
+            SpotLights[1].SetFlash(FlashlightOffset, RenderCamera.GetCameraDirection());
+        }
+        SpotLights[1].ToggleSpotlight(bEnableFlashlight);
+
+        // Transforms, light matrices, culling & draw lists across all cores
+        PrepareFrame(&Jobs, &Packet->Memory, SceneObjects, &RenderCamera, Projection, &MainLight, OmniLights, &Packet->Frame);
+
+        // Copy the light state, from here on the simulation is free to change its own lights
+        Packet->EyePosition = RenderCamera.GetCameraPosition();
+        Packet->MainLight = MainLight;
+        Packet->OmniLights.clear();
+        for (size_t i = 0; i < PointLightCount; i++)
+        {
+            Packet->PointLights[i] = PointLights[i];
+            Packet->OmniLights.push_back(&Packet->PointLights[i]);
+        }
+        for (size_t i = 0; i < SpotLightCount; i++)
+        {
+            Packet->SpotLights[i] = SpotLights[i];
+            Packet->OmniLights.push_back(&Packet->SpotLights[i]);
+        }
+        Packet->ShadowQuality = ShadowQuality;
+
+        // What the camera has seen, so the GL thread can add only the input that came after
+        Packet->ViewCamera = RenderCamera;
+        Packet->InputMouseTotalX = Input.GetMouseTotalX();
+        Packet->InputMouseTotalY = Input.GetMouseTotalY();
+        Packet->InputSampleTime = glfwGetTime();
+        Packet->bLateLatch = bLateLatchCamera;
+
+        // Any input may have flipped a setting, otherwise only the camera & the animation change the picture
+        Packet->bSceneChanged = bInputArrived || Input.IsAnyKeyDown() ||
+                                Packet->Frame.View != LastView || SceneObjects[ChopperIndex].OrbitAngle != LastChopperAngle;
+        Packet->bOnDemand = bOnDemandRendering;
+        bLastPacketChanged = Packet->bSceneChanged;
+        LastView = Packet->Frame.View;
+        LastChopperAngle = SceneObjects[ChopperIndex].OrbitAngle;
+
+        Pipeline.EndWrite(Packet);
+    }
 }
 
 int main()
 {
-    MainWindow = GLWindow(ViewportWidth, ViewportHeight);
+    // Messages from here on are formatted & written on the logger thread
+    Log::Start();
+
+    MainWindow.SetSize(ViewportWidth, ViewportHeight);
     MainWindow.Initialize();
 
+    // Tracked buffers & textures above this degrade (fewer mips, smaller shadow maps) instead of growing
+    GPUMemory::SetBudget(GPUMemoryBudget);
+    Assets.SetBudget(AssetCacheBudget);
+
+    // One extra queue for the simulation thread
+    Jobs.Initialize(0, 1);
+
+    Pacer.SetVSync(DefaultVSync);
+    Pacer.SetFrameLimit(FrameLimits[FrameLimitIndex]);
+    FrameMemory.Initialize(FrameArenaSize);
+    Shader::EnableParallelCompile();
+
     CreateObjects();
     CreateShaders();
+    MainCameraBuffer.Initialize();
+    ResolutionScaler.Initialize(TargetGPUFrameMilliseconds, MinResolutionScale, 1.0f);
+    SceneOverdraw.Initialize(PrepassEnableOverdraw, PrepassDisableOverdraw);
+    LitPassTimer.Initialize();
+    SceneUpscaler.Initialize(&Assets);
+    MomentFilter.Initialize(&Assets, MomentSettings);
+    OmniShadows.Initialize(SchedulerSettings);
     MyCamera = Camera(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, 0.0f, 1.0f, 0.1f);
+    PreviousCamera = MyCamera;
+    RenderCamera = MyCamera;
 
-    BrickTexture = Texture("Textures/brick.png");
-    BrickTexture.LoadAlphaTexture();
-    DirtTexture = Texture("Textures/dirt.png");
-    DirtTexture.LoadAlphaTexture();
-    PlainTexture = Texture("Textures/plain.png");
-    PlainTexture.LoadAlphaTexture();
-    SoilTexture = Texture("Textures/soil.jpg");
-    SoilTexture.LoadTexture();
+    BrickTexture = Assets.LoadTexture("Textures/brick.png", GL_RGBA);
+    DirtTexture = Assets.LoadTexture("Textures/dirt.png", GL_RGBA);
+    PlainTexture = Assets.LoadTexture("Textures/plain.png", GL_RGBA);		// Models' untextured materials share it
+    SoilTexture = Assets.LoadTexture("Textures/soil.jpg", GL_RGB);
 
     ShinyMaterial = Material(1.0f, 16);
     DullMaterial = Material(0.3f, 4);
 
-    XWing = Model();
-    XWing.LoadModel("Models/x-wing.obj");
-    Chopper = Model();
-    Chopper.LoadModel("Models/uh60.obj");
+    // Import both models concurrently (Assimp post-processing, sub-meshes & textures), then upload on this thread
+    // Models already in the cache are neither imported nor uploaded again
+    bool bNewXWing = false;
+    bool bNewChopper = false;
+    XWing = Assets.AcquireModel("Models/x-wing.obj", &bNewXWing);
+    Chopper = Assets.AcquireModel("Models/uh60.obj", &bNewChopper);
+
+    JobCounter ModelCounter;
+    if (bNewXWing)
+    {
+        Jobs.Run(&ModelCounter, []() { XWing->ImportModel("Models/x-wing.obj", &Jobs, &Assets); }, "ImportModel");
+    }
+    if (bNewChopper)
+    {
+        Jobs.Run(&ModelCounter, []() { Chopper->ImportModel("Models/uh60.obj", &Jobs, &Assets); }, "ImportModel");
+    }
+    Jobs.Wait(&ModelCounter);
+
+    if (bNewXWing)
+    {
+        XWing->UploadModel();
+    }
+    if (bNewChopper)
+    {
+        Chopper->UploadModel();
+    }
 
     // Params 1-3: Ambient RGB (Line 1)
     // Param 4: Ambient Intensity (Line 2)
@@ -563,58 +1242,278 @@ int main()
     SkyboxFaces.push_back("Textures/Skybox/cupertin-lake_ft.tga");
 
     // Construct Skybox
-    MySkybox = Skybox(SkyboxFaces);
+    MySkybox = Skybox(SkyboxFaces, &Assets);
+
+    Assets.CollectGarbage();
+    Assets.PrintStatistics();
+    GPUMemory::PrintReport();
+
+    CreateSceneObjects();
+
+    // Recompile shaders in the background whenever a file in Shaders/ is saved
+    ReloadableShaders.push_back(&DirectionalShadowShader);
+    ReloadableShaders.push_back(&OmniShadowShader);
+    ReloadableShaders.push_back(&SpotShadowShader);
+    ReloadableShaders.push_back(&DepthPrepassShader);
+    ReloadableShaders.push_back(MySkybox.GetShader());
+    ReloadableShaders.push_back(SceneUpscaler.GetShader());
+    MomentFilter.GetShaders(&ReloadableShaders);
+    MyShaderWatcher.Start("Shaders");
+
+    // Shadow casters in shadow index order, point lights first then spot lights
+    for (size_t i = 0; i < PointLightCount; i++)
+    {
+        OmniLights.push_back(&PointLights[i]);
+    }
+    for (size_t i = 0; i < SpotLightCount; i++)
+    {
+        OmniLights.push_back(&SpotLights[i]);
+    }
 
 
 
     // We only need to set up Projection once, so we do it here rather than in the While loop
     glm::mat4 Projection = glm::perspective(glm::radians(60.0f), MainWindow.GetBufferWidth() / MainWindow.GetBufferHeight(), 0.1f, 100.0f);
 
+    unsigned int FrameNumber = 0;
+    bool bLastFrameLateLatched = true;
+    bool bIdle = false;
+    ShadowFilter LastShadowQuality = ShadowQuality;
+    unsigned long long IntervalHeapAllocations = 0;
+
+    // Start the clock after loading, or the first frame would try to catch up on it
+    SimClock.Initialize(glfwGetTime(), SimulationRate, MaxSimulationSteps);
+
+    Pipeline.Initialize(PipelineDepth, FrameArenaSize);
+    FrameFences.Initialize(MaxGPUFramesInFlight);
+    SimulationThread = std::thread(SimulationLoop, Projection);
+
     // Loop until window closed
     while (!MainWindow.GetShouldCloseWindow())
     {
-        // Get frame time in seconds
-        GLfloat Now = glfwGetTime(); // SDL_GetPerformanceCounter() for SDL (Must be converted to seconds for SDL)
-        DeltaTime = Now - LastTime;  // (Now - LastTime) * 1000 / SDL_GetPerformanceFrequency();
-        LastTime = Now;
+        PROFILE_SCOPE("Frame");
 
-        // Get + Handle User Input Events
-        glfwPollEvents();
+        // Transient memory for this frame, last frame's allocations stay valid until the next swap
+        FrameMemory.BeginFrame();
+        unsigned long long HeapAllocationsAtStart = FrameAllocator::GetHeapAllocationCount();
 
-        // Pass key inputs from Window to the Camera
-        MyCamera.KeyControl(MainWindow.GetKeys(), DeltaTime);
-        MyCamera.MouseControl(MainWindow.GetChangeX(), MainWindow.GetChangeY());
+        // Get + Handle User Input Events, the callbacks queue them with timestamps for the simulation thread
+        // GLFW only delivers events on this thread. Idle, it sleeps until an event arrives, otherwise the pacer
+        // holds the frame back to the frame cap first so the input is as fresh as possible.
+        if (bIdle)
+        {
+            glfwWaitEventsTimeout(IdleWaitSeconds);
+            Pacer.Reset();
+        }
+        else
+        {
+            Pacer.WaitForNextFrame();
+            glfwPollEvents();
+        }
 
-        // Toggles Flashlight Spotlight on & off
-        if (MainWindow.GetKeys()[GLFW_KEY_F])
+        // The next prepared frame, normally already waiting
+        RenderPacket = Pipeline.BeginRead();
+        if (!RenderPacket)
         {
-            bEnableFlashlight = !bEnableFlashlight;
-            MainWindow.GetKeys()[GLFW_KEY_F] = false;
+            break;
         }
 
-        // Render Passes
-        // Directional Shadow Pass
-        DirectionalShadowMapPass(&MainLight);
-        // Omnidirectional Cube Map Pass - Point Lights
-        for (size_t i = 0; i < PointLightCount; i++)
+        // Prints GPU memory use by category & what the driver reports
+        if (RenderPacket->Requests & FRAME_REQUEST_MEMORY_REPORT)
         {
-            OmniShadowMapPass(&PointLights[i]);
+            GPUMemory::PrintReport();
         }
-        // Omnidirectional Cube Map Pass - Spot Lights
-        for (size_t i = 0; i < SpotLightCount; i++)
+
+        // Captures a CPU timeline of the next frames, open the trace in chrome://tracing
+        if (RenderPacket->Requests & FRAME_REQUEST_PROFILE_CAPTURE)
+        {
+            Profiler::BeginCapture(120, "FrameProfile.json");
+        }
+
+        if (RenderPacket->Requests & FRAME_REQUEST_CYCLE_VSYNC)
+        {
+            Pacer.SetVSync((VSyncMode)((Pacer.GetVSync() + 1) % VSYNC_MODE_COUNT));
+        }
+
+        if (RenderPacket->Requests & FRAME_REQUEST_CYCLE_FRAME_LIMIT)
+        {
+            FrameLimitIndex = (FrameLimitIndex + 1) % (sizeof(FrameLimits) / sizeof(FrameLimits[0]));
+            Pacer.SetFrameLimit(FrameLimits[FrameLimitIndex]);
+            LOG_INFO("Frame limit %.0f FPS (0 = uncapped)", FrameLimits[FrameLimitIndex]);
+        }
+
+        if (RenderPacket->Requests & FRAME_REQUEST_TOGGLE_DYNAMIC_RESOLUTION)
+        {
+            ResolutionScaler.SetEnabled(!ResolutionScaler.IsEnabled());
+        }
+
+        if (RenderPacket->Requests & FRAME_REQUEST_CYCLE_DEPTH_PREPASS)
+        {
+            static const char* PrepassModeNames[] = { "auto", "off", "on" };
+            PrepassMode = (DepthPrepassMode)((PrepassMode + 1) % DEPTH_PREPASS_MODE_COUNT);
+            LOG_INFO("Depth pre-pass %s", PrepassModeNames[PrepassMode]);
+        }
+
+        // Start rebuilding edited shaders, & swap in any that finished linking
+        bool bShadersChanged = false;
+        std::vector<std::string> ChangedShaders = MyShaderWatcher.ConsumeChangedFiles();
+        FrameShaders.assign(ReloadableShaders.begin(), ReloadableShaders.end());
+        LitShaders.GetShaders(&FrameShaders);
+        for (size_t i = 0; i < FrameShaders.size(); i++)
+        {
+            for (size_t j = 0; j < ChangedShaders.size(); j++)
+            {
+                if (FrameShaders[i]->UsesFile(ChangedShaders[j]))
+                {
+                    FrameShaders[i]->Reload();
+                    break;
+                }
+            }
+            bShadersChanged = FrameShaders[i]->UpdatePending() || bShadersChanged;
+        }
+
+        // Skip drawing when the last frame on screen is still right, or nobody can see it
+        bool bRenderFrame = !RenderPacket->bOnDemand || RenderPacket->bSceneChanged || bShadersChanged || RenderPacket->Requests != 0;
+        bRenderFrame = MainWindow.ConsumeRefreshRequest() || bRenderFrame;
+        if (!bRenderFrame || MainWindow.IsIconified())
         {
-            OmniShadowMapPass(&SpotLights[i]);
+            Pipeline.EndRead(RenderPacket);
+            RenderPacket = nullptr;
+            bIdle = true;
+            continue;
         }
-        // Phone Shader Render Pass
-        RenderPass(Projection, MyCamera.CalculateViewMatrix());
+        bIdle = false;
+
+        // Pick the lighting permutation matching the current lights & settings, compiled with fixed counts & unrolled loops
+        // A permutation that is still linking leaves the previous one in use, the frame then follows its filter
+        ShaderPermutationKey LitKey;
+        LitShader = LitShaders.GetShader({ PointLightCount, SpotLightCount, RenderPacket->ShadowQuality, ShaderFeatures }, &LitKey);
+        RenderPacket->ShadowQuality = LitKey.Filter;
+
+        // Smoothed GPU time of the lit pass with the filter being replaced, to compare the cost of the two
+        // Per megapixel it holds across resolution scale changes, the timer then starts over for the new filter
+        if (RenderPacket->ShadowQuality != LastShadowQuality)
+        {
+            LOG_INFO("Shadow filter %s -> %s, lit pass %.3fms (%.3fms per megapixel) at scale %.2f",
+                ShadowFilterNames[LastShadowQuality], ShadowFilterNames[RenderPacket->ShadowQuality],
+                LitPassTimer.GetMilliseconds(), LitPassTimer.GetMillisecondsPerWork(), ResolutionScaler.GetScale());
+            LitPassTimer.Reset();
+            LastShadowQuality = RenderPacket->ShadowQuality;
+        }
+
+        // Decided before recording, the pre-pass has its own command buffer
+        bFramePrepass = SceneOverdraw.UsePrepass(PrepassMode);
+
+        // Pick the shadow resolution that fits the memory budget before the scheduler & the graph size their maps
+        GPUMemory::Update();
+
+        // Which omni shadow maps to redraw, decided before recording so the cached ones record nothing
+        OmniShadows.Schedule(RenderPacket->OmniLights, RenderPacket->Frame.OmniLightMatrices,
+                             RenderPacket->Frame.View, RenderPacket->Frame.Projection, RenderPacket->EyePosition);
+
+        // Record the draws of every pass in parallel, the GL thread only replays them below
+        RecordPasses();
+
+        // Don't queue more GL work while the GPU is still MaxGPUFramesInFlight frames behind
+        FrameFences.WaitForSlot();
+
+        // Main pass size from the GPU time of frames a few behind this one
+        SceneWidth = ResolutionScaler.ScaleSize(ViewportWidth);
+        SceneHeight = ResolutionScaler.ScaleSize(ViewportHeight);
+
+        // Render Passes, scheduled by the frame graph: shadow maps first, then the lit scene & its upscale
+        // Only GPU work is timed, waiting for vsync doesn't count against the budget
+        ResolutionScaler.BeginFrame();
+        BuildFrameGraph();
+        FrameGraph.Execute();
+        ResolutionScaler.EndFrame();
         
         // Clear the Shader Program
         glUseProgram(0);
 
+        // Evicting frees GL objects, so it runs here on the context thread, after the frame let go of its assets
+        Assets.CollectGarbage();
+
+        // Everything the packet held has been copied into GL calls, the simulation thread can reuse it
+        Pipeline.EndRead(RenderPacket);
+        RenderPacket = nullptr;
+
         MainWindow.SwapBuffers();
+        FrameFences.Signal();
+
+        // Latency from sampling the camera's input until the swap returns, a stand-in for the frame reaching the screen
+        // Switching late latching starts a new average so the two modes can be compared
+        if (LatencyFrames > 0 && bFrameLateLatched != bLastFrameLateLatched)
+        {
+            LatencySum = 0.0;
+            LatencyFrames = 0;
+        }
+        bLastFrameLateLatched = bFrameLateLatched;
+        LatencySum += glfwGetTime() - FrameInputTime;
+        LatencyFrames++;
+        if (LatencyFrames == LatencyReportInterval)
+        {
+            LOG_INFO("Camera input to present %.2fms average over %u frames (late latch %s)",
+                LatencySum * 1000.0 / LatencyFrames, LatencyFrames, bFrameLateLatched ? "on" : "off");
+            LatencySum = 0.0;
+            LatencyFrames = 0;
+        }
+
+        Profiler::EndFrame();
+
+        // Steady state frames should run entirely out of the frame arena & reused buffers
+        FrameNumber++;
+        if (FrameNumber > WarmupFrames)
+        {
+            IntervalHeapAllocations += FrameAllocator::GetHeapAllocationCount() - HeapAllocationsAtStart;
+            if (FrameNumber % HeapReportInterval == 0)
+            {
+                if (IntervalHeapAllocations > 0 || FrameMemory.GetArena()->GetOverflowCount() > 0)
+                {
+                    LOG_WARNING("%llu heap allocations in the last %u frames, frame arena peak %zu of %zu bytes",
+                        IntervalHeapAllocations, HeapReportInterval, FrameMemory.GetArena()->GetPeak(), FrameMemory.GetArena()->GetCapacity());
+                }
+                IntervalHeapAllocations = 0;
+            }
+        }
+
+        // Where dynamic resolution has settled, alongside the GPU time it is steering by
+        if (FrameNumber % ResolutionReportInterval == 0)
+        {
+            LOG_INFO("GPU frame %.2fms (target %.2fms), resolution scale %.2f (%ix%i)",
+                ResolutionScaler.GetGPUMilliseconds(), TargetGPUFrameMilliseconds, ResolutionScaler.GetScale(), SceneWidth, SceneHeight);
+            LOG_INFO("Scene overdraw %.2fx, depth pre-pass %s", SceneOverdraw.GetOverdraw(), bFramePrepass ? "on" : "off");
+            LOG_INFO("Lit pass %.3fms (%.3fms per megapixel) with %s shadows",
+                LitPassTimer.GetMilliseconds(), LitPassTimer.GetMillisecondsPerWork(), ShadowFilterNames[RenderPacket->ShadowQuality]);
+            LOG_INFO("Omni shadows %u refreshed, %u cached, %u unshadowed, %u off, %.3fms per shadow map face",
+                OmniShadows.GetCount(SHADOW_STATE_REFRESH), OmniShadows.GetCount(SHADOW_STATE_CACHED),
+                OmniShadows.GetCount(SHADOW_STATE_FALLBACK), OmniShadows.GetCount(SHADOW_STATE_DISABLED), OmniShadows.GetFaceMilliseconds());
+            LOG_INFO("Spot shadow atlas %ix%i, %.0f%% in tiles", OmniShadows.GetAtlasSize(), OmniShadows.GetAtlasSize(), OmniShadows.GetAtlasUsage() * 100.0f);
+        }
     }
 
-    printf("User closed window.");
+    // Release the simulation thread before the job system it submits to goes away
+    Pipeline.Stop();
+    SimulationThread.join();
+    FrameFences.Clear();
+
+    MyShaderWatcher.Stop();
+    FrameGraph.ReleaseResources();
+    MainCameraBuffer.Clear();
+    ResolutionScaler.Clear();
+    SceneOverdraw.Clear();
+    LitPassTimer.Clear();
+    SceneUpscaler.Clear();
+    MomentFilter.Clear();
+    OmniShadows.Clear();
+    Jobs.Shutdown();
+
+    // Free whatever only the cache still holds while the context is alive
+    LitShaders.ClearPermutations();
+    Assets.Clear();
+
+    LOG_INFO("User closed window.");
+    Log::Stop();
     return 0;
 }
 
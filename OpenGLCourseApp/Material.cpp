@@ -16,4 +16,10 @@ void Material::UseMaterial(GLuint SpecularIntensityLocation, GLuint ShininessLoc
 {
 	glUniform1f(SpecularIntensityLocation, SpecularIntensity);
 	glUniform1f(ShininessLocation, Shininess);
-}
\ No newline at end of file
+}
+
+void Material::RecordMaterial(CommandBuffer* Commands, GLuint SpecularIntensityLocation, GLuint ShininessLocation)
+{
+	Commands->SetUniform1f(SpecularIntensityLocation, SpecularIntensity);
+	Commands->SetUniform1f(ShininessLocation, Shininess);
+}
@@ -2,6 +2,8 @@
 
 #include <GL/glew.h>
 
+#include "CommandBuffer.h"
+
 class Material
 {
 public:
@@ -9,6 +11,7 @@ public:
 	Material(GLfloat SpecularIntensity, GLfloat Shininess);
 
 	void UseMaterial(GLuint NewSpecularIntensityLocation, GLuint NewShininessLocation);
+	void RecordMaterial(CommandBuffer* Commands, GLuint SpecularIntensityLocation, GLuint ShininessLocation);
 
 private:
 	GLfloat SpecularIntensity;
@@ -1,4 +1,7 @@
+#include <utility>
+
 #include "Mesh.h"
+#include "GPUMemory.h"
 
 Mesh::Mesh()
 {
@@ -6,6 +9,36 @@ Mesh::Mesh()
 	VBO = 0;
 	IBO = 0;
 	IndexCount = 0;
+	ByteSize = 0;
+	BoundsCenter = glm::vec3(0.0f, 0.0f, 0.0f);
+	BoundsRadius = 0.0f;
+}
+
+Mesh::Mesh(Mesh&& Other) noexcept
+{
+	VAO = 0;
+	VBO = 0;
+	IBO = 0;
+	IndexCount = 0;
+	ByteSize = 0;
+	*this = std::move(Other);
+}
+
+Mesh& Mesh::operator=(Mesh&& Other) noexcept
+{
+	if (this != &Other)
+	{
+		ClearMesh();
+
+		VAO = std::exchange(Other.VAO, 0);
+		VBO = std::exchange(Other.VBO, 0);
+		IBO = std::exchange(Other.IBO, 0);
+		IndexCount = std::exchange(Other.IndexCount, 0);
+		ByteSize = std::exchange(Other.ByteSize, 0);
+		BoundsCenter = Other.BoundsCenter;
+		BoundsRadius = Other.BoundsRadius;
+	}
+	return *this;
 }
 
 /*  NOTES ON VERTEX SPECIFICATON
@@ -22,6 +55,9 @@ For this reason, that VAO should be unbound BEFORE the IBO is unbound, to ensure
 void Mesh::CreateMesh(GLfloat* Verticies, unsigned int* Indicies, unsigned int NumOfVerticies, unsigned int NumOfIndicies)
 {
 	IndexCount = NumOfIndicies;
+	ByteSize = sizeof(Verticies[0]) * NumOfVerticies + sizeof(Indicies[0]) * NumOfIndicies;
+
+    CalculateBounds(Verticies, NumOfVerticies);
 
     // "VERTEX SPECIFICATION"
     // 1. Generate Vertex Array Object ID
@@ -40,7 +76,7 @@ void Mesh::CreateMesh(GLfloat* Verticies, unsigned int* Indicies, unsigned int N
     // 4. Bind VBO to ID
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     // 5. Attach vertex data to the bound VBO
-    glBufferData(GL_ARRAY_BUFFER, sizeof(Verticies) * NumOfVerticies, Verticies, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(Verticies[0]) * NumOfVerticies, Verticies, GL_STATIC_DRAW);
     // 6a. Define Attribute Pointer Targeting slot 0 for the MESH geometry
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Verticies[0]) * 8, 0);
     // 7a. Enable the Attribute Pointer
@@ -60,6 +96,37 @@ void Mesh::CreateMesh(GLfloat* Verticies, unsigned int* Indicies, unsigned int N
 
     // Unbind IBO *AFTER* VBO 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    GPUMemory::TrackAllocation(GPU_MEMORY_GEOMETRY, ByteSize);
+}
+
+void Mesh::CalculateBounds(GLfloat* Verticies, unsigned int NumOfVerticies)
+{
+    // Vertex layout is X Y Z  U V  NX NY NZ
+    const unsigned int VertexLength = 8;
+
+    if (NumOfVerticies < VertexLength)
+    {
+        return;
+    }
+
+    // Center on the bounding box, then grow the radius to the furthest vertex
+    glm::vec3 Min(Verticies[0], Verticies[1], Verticies[2]);
+    glm::vec3 Max = Min;
+    for (unsigned int i = 0; i + 2 < NumOfVerticies; i += VertexLength)
+    {
+        glm::vec3 Position(Verticies[i], Verticies[i + 1], Verticies[i + 2]);
+        Min = glm::min(Min, Position);
+        Max = glm::max(Max, Position);
+    }
+
+    BoundsCenter = (Min + Max) * 0.5f;
+    BoundsRadius = 0.0f;
+    for (unsigned int i = 0; i + 2 < NumOfVerticies; i += VertexLength)
+    {
+        glm::vec3 Position(Verticies[i], Verticies[i + 1], Verticies[i + 2]);
+        BoundsRadius = glm::max(BoundsRadius, glm::length(Position - BoundsCenter));
+    }
 }
 
 void Mesh::RenderMesh()
@@ -80,8 +147,19 @@ void Mesh::RenderMesh()
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+void Mesh::RecordMesh(CommandBuffer* Commands)
+{
+    // The VAO remembers the Element Array Buffer, so binding it is enough
+    Commands->BindVertexArray(VAO);
+    Commands->DrawElements(GL_TRIANGLES, IndexCount, GL_UNSIGNED_INT);
+}
+
 void Mesh::ClearMesh()
 {
+    if (VAO != 0)
+    {
+        GPUMemory::TrackRelease(GPU_MEMORY_GEOMETRY, ByteSize);
+    }
     if (IBO != 0)
     {
         glDeleteBuffers(1, &IBO);
@@ -98,6 +176,7 @@ void Mesh::ClearMesh()
         VAO = 0;
     }
     IndexCount = 0;
+    ByteSize = 0;
 }
 
 Mesh::~Mesh()
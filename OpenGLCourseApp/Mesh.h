@@ -1,19 +1,45 @@
 #pragma once
 #include <GL/glew.h>
 
+#include <GLM/glm.hpp>
+
+#include "CommandBuffer.h"
+
 
 class Mesh
 {
 public:
 	Mesh();
+
+	// Owns GL names, so it can be moved (e.g. into a SlotMap) but not copied
+	Mesh(Mesh&& Other) noexcept;
+	Mesh& operator=(Mesh&& Other) noexcept;
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+
 	void CreateMesh(GLfloat *Verticies, unsigned int *Indicies, unsigned int NumOfVerticies, unsigned int NumOfIndicies);
 	void RenderMesh();
+	void RecordMesh(CommandBuffer* Commands);
 	void ClearMesh();
+
+	// Bounding sphere in model space, used for culling
+	glm::vec3 GetBoundsCenter() { return BoundsCenter; }
+	GLfloat GetBoundsRadius() { return BoundsRadius; }
+
+	// GPU memory held by the vertex & index buffers
+	size_t GetByteSize() { return ByteSize; }
+
 	~Mesh();
 private:
 	GLuint VAO;
 	GLuint VBO;
 	GLuint IBO;
 	GLsizei IndexCount;
+	size_t ByteSize;
+
+	glm::vec3 BoundsCenter;
+	GLfloat BoundsRadius;
+
+	void CalculateBounds(GLfloat* Verticies, unsigned int NumOfVerticies);
 
 };
\ No newline at end of file
@@ -1,16 +1,19 @@
 #include "Model.h"
+#include "AssetManager.h"
+#include "Profiler.h"
 
 
 Model::Model()
 {
-
+	BoundsCenter = glm::vec3(0.0f, 0.0f, 0.0f);
+	BoundsRadius = 0.0f;
 }
 
 void Model::RenderModel()
 {
-	for (size_t i = 0; i < MeshList.size(); i++)
+	for (size_t i = 0; i < SubMeshes.size(); i++)
 	{
-		unsigned int MaterialIndex = MeshToTexture[i];
+		unsigned int MaterialIndex = SubMeshes[i].MaterialIndex;
 
 		// Verify the Index is within array bounds, before checking if a valid result exists at the index
 		if (MaterialIndex < TextureList.size() && TextureList[MaterialIndex])
@@ -18,103 +21,233 @@ void Model::RenderModel()
 			TextureList[MaterialIndex]->UseTexture();
 		}
 
-		MeshList[i]->RenderMesh();
+		MeshPool.Get(SubMeshes[i].Geometry)->RenderMesh();
+	}
+}
+
+void Model::RecordModel(CommandBuffer* Commands, bool bBindTextures)
+{
+	for (size_t i = 0; i < SubMeshes.size(); i++)
+	{
+		unsigned int MaterialIndex = SubMeshes[i].MaterialIndex;
+
+		// Verify the Index is within array bounds, before checking if a valid result exists at the index
+		if (bBindTextures && MaterialIndex < TextureList.size() && TextureList[MaterialIndex])
+		{
+			TextureList[MaterialIndex]->RecordTexture(Commands);
+		}
+
+		MeshPool.Get(SubMeshes[i].Geometry)->RecordMesh(Commands);
+	}
+}
+
+void Model::LoadModel(const std::string& FileName, JobSystem* Jobs, AssetManager* Assets)
+{
+	if (ImportModel(FileName, Jobs, Assets))
+	{
+		UploadModel();
 	}
 }
 
-void Model::LoadModel(const std::string& FileName)
+bool Model::ImportModel(const std::string& FileName, JobSystem* Jobs, AssetManager* Assets)
 {
+	PROFILE_SCOPE("Model::ImportModel");
+
 	Assimp::Importer Importer;
 	const aiScene* Scene = Importer.ReadFile(FileName, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices);
 
 	if (!Scene)
 	{
-		printf("Model (%s) failed to load: %s", FileName, Importer.GetErrorString());
-		return;
+		printf("Model (%s) failed to load: %s", FileName.c_str(), Importer.GetErrorString());
+		return false;
 	}
 
-	LoadNode(Scene->mRootNode, Scene);
-	LoadMaterials(Scene);
+	// Flatten the node tree into the sub-mesh draw order
+	std::vector<aiMesh*> SourceMeshes;
+	LoadNode(Scene->mRootNode, Scene, &SourceMeshes);
+
+	PendingMaterials.resize(SourceMeshes.size());
+	for (size_t i = 0; i < SourceMeshes.size(); i++)
+	{
+		PendingMaterials[i] = SourceMeshes[i]->mMaterialIndex;
+	}
+
+	// Each sub-mesh converts into its own pre-sized buffers, so jobs never share or grow a vector
+	PendingMeshes.resize(SourceMeshes.size());
+	JobCounter LoadCounter;
+
+	LoadMaterials(Scene, Jobs, &LoadCounter, Assets);
+
+	std::vector<MeshData>& Converted = PendingMeshes;
+	Jobs->ParallelFor(&LoadCounter, SourceMeshes.size(), 1, [&SourceMeshes, &Converted](size_t Start, size_t End)
+	{
+		for (size_t i = Start; i < End; i++)
+		{
+			LoadMesh(SourceMeshes[i], &Converted[i]);
+		}
+	}, "Model::LoadMesh");
+
+	// Assimp owns the source data, so it has to be consumed before the Importer goes out of scope
+	Jobs->Wait(&LoadCounter);
+
+	return true;
 }
 
-void Model::ClearModel()
+void Model::UploadModel()
 {
-	for (size_t i = 0; i < MeshList.size(); i++)
+	PROFILE_SCOPE("Model::UploadModel");
+
+	MeshPool.Reserve(MeshPool.Size() + PendingMeshes.size());
+	SubMeshes.reserve(SubMeshes.size() + PendingMeshes.size());
+	for (size_t i = 0; i < PendingMeshes.size(); i++)
 	{
-		if (MeshList[i])
+		if (PendingMeshes[i].Indices.empty())
 		{
-			// Safe delete
-			delete MeshList[i];
-			MeshList[i] = nullptr;
+			continue;
 		}
+
+		// Instantiate the Mesh & store the texture details
+		Mesh NewMesh;
+		NewMesh.CreateMesh(PendingMeshes[i].Vertices.data(), PendingMeshes[i].Indices.data(), PendingMeshes[i].Vertices.size(), PendingMeshes[i].Indices.size());
+		SubMeshes.push_back({ MeshPool.Insert(std::move(NewMesh)), PendingMaterials[i] });
 	}
+
 	for (size_t i = 0; i < TextureList.size(); i++)
 	{
-		if (TextureList[i])
+		// Shared textures may already have been uploaded by another model or material
+		if (TextureList[i] && !TextureList[i]->IsUploaded() && !TextureList[i]->UploadTexture(TextureFormats[i]))
 		{
-			// Safe delete
-			delete TextureList[i];
-			TextureList[i] = nullptr;
+			printf("Failed to upload texture for material %zu\n", i);
 		}
 	}
+
+	// CPU copies are no longer needed once they live in VBOs
+	PendingMeshes.clear();
+	PendingMeshes.shrink_to_fit();
+	PendingMaterials.clear();
+
+	CalculateBounds();
 }
 
-void Model::LoadNode(aiNode* Node, const aiScene* Scene)
+void Model::ClearModel()
+{
+	// Destroying the pooled meshes deletes their buffers
+	MeshPool.Clear();
+	SubMeshes.clear();
+
+	// Textures are shared, the asset cache frees them once nothing else refers to them
+	TextureList.clear();
+	TextureFormats.clear();
+}
+
+size_t Model::GetByteSize()
+{
+	size_t Bytes = 0;
+	for (Mesh& PooledMesh : MeshPool)
+	{
+		Bytes += PooledMesh.GetByteSize();
+	}
+	return Bytes;
+}
+
+void Model::CalculateBounds()
+{
+	if (MeshPool.Size() == 0)
+	{
+		return;
+	}
+
+	// Order doesn't matter for bounds, so walk the pool directly
+	// Center on the box around all sub-mesh spheres, then grow the radius to enclose each sphere
+	glm::vec3 Min = MeshPool[0].GetBoundsCenter() - glm::vec3(MeshPool[0].GetBoundsRadius());
+	glm::vec3 Max = MeshPool[0].GetBoundsCenter() + glm::vec3(MeshPool[0].GetBoundsRadius());
+	for (size_t i = 1; i < MeshPool.Size(); i++)
+	{
+		Min = glm::min(Min, MeshPool[i].GetBoundsCenter() - glm::vec3(MeshPool[i].GetBoundsRadius()));
+		Max = glm::max(Max, MeshPool[i].GetBoundsCenter() + glm::vec3(MeshPool[i].GetBoundsRadius()));
+	}
+
+	BoundsCenter = (Min + Max) * 0.5f;
+	BoundsRadius = 0.0f;
+	for (size_t i = 0; i < MeshPool.Size(); i++)
+	{
+		GLfloat Reach = glm::length(MeshPool[i].GetBoundsCenter() - BoundsCenter) + MeshPool[i].GetBoundsRadius();
+		BoundsRadius = glm::max(BoundsRadius, Reach);
+	}
+}
+
+void Model::LoadNode(aiNode* Node, const aiScene* Scene, std::vector<aiMesh*>* OutMeshes)
 {
 	for (size_t i = 0; i < Node->mNumMeshes; i++)
 	{
-		LoadMesh(Scene->mMeshes[Node->mMeshes[i]], Scene);
+		OutMeshes->push_back(Scene->mMeshes[Node->mMeshes[i]]);
 	}
 
 	for (size_t i = 0; i < Node->mNumChildren; i++)
 	{
-		LoadNode(Node->mChildren[i], Scene);
+		LoadNode(Node->mChildren[i], Scene, OutMeshes);
 	}
 }
 
-void Model::LoadMesh(aiMesh* LoadMesh, const aiScene* Scene)
+void Model::LoadMesh(const aiMesh* LoadMesh, MeshData* OutData)
 {
-	std::vector<GLfloat> Vertices;
-	std::vector<unsigned int> Indices;
+	// Vertex layout is X Y Z  U V  NX NY NZ
+	const size_t VertexLength = 8;
+
+	OutData->Vertices.resize(LoadMesh->mNumVertices * VertexLength);
+	GLfloat* Vertex = OutData->Vertices.data();
 
 	// Add vertices to vertice list
-	for (size_t i = 0; i < LoadMesh->mNumVertices; i++)
+	for (size_t i = 0; i < LoadMesh->mNumVertices; i++, Vertex += VertexLength)
 	{
 		// Load our vertex x,y,z for the model
-		Vertices.insert(Vertices.end(), { LoadMesh->mVertices[i].x,LoadMesh->mVertices[i].y,LoadMesh->mVertices[i].z });
+		Vertex[0] = LoadMesh->mVertices[i].x;
+		Vertex[1] = LoadMesh->mVertices[i].y;
+		Vertex[2] = LoadMesh->mVertices[i].z;
+
 		if (LoadMesh->mTextureCoords[0])
 		{
 			// Load our texture U and V coordinates
-			Vertices.insert(Vertices.end(), { LoadMesh->mTextureCoords[0][i].x,LoadMesh->mTextureCoords[0][i].y });
+			Vertex[3] = LoadMesh->mTextureCoords[0][i].x;
+			Vertex[4] = LoadMesh->mTextureCoords[0][i].y;
 		}
 		else  // Handle no texture case
 		{
-			Vertices.insert(Vertices.end(), { 0.0f, 0.0f });
+			Vertex[3] = 0.0f;
+			Vertex[4] = 0.0f;
 		}
+
 		// Load our normals for Nx, Ny, Nz
-		Vertices.insert(Vertices.end(), { -LoadMesh->mNormals[i].x, -LoadMesh->mNormals[i].y, -LoadMesh->mNormals[i].z });
+		Vertex[5] = -LoadMesh->mNormals[i].x;
+		Vertex[6] = -LoadMesh->mNormals[i].y;
+		Vertex[7] = -LoadMesh->mNormals[i].z;
+	}
+
+	// Count first so the index buffer is allocated exactly once
+	size_t IndexCount = 0;
+	for (size_t i = 0; i < LoadMesh->mNumFaces; i++)
+	{
+		IndexCount += LoadMesh->mFaces[i].mNumIndices;
 	}
 
+	OutData->Indices.resize(IndexCount);
+	unsigned int* Index = OutData->Indices.data();
+
 	// Add faces to Indices list
 	for (size_t i = 0; i < LoadMesh->mNumFaces; i++)
 	{
-		aiFace Face = LoadMesh->mFaces[i];
+		const aiFace& Face = LoadMesh->mFaces[i];
 		for (size_t j = 0; j < Face.mNumIndices; j++)
 		{
-			Indices.push_back(Face.mIndices[j]);
+			*Index++ = Face.mIndices[j];
 		}
 	}
-
-	// Instantiate the Mesh & store the texture details
-	Mesh* NewMesh = new Mesh();
-	NewMesh->CreateMesh(&Vertices[0], &Indices[0], Vertices.size(), Indices.size());
-	MeshList.push_back(NewMesh);
-	MeshToTexture.push_back(LoadMesh->mMaterialIndex);
 }
 
-void Model::LoadMaterials(const aiScene* Scene)
+void Model::LoadMaterials(const aiScene* Scene, JobSystem* Jobs, JobCounter* Counter, AssetManager* Assets)
 {
 	TextureList.resize(Scene->mNumMaterials);
+	TextureFormats.resize(Scene->mNumMaterials);
 
 	for (size_t i = 0; i < Scene->mNumMaterials; i++)
 	{
@@ -122,40 +255,51 @@ void Model::LoadMaterials(const aiScene* Scene)
 
 		TextureList[i] = nullptr;
 
+		std::string TexturePath = "Textures/plain.png";
+
 		if (Material->GetTextureCount(aiTextureType_DIFFUSE))
 		{
-			aiString TexturePath;
-			if (Material->GetTexture(aiTextureType_DIFFUSE, 0, &TexturePath) == AI_SUCCESS)
+			aiString SourcePath;
+			if (Material->GetTexture(aiTextureType_DIFFUSE, 0, &SourcePath) == AI_SUCCESS)
 			{
-				int Index = std::string(TexturePath.data).rfind("\\");
-				std::string RawFilename = std::string(TexturePath.data).substr(Index + 1);
-				printf("Texture %s loaded successfully!\n", RawFilename);
+				int Index = std::string(SourcePath.data).rfind("\\");
+				std::string RawFilename = std::string(SourcePath.data).substr(Index + 1);
 
-				std::string TexturePath = std::string("Textures/") + RawFilename;
+				TexturePath = std::string("Textures/") + RawFilename;
+			}
+		}
 
-				TextureList[i] = new Texture(TexturePath.c_str());
+		// The plain texture has alpha & is acquired as RGBA everywhere, so models share the one Main loads
+		TextureFormats[i] = TexturePath == "Textures/plain.png" ? GL_RGBA : GL_RGB;
 
-				if (!TextureList[i]->LoadTexture())
-				{
-					printf("Failed to Load Texture at: %s !\n", TexturePath);
+		bool bCreated = false;
+		TextureList[i] = Assets->AcquireTexture(TexturePath, TextureFormats[i], &bCreated);
 
-					// Safe Delete
-					delete TextureList[i]; 
-					TextureList[i] = nullptr;
-				}
-			}
+		// Already cached (or being decoded for another material)
+		if (!bCreated)
+		{
+			continue;
 		}
 
-		// Fallback texture
-		if (!TextureList[i])
+		// Decode on a worker, the upload happens back on the context thread in LoadModel
+		Texture* NewTexture = TextureList[i].get();
+		Jobs->Run(Counter, [NewTexture, TexturePath]()
 		{
-			TextureList[i] = new Texture("Textures/plain.png");
-			TextureList[i]->LoadTexture();
-		}
+			if (NewTexture->DecodeTexture())
+			{
+				return;
+			}
+
+			printf("Failed to Load Texture at: %s !\n", TexturePath.c_str());
+
+			// Fallback texture
+			*NewTexture = Texture("Textures/plain.png");
+			NewTexture->DecodeTexture();
+		}, "Model::DecodeTexture");
 	}
 }
 
 Model::~Model()
 {
 	ClearModel();
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -9,26 +10,72 @@
 
 #include "Mesh.h"
 #include "Texture.h"
+#include "JobSystem.h"
+#include "SlotMap.h"
+
+class AssetManager;
 
 class Model
 {
 public:
 	Model();
 
-	void LoadModel(const std::string& FileName);
+	// Sub-mesh conversion & texture decoding run on the job system, GL objects are created on the calling thread
+	// Material textures come from Assets, so models sharing a texture only decode it once
+	void LoadModel(const std::string& FileName, JobSystem* Jobs, AssetManager* Assets);
+
+	// LoadModel in two halves, so several models can import concurrently:
+	// Import is CPU only & may run inside a job, Upload must run on the GL context thread
+	bool ImportModel(const std::string& FileName, JobSystem* Jobs, AssetManager* Assets);
+	void UploadModel();
+
 	void RenderModel();
+
+	// Depth-only passes skip the texture binds
+	void RecordModel(CommandBuffer* Commands, bool bBindTextures);
 	void ClearModel();
 
+	// Bounding sphere enclosing every sub-mesh, used for culling
+	glm::vec3 GetBoundsCenter() { return BoundsCenter; }
+	GLfloat GetBoundsRadius() { return BoundsRadius; }
+
+	// Vertex & index buffers, textures are counted by the asset cache on their own
+	size_t GetByteSize();
+
 	~Model();
 
 private:
 
-	void LoadNode(aiNode* Node, const aiScene* Scene);
-	void LoadMesh(aiMesh* LoadMesh, const aiScene* Scene);
-	void LoadMaterials(const aiScene* Scene);
+	// Draw order entry, the mesh itself lives in MeshPool
+	struct SubMesh
+	{
+		SlotHandle Geometry;
+		unsigned int MaterialIndex;
+	};
+
+	// CPU side copy of a sub-mesh, filled on a worker thread
+	struct MeshData
+	{
+		std::vector<GLfloat> Vertices;
+		std::vector<unsigned int> Indices;
+	};
+
+	void LoadNode(aiNode* Node, const aiScene* Scene, std::vector<aiMesh*>* OutMeshes);
+	static void LoadMesh(const aiMesh* LoadMesh, MeshData* OutData);
+	void LoadMaterials(const aiScene* Scene, JobSystem* Jobs, JobCounter* Counter, AssetManager* Assets);
+	void CalculateBounds();
+
+	// Sub-meshes sit next to each other in memory instead of one heap block each
+	SlotMap<Mesh> MeshPool;
+	std::vector<SubMesh> SubMeshes;
+	std::vector<std::shared_ptr<Texture>> TextureList;
+	std::vector<GLenum> TextureFormats;			// Upload format per material, part of the texture's cache key
+
+	// Imported but not yet uploaded
+	std::vector<MeshData> PendingMeshes;
+	std::vector<unsigned int> PendingMaterials;
 
-	std::vector<Mesh*> MeshList;
-	std::vector<Texture*> TextureList;
-	std::vector<unsigned int> MeshToTexture;
+	glm::vec3 BoundsCenter;
+	GLfloat BoundsRadius;
 };
 
@@ -6,9 +6,8 @@ class OmniShadowMap : public ShadowMap
 public:
 	OmniShadowMap();
 
-	bool Initialize(unsigned int Width, unsigned int Height);
-	void Write();
 	void Read(GLenum TextureUnit);
+	GLenum GetTextureTarget() { return GL_TEXTURE_CUBE_MAP; }
 
 	~OmniShadowMap();
 
@@ -0,0 +1,73 @@
+#include "OverdrawMonitor.h"
+#include "Log.h"
+
+// Weight of the newest sample in the smoothed overdraw
+static const float Smoothing = 0.1f;
+
+OverdrawMonitor::OverdrawMonitor()
+{
+	EnableOverdraw = 1.6f;
+	DisableOverdraw = 1.3f;
+	Overdraw = 0.0f;
+	bPrepassWanted = false;
+}
+
+void OverdrawMonitor::Initialize(float NewEnableOverdraw, float NewDisableOverdraw)
+{
+	EnableOverdraw = NewEnableOverdraw;
+	DisableOverdraw = NewDisableOverdraw;
+
+	Queries.Initialize(GL_SAMPLES_PASSED);
+}
+
+void OverdrawMonitor::BeginMeasure()
+{
+	Queries.Begin();
+}
+
+void OverdrawMonitor::EndMeasure(unsigned long long PixelCount)
+{
+	Queries.End((double)PixelCount);
+	ReadQueries();
+}
+
+bool OverdrawMonitor::UsePrepass(DepthPrepassMode Mode) const
+{
+	if (Mode == DEPTH_PREPASS_AUTO)
+	{
+		return bPrepassWanted;
+	}
+	return Mode == DEPTH_PREPASS_ON;
+}
+
+void OverdrawMonitor::ReadQueries()
+{
+	GLuint64 Samples = 0;
+	double Pixels = 0.0;
+	while (Queries.ReadResult(&Samples, &Pixels))
+	{
+		if (Pixels <= 0.0)
+		{
+			continue;
+		}
+
+		float FrameOverdraw = (float)(Samples / Pixels);
+		Overdraw = Overdraw > 0.0f ? Overdraw + (FrameOverdraw - Overdraw) * Smoothing : FrameOverdraw;
+
+		bool bWanted = bPrepassWanted ? Overdraw > DisableOverdraw : Overdraw > EnableOverdraw;
+		if (bWanted != bPrepassWanted)
+		{
+			bPrepassWanted = bWanted;
+			LOG_DEBUG("Depth pre-pass %s at %.2fx overdraw", bPrepassWanted ? "on" : "off", Overdraw);
+		}
+	}
+}
+
+void OverdrawMonitor::Clear()
+{
+	Queries.Clear();
+}
+
+OverdrawMonitor::~OverdrawMonitor()
+{
+}
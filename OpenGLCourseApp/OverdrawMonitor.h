@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "GPUQueryRing.h"
+
+enum DepthPrepassMode
+{
+	DEPTH_PREPASS_AUTO = 0,		// Follows the measured overdraw
+	DEPTH_PREPASS_OFF,
+	DEPTH_PREPASS_ON,
+	DEPTH_PREPASS_MODE_COUNT
+};
+
+// Measures how many times each pixel of the main pass gets shaded, & decides whether a depth pre-pass pays off
+// GL_SAMPLES_PASSED counts the fragments passing the depth test in the first depth tested draw of the opaque
+// scene: the main pass itself without a pre-pass, the pre-pass with one. Either way that is what the Phong
+// shader would run on without a pre-pass. Results are read back a few frames late, never stalling.
+// The pre-pass switches on above one overdraw & off below a lower one, so it doesn't flip every frame.
+class OverdrawMonitor
+{
+public:
+	OverdrawMonitor();
+
+	void Initialize(float NewEnableOverdraw, float NewDisableOverdraw);
+
+	// Bracket the draws to count, PixelCount is the area they cover
+	void BeginMeasure();
+	void EndMeasure(unsigned long long PixelCount);
+
+	// Whether this frame should draw a pre-pass, in the given mode
+	bool UsePrepass(DepthPrepassMode Mode) const;
+
+	// Smoothed fragments per pixel, 0 until the first query returns
+	float GetOverdraw() const { return Overdraw; }
+
+	void Clear();
+
+	~OverdrawMonitor();
+
+private:
+	GPUQueryRing Queries;
+
+	float EnableOverdraw;
+	float DisableOverdraw;
+	float Overdraw;
+	bool bPrepassWanted;
+
+	void ReadQueries();
+};
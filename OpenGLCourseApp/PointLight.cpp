@@ -1,4 +1,5 @@
 #include "PointLight.h"
+#include "Shader.h"
 
 PointLight::PointLight() : Light()
 {
@@ -32,39 +33,59 @@ PointLight::PointLight(GLfloat NewShadowWidth, GLfloat NewShadowHeight,
 	MyShadowMap->Initialize(NewShadowWidth, NewShadowHeight);
 }
 
-void PointLight::UseLight(GLuint AmbientIntensityLocation, GLuint AmbientColorLocation, 
-							GLuint DiffuseIntensityLocation, GLuint PositionLocation, 
-							GLuint ConstantLocation, GLuint LinearLocation, GLuint ExponentLocation)
+void PointLight::UseLight(Shader* TheShader, UniformHandle AmbientIntensityHandle, UniformHandle AmbientColorHandle,
+							UniformHandle DiffuseIntensityHandle, UniformHandle PositionHandle,
+							UniformHandle ConstantHandle, UniformHandle LinearHandle, UniformHandle ExponentHandle)
 {
-	glUniform3f(AmbientColorLocation, Color.x, Color.y, Color.z);
-	glUniform1f(AmbientIntensityLocation, AmbientIntensity);
-	glUniform1f(DiffuseIntensityLocation, DiffuseIntensity);
-	glUniform3f(PositionLocation, Position.x, Position.y, Position.z);
-	glUniform1f(ConstantLocation, Constant);
-	glUniform1f(LinearLocation, Linear);
-	glUniform1f(ExponentLocation, Exponent);
+	TheShader->SetUniform(AmbientColorHandle, Color);
+	TheShader->SetUniform(AmbientIntensityHandle, AmbientIntensity);
+	TheShader->SetUniform(DiffuseIntensityHandle, DiffuseIntensity);
+	TheShader->SetUniform(PositionHandle, Position);
+	TheShader->SetUniform(ConstantHandle, Constant);
+	TheShader->SetUniform(LinearHandle, Linear);
+	TheShader->SetUniform(ExponentHandle, Exponent);
 }
 
-std::vector<glm::mat4> PointLight::CalculateLightTransforms()
+void PointLight::CalculateLightTransforms(glm::mat4* OutMatrices)
 {
-	std::vector<glm::mat4> LightMatrices;
 	// Define views in specific order: PosX, NegX, PosY, NegY, PosZ, NegZ
 	// Positive X
-	LightMatrices.push_back(LightProjection * glm::lookAt(Position, Position + glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
+	OutMatrices[0] = LightProjection * glm::lookAt(Position, Position + glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0));
 	// Negative X
-	LightMatrices.push_back(LightProjection * glm::lookAt(Position, Position + glm::vec3(-1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0)));
+	OutMatrices[1] = LightProjection * glm::lookAt(Position, Position + glm::vec3(-1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0));
 
 	// Positive Y
-	LightMatrices.push_back(LightProjection * glm::lookAt(Position, Position + glm::vec3(0.0, 1.0, 0.0), glm::vec3(0.0, 0.0, 1.0)));
+	OutMatrices[2] = LightProjection * glm::lookAt(Position, Position + glm::vec3(0.0, 1.0, 0.0), glm::vec3(0.0, 0.0, 1.0));
 	// Negative Y
-	LightMatrices.push_back(LightProjection * glm::lookAt(Position, Position + glm::vec3(0.0, -1.0, 0.0), glm::vec3(0.0, 0.0, -1.0)));
+	OutMatrices[3] = LightProjection * glm::lookAt(Position, Position + glm::vec3(0.0, -1.0, 0.0), glm::vec3(0.0, 0.0, -1.0));
 
 	// Positive Z
-	LightMatrices.push_back(LightProjection * glm::lookAt(Position, Position + glm::vec3(0.0, 0.0, 1.0), glm::vec3(0.0, -1.0, 0.0)));
+	OutMatrices[4] = LightProjection * glm::lookAt(Position, Position + glm::vec3(0.0, 0.0, 1.0), glm::vec3(0.0, -1.0, 0.0));
 	// Negative Z
-	LightMatrices.push_back(LightProjection * glm::lookAt(Position, Position + glm::vec3(0.0, 0.0, -1.0), glm::vec3(0.0, -1.0, 0.0)));
-		
-	return LightMatrices;
+	OutMatrices[5] = LightProjection * glm::lookAt(Position, Position + glm::vec3(0.0, 0.0, -1.0), glm::vec3(0.0, -1.0, 0.0));
+}
+
+GLfloat PointLight::CalculateRange(GLfloat MinimumIntensity)
+{
+	// Solve Exponent * d^2 + Linear * d + Constant = Intensity / MinimumIntensity for d
+	GLfloat Intensity = DiffuseIntensity * glm::max(Color.x, glm::max(Color.y, Color.z));
+	GLfloat Attenuation = Intensity / MinimumIntensity;
+	if (Attenuation <= Constant)
+	{
+		return 0.0f;
+	}
+
+	GLfloat Range = FarPlane;
+	if (Exponent > 0.0f)
+	{
+		Range = (-Linear + glm::sqrt(Linear * Linear + 4.0f * Exponent * (Attenuation - Constant))) / (2.0f * Exponent);
+	}
+	else if (Linear > 0.0f)
+	{
+		Range = (Attenuation - Constant) / Linear;
+	}
+
+	return glm::min(Range, FarPlane);
 }
 
 PointLight::~PointLight()
@@ -15,12 +15,19 @@ public:
 				GLfloat PosX, GLfloat PosY, GLfloat PosZ,
 				GLfloat NewConstant, GLfloat NewLinear, GLfloat NewExponent);
 
-	// Bind light values for use in the shader (Location here meaning the ID in the shader, not a position)
-	void UseLight(GLuint AmbientIntensityLocation, GLuint AmbientColorLocation,
-					GLuint DiffuseIntensityLocation, GLuint PositionLocation,
-					GLuint ConstantLocation, GLuint LinearLocation, GLuint ExponentLocation);
+	// Set light values on the shader in use, through its cached setters
+	void UseLight(Shader* TheShader, UniformHandle AmbientIntensityHandle, UniformHandle AmbientColorHandle,
+					UniformHandle DiffuseIntensityHandle, UniformHandle PositionHandle,
+					UniformHandle ConstantHandle, UniformHandle LinearHandle, UniformHandle ExponentHandle);
 
-	std::vector<glm::mat4> CalculateLightTransforms();
+	// Writes one view-projection per cube face to OutMatrices[0..5]: PosX, NegX, PosY, NegY, PosZ, NegZ
+	virtual void CalculateLightTransforms(glm::mat4* OutMatrices);
+
+	// Distance at which the diffuse term falls to MinimumIntensity, at most the shadow far plane
+	GLfloat CalculateRange(GLfloat MinimumIntensity);
+
+	// Point lights are always on, spot lights can be switched off
+	virtual bool IsEnabled() { return true; }
 
 	GLfloat GetFarPlane() { return FarPlane; }
 
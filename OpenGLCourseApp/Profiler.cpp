@@ -0,0 +1,92 @@
+#include <stdio.h>
+
+#include "Profiler.h"
+
+std::atomic<bool> Profiler::bCapturing{ false };
+std::mutex Profiler::EventLock;
+std::vector<Profiler::ProfileEvent> Profiler::Events;
+unsigned int Profiler::FramesRemaining = 0;
+std::string Profiler::TracePath;
+
+void Profiler::BeginCapture(unsigned int FrameCount, const std::string& OutputPath)
+{
+	if (IsCapturing())
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> Guard(EventLock);
+	Events.clear();
+	Events.reserve(FrameCount * 64);
+	FramesRemaining = FrameCount;
+	TracePath = OutputPath;
+	bCapturing = true;
+
+	printf("Profiler capturing %d frames...\n", FrameCount);
+}
+
+void Profiler::EndFrame()
+{
+	if (!IsCapturing())
+	{
+		return;
+	}
+
+	if (--FramesRemaining == 0)
+	{
+		bCapturing = false;
+		WriteTrace();
+	}
+}
+
+void Profiler::RecordEvent(const char* Name, long long StartMicros, long long DurationMicros)
+{
+	unsigned int ThreadID = GetThreadID();
+
+	std::lock_guard<std::mutex> Guard(EventLock);
+	if (!IsCapturing())
+	{
+		return;
+	}
+	Events.push_back({ Name, ThreadID, StartMicros, DurationMicros });
+}
+
+long long Profiler::GetTimeMicros()
+{
+	using namespace std::chrono;
+	return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+unsigned int Profiler::GetThreadID()
+{
+	// Small, stable IDs read better in the trace viewer than OS thread handles
+	static std::atomic<unsigned int> NextThreadID{ 0 };
+	thread_local unsigned int ThreadID = NextThreadID.fetch_add(1);
+	return ThreadID;
+}
+
+void Profiler::WriteTrace()
+{
+	std::lock_guard<std::mutex> Guard(EventLock);
+
+	FILE* TraceFile = fopen(TracePath.c_str(), "w");
+	if (!TraceFile)
+	{
+		printf("Failed to write profile trace to %s\n", TracePath.c_str());
+		return;
+	}
+
+	fprintf(TraceFile, "{\"traceEvents\":[\n");
+	for (size_t i = 0; i < Events.size(); i++)
+	{
+		const ProfileEvent& Event = Events[i];
+		fprintf(TraceFile, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%lld,\"dur\":%lld}%s\n",
+				Event.Name, Event.ThreadID, Event.StartMicros, Event.DurationMicros,
+				i + 1 < Events.size() ? "," : "");
+	}
+	fprintf(TraceFile, "]}\n");
+	fclose(TraceFile);
+
+	printf("Profiler wrote %zu events to %s\n", Events.size(), TracePath.c_str());
+	Events.clear();
+}
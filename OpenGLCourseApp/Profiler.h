@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// CPU timeline profiler
+// Scopes are recorded per thread while a capture is running, then written out as a
+// Chrome trace (open in chrome://tracing, edge://tracing or ui.perfetto.dev).
+class Profiler
+{
+public:
+	// Records the next FrameCount frames, then writes the trace to OutputPath
+	static void BeginCapture(unsigned int FrameCount, const std::string& OutputPath);
+	static bool IsCapturing() { return bCapturing.load(std::memory_order_relaxed); }
+
+	// Marks the end of a frame, finishing the capture once enough frames are recorded
+	static void EndFrame();
+
+	static void RecordEvent(const char* Name, long long StartMicros, long long DurationMicros);
+	static long long GetTimeMicros();
+
+private:
+	struct ProfileEvent
+	{
+		const char* Name;
+		unsigned int ThreadID;
+		long long StartMicros;
+		long long DurationMicros;
+	};
+
+	static std::atomic<bool> bCapturing;
+	static std::mutex EventLock;
+	static std::vector<ProfileEvent> Events;
+	static unsigned int FramesRemaining;
+	static std::string TracePath;
+
+	static unsigned int GetThreadID();
+	static void WriteTrace();
+};
+
+// Times the enclosing scope while a capture is running
+class ProfileScope
+{
+public:
+	ProfileScope(const char* NewName)
+	{
+		Name = NewName;
+		StartMicros = Profiler::IsCapturing() ? Profiler::GetTimeMicros() : -1;
+	}
+
+	~ProfileScope()
+	{
+		if (StartMicros >= 0)
+		{
+			Profiler::RecordEvent(Name, StartMicros, Profiler::GetTimeMicros() - StartMicros);
+		}
+	}
+
+private:
+	const char* Name;
+	long long StartMicros;
+};
+
+#define PROFILE_CONCAT_INNER(A, B) A##B
+#define PROFILE_CONCAT(A, B) PROFILE_CONCAT_INNER(A, B)
+#define PROFILE_SCOPE(Name) ProfileScope PROFILE_CONCAT(ProfileScope_, __LINE__)(Name)
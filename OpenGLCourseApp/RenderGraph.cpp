@@ -0,0 +1,517 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <utility>
+
+#include "RenderGraph.h"
+#include "Profiler.h"
+#include "GPUMemory.h"
+#include "Log.h"
+
+static unsigned long long HashBytes(unsigned long long Hash, const void* Data, size_t Length)
+{
+	const unsigned char* Bytes = static_cast<const unsigned char*>(Data);
+	for (size_t i = 0; i < Length; i++)
+	{
+		Hash ^= Bytes[i];
+		Hash *= 1099511628211ULL;
+	}
+	return Hash;
+}
+
+RenderGraph::RenderGraph()
+{
+	FrameMemory = std::pmr::get_default_resource();
+	CompiledSignature = 0;
+	bCompiled = false;
+}
+
+void RenderGraph::BeginFrame(std::pmr::memory_resource* NewFrameMemory)
+{
+	// Both vectors keep their capacity, the per-pass resource lists are freed with the frame
+	Resources.clear();
+	Passes.clear();
+	FrameMemory = NewFrameMemory;
+}
+
+RenderResource RenderGraph::CreateTarget(const char* Name, const RenderTargetDesc& Desc)
+{
+	Resources.push_back({ Name, Desc, false, 0 });
+	return (RenderResource)Resources.size() - 1;
+}
+
+RenderResource RenderGraph::ImportBackbuffer(const char* Name, GLsizei Width, GLsizei Height)
+{
+	Resources.push_back({ Name, { GL_TEXTURE_2D, Width, Height, GL_RGBA8, 0 }, true, 0 });
+	return (RenderResource)Resources.size() - 1;
+}
+
+RenderResource RenderGraph::ImportTarget(const char* Name, const RenderTargetDesc& Desc, GLuint Texture)
+{
+	Resources.push_back({ Name, Desc, false, Texture });
+	return (RenderResource)Resources.size() - 1;
+}
+
+void RenderGraph::AddPass(const char* Name, RenderResourceList Reads, RenderResourceList Writes, PassFunction Execute)
+{
+	Passes.push_back({ Name,
+					   std::pmr::vector<RenderResource>(Reads.begin(), Reads.end(), FrameMemory),
+					   std::pmr::vector<RenderResource>(Writes.begin(), Writes.end(), FrameMemory),
+					   std::move(Execute) });
+}
+
+void RenderGraph::Execute()
+{
+	PROFILE_SCOPE("RenderGraph");
+
+	unsigned long long Signature = CalculateSignature();
+	if (!bCompiled || Signature != CompiledSignature)
+	{
+		Compile();
+		CompiledSignature = Signature;
+		bCompiled = true;
+	}
+
+	for (size_t i = 0; i < Schedule.size(); i++)
+	{
+		const ScheduledPass& Scheduled = Schedule[i];
+		PassNode& Pass = Passes[Scheduled.PassIndex];
+
+		glBindFramebuffer(GL_FRAMEBUFFER, Scheduled.Framebuffer);
+		glViewport(0, 0, Scheduled.Width, Scheduled.Height);
+		Pass.Function();
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+GLuint RenderGraph::GetTexture(RenderResource Resource) const
+{
+	if (Resource < 0 || (size_t)Resource >= ResourceTextures.size())
+	{
+		return 0;
+	}
+	return ResourceTextures[Resource];
+}
+
+unsigned long long RenderGraph::CalculateSignature() const
+{
+	unsigned long long Hash = 14695981039346656037ULL;
+
+	for (size_t i = 0; i < Resources.size(); i++)
+	{
+		Hash = HashBytes(Hash, &Resources[i].Desc, sizeof(RenderTargetDesc));
+		Hash = HashBytes(Hash, &Resources[i].bImported, sizeof(bool));
+		Hash = HashBytes(Hash, &Resources[i].ExternalTexture, sizeof(GLuint));
+	}
+
+	for (size_t i = 0; i < Passes.size(); i++)
+	{
+		const PassNode& Pass = Passes[i];
+		Hash = HashBytes(Hash, Pass.Name, strlen(Pass.Name) + 1);
+
+		size_t Counts[2] = { Pass.Reads.size(), Pass.Writes.size() };
+		Hash = HashBytes(Hash, Counts, sizeof(Counts));
+		Hash = HashBytes(Hash, Pass.Reads.data(), Pass.Reads.size() * sizeof(RenderResource));
+		Hash = HashBytes(Hash, Pass.Writes.data(), Pass.Writes.size() * sizeof(RenderResource));
+	}
+
+	return Hash;
+}
+
+void RenderGraph::Compile()
+{
+	PROFILE_SCOPE("RenderGraph::Compile");
+
+	std::vector<bool> Live;
+	CullPasses(&Live);
+
+	std::vector<size_t> Order;
+	SortPasses(Live, &Order);
+
+	AssignTargets(Order);
+	CreateFramebuffers(Order);
+
+	LOG_INFO("Render graph compiled: %zu of %zu passes live, %zu pooled targets", Order.size(), Passes.size(), Pool.size());
+}
+
+void RenderGraph::CullPasses(std::vector<bool>* OutLive) const
+{
+	std::vector<bool>& Live = *OutLive;
+	Live.assign(Passes.size(), false);
+
+	// Passes writing the backbuffer are the roots
+	for (size_t i = 0; i < Passes.size(); i++)
+	{
+		for (size_t w = 0; w < Passes[i].Writes.size(); w++)
+		{
+			if (Resources[Passes[i].Writes[w]].bImported)
+			{
+				Live[i] = true;
+			}
+		}
+	}
+
+	// Then anything producing a resource a live pass reads, until nothing changes
+	bool bChanged = true;
+	while (bChanged)
+	{
+		bChanged = false;
+		for (size_t i = 0; i < Passes.size(); i++)
+		{
+			if (!Live[i])
+			{
+				continue;
+			}
+
+			for (size_t r = 0; r < Passes[i].Reads.size(); r++)
+			{
+				for (size_t j = 0; j < Passes.size(); j++)
+				{
+					if (!Live[j] && std::find(Passes[j].Writes.begin(), Passes[j].Writes.end(), Passes[i].Reads[r]) != Passes[j].Writes.end())
+					{
+						Live[j] = true;
+						bChanged = true;
+					}
+				}
+			}
+		}
+	}
+}
+
+void RenderGraph::SortPasses(const std::vector<bool>& Live, std::vector<size_t>* OutOrder) const
+{
+	// Kahn's algorithm, ties broken by declaration order so the schedule is stable
+	std::vector<std::vector<size_t>> Dependents(Passes.size());
+	std::vector<int> Dependencies(Passes.size(), 0);
+
+	for (size_t Writer = 0; Writer < Passes.size(); Writer++)
+	{
+		if (!Live[Writer])
+		{
+			continue;
+		}
+
+		for (size_t Reader = 0; Reader < Passes.size(); Reader++)
+		{
+			if (Reader == Writer || !Live[Reader])
+			{
+				continue;
+			}
+
+			for (size_t w = 0; w < Passes[Writer].Writes.size(); w++)
+			{
+				if (std::find(Passes[Reader].Reads.begin(), Passes[Reader].Reads.end(), Passes[Writer].Writes[w]) != Passes[Reader].Reads.end())
+				{
+					Dependents[Writer].push_back(Reader);
+					Dependencies[Reader]++;
+					break;
+				}
+			}
+		}
+	}
+
+	std::vector<bool> Scheduled(Passes.size(), false);
+	OutOrder->clear();
+
+	bool bProgress = true;
+	while (bProgress)
+	{
+		bProgress = false;
+		for (size_t i = 0; i < Passes.size(); i++)
+		{
+			if (Live[i] && !Scheduled[i] && Dependencies[i] == 0)
+			{
+				Scheduled[i] = true;
+				OutOrder->push_back(i);
+				for (size_t d = 0; d < Dependents[i].size(); d++)
+				{
+					Dependencies[Dependents[i][d]]--;
+				}
+				bProgress = true;
+				break;
+			}
+		}
+	}
+
+	// A cycle means a pass reads its own output somewhere, run the rest in declaration order
+	for (size_t i = 0; i < Passes.size(); i++)
+	{
+		if (Live[i] && !Scheduled[i])
+		{
+			LOG_ERROR("Render graph pass %s is part of a dependency cycle!", Passes[i].Name);
+			OutOrder->push_back(i);
+		}
+	}
+}
+
+void RenderGraph::AssignTargets(const std::vector<size_t>& Order)
+{
+	// Lifetime of every target in schedule slots
+	std::vector<int> FirstUse(Resources.size(), -1);
+	std::vector<int> LastUse(Resources.size(), -1);
+
+	for (size_t Slot = 0; Slot < Order.size(); Slot++)
+	{
+		const PassNode& Pass = Passes[Order[Slot]];
+		std::vector<RenderResource> Used(Pass.Reads.begin(), Pass.Reads.end());
+		Used.insert(Used.end(), Pass.Writes.begin(), Pass.Writes.end());
+
+		for (size_t u = 0; u < Used.size(); u++)
+		{
+			if (FirstUse[Used[u]] < 0)
+			{
+				FirstUse[Used[u]] = (int)Slot;
+			}
+			LastUse[Used[u]] = (int)Slot;
+		}
+	}
+
+	std::vector<RenderResource> ByFirstUse;
+	for (size_t i = 0; i < Resources.size(); i++)
+	{
+		if (!Resources[i].bImported && !Resources[i].ExternalTexture && FirstUse[i] >= 0)
+		{
+			ByFirstUse.push_back((RenderResource)i);
+		}
+	}
+	std::stable_sort(ByFirstUse.begin(), ByFirstUse.end(), [&FirstUse](RenderResource A, RenderResource B)
+	{
+		return FirstUse[A] < FirstUse[B];
+	});
+
+	for (size_t i = 0; i < Pool.size(); i++)
+	{
+		Pool[i].AvailableAfter = -1;
+		Pool[i].bUsed = false;
+	}
+
+	// A pooled texture can back a target once the previous target using it is dead
+	ResourceTextures.assign(Resources.size(), 0);
+	for (size_t i = 0; i < Resources.size(); i++)
+	{
+		ResourceTextures[i] = Resources[i].ExternalTexture;
+	}
+	for (size_t i = 0; i < ByFirstUse.size(); i++)
+	{
+		RenderResource Resource = ByFirstUse[i];
+		const RenderTargetDesc& Desc = Resources[Resource].Desc;
+
+		PooledTarget* Match = nullptr;
+		for (size_t p = 0; p < Pool.size() && !Match; p++)
+		{
+			if (Pool[p].AvailableAfter < FirstUse[Resource] && memcmp(&Pool[p].Desc, &Desc, sizeof(RenderTargetDesc)) == 0)
+			{
+				Match = &Pool[p];
+			}
+		}
+
+		if (!Match)
+		{
+			Pool.push_back({ Desc, CreateTexture(Desc), -1, false });
+			Match = &Pool.back();
+		}
+
+		Match->AvailableAfter = LastUse[Resource];
+		Match->bUsed = true;
+		ResourceTextures[Resource] = Match->Texture;
+	}
+
+	// Free whatever the new topology no longer needs
+	for (size_t i = 0; i < Pool.size();)
+	{
+		if (!Pool[i].bUsed)
+		{
+			DeleteTexture(Pool[i].Desc, Pool[i].Texture);
+			Pool.erase(Pool.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+
+void RenderGraph::CreateFramebuffers(const std::vector<size_t>& Order)
+{
+	if (!Framebuffers.empty())
+	{
+		glDeleteFramebuffers((GLsizei)Framebuffers.size(), Framebuffers.data());
+		Framebuffers.clear();
+	}
+
+	Schedule.clear();
+	for (size_t Slot = 0; Slot < Order.size(); Slot++)
+	{
+		const PassNode& Pass = Passes[Order[Slot]];
+		ScheduledPass Scheduled = { Order[Slot], 0, 0, 0 };
+
+		if (!Pass.Writes.empty())
+		{
+			Scheduled.Width = Resources[Pass.Writes[0]].Desc.Width;
+			Scheduled.Height = Resources[Pass.Writes[0]].Desc.Height;
+		}
+
+		// Backbuffer passes draw to the default framebuffer
+		if (!Pass.Writes.empty() && !Resources[Pass.Writes[0]].bImported)
+		{
+			glGenFramebuffers(1, &Scheduled.Framebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, Scheduled.Framebuffer);
+			Framebuffers.push_back(Scheduled.Framebuffer);
+
+			GLenum ColorAttachments[8];
+			GLsizei ColorCount = 0;
+			for (size_t w = 0; w < Pass.Writes.size(); w++)
+			{
+				RenderResource Target = Pass.Writes[w];
+				if (IsDepthFormat(Resources[Target].Desc.InternalFormat))
+				{
+					glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, ResourceTextures[Target], 0);
+				}
+				else if (ColorCount < 8)
+				{
+					ColorAttachments[ColorCount] = GL_COLOR_ATTACHMENT0 + ColorCount;
+					glFramebufferTexture(GL_FRAMEBUFFER, ColorAttachments[ColorCount], ResourceTextures[Target], 0);
+					ColorCount++;
+				}
+			}
+
+			// Depth only targets don't draw or read from Color attachments
+			if (ColorCount == 0)
+			{
+				glDrawBuffer(GL_NONE);
+				glReadBuffer(GL_NONE);
+			}
+			else
+			{
+				glDrawBuffers(ColorCount, ColorAttachments);
+			}
+
+			GLenum Status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+			if (Status != GL_FRAMEBUFFER_COMPLETE)
+			{
+				LOG_ERROR("Render graph framebuffer for %s incomplete: %i", Pass.Name, Status);
+			}
+		}
+
+		Schedule.push_back(Scheduled);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+GLuint RenderGraph::CreateTexture(const RenderTargetDesc& Desc)
+{
+	bool bDepth = IsDepthFormat(Desc.InternalFormat);
+	GLenum Format = bDepth ? GL_DEPTH_COMPONENT : GL_RGBA;
+	GLenum Type = bDepth ? GL_FLOAT : GL_UNSIGNED_BYTE;
+	GLsizei Levels = Desc.MipLevels > 1 ? Desc.MipLevels : 1;
+
+	GLuint Texture = 0;
+	glGenTextures(1, &Texture);
+	glBindTexture(Desc.Target, Texture);
+
+	for (GLsizei Level = 0; Level < Levels; Level++)
+	{
+		GLsizei LevelWidth = std::max(Desc.Width >> Level, 1);
+		GLsizei LevelHeight = std::max(Desc.Height >> Level, 1);
+
+		if (Desc.Target == GL_TEXTURE_CUBE_MAP)
+		{
+			for (size_t i = 0; i < 6; i++)
+			{
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, Level, Desc.InternalFormat, LevelWidth, LevelHeight, 0, Format, Type, nullptr);
+			}
+		}
+		else
+		{
+			glTexImage2D(GL_TEXTURE_2D, Level, Desc.InternalFormat, LevelWidth, LevelHeight, 0, Format, Type, nullptr);
+		}
+	}
+
+	if (Desc.Target == GL_TEXTURE_CUBE_MAP)
+	{
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	}
+	else if (bDepth)
+	{
+		// Anything outside a 2D shadow map counts as lit
+		float BorderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, BorderColor);
+	}
+	else
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	glTexParameteri(Desc.Target, GL_TEXTURE_MAX_LEVEL, Levels - 1);
+	glTexParameteri(Desc.Target, GL_TEXTURE_MIN_FILTER, Levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(Desc.Target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Depth targets are read through shadow samplers, linear filtering then blends 4 depth compares per tap
+	if (bDepth)
+	{
+		glTexParameteri(Desc.Target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(Desc.Target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	}
+	glBindTexture(Desc.Target, 0);
+
+	unsigned int Faces = Desc.Target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+	GPUMemory::TrackAllocation(bDepth ? GPU_MEMORY_SHADOW_MAPS : GPU_MEMORY_RENDER_TARGETS,
+		GPUMemory::CalculateTextureBytes(Desc.Width, Desc.Height, Desc.InternalFormat, Faces, Levels > 1));
+
+	return Texture;
+}
+
+void RenderGraph::DeleteTexture(const RenderTargetDesc& Desc, GLuint Texture)
+{
+	unsigned int Faces = Desc.Target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+	GPUMemory::TrackRelease(IsDepthFormat(Desc.InternalFormat) ? GPU_MEMORY_SHADOW_MAPS : GPU_MEMORY_RENDER_TARGETS,
+		GPUMemory::CalculateTextureBytes(Desc.Width, Desc.Height, Desc.InternalFormat, Faces, Desc.MipLevels > 1));
+
+	glDeleteTextures(1, &Texture);
+}
+
+GLsizei RenderGraph::CalculateMipLevels(GLsizei Width, GLsizei Height)
+{
+	GLsizei Levels = 1;
+	while ((Width >> Levels) > 0 || (Height >> Levels) > 0)
+	{
+		Levels++;
+	}
+	return Levels;
+}
+
+bool RenderGraph::IsDepthFormat(GLenum Format)
+{
+	return Format == GL_DEPTH_COMPONENT || Format == GL_DEPTH_COMPONENT16 || Format == GL_DEPTH_COMPONENT24 ||
+		   Format == GL_DEPTH_COMPONENT32 || Format == GL_DEPTH_COMPONENT32F;
+}
+
+void RenderGraph::ReleaseResources()
+{
+	if (!Framebuffers.empty())
+	{
+		glDeleteFramebuffers((GLsizei)Framebuffers.size(), Framebuffers.data());
+		Framebuffers.clear();
+	}
+
+	for (size_t i = 0; i < Pool.size(); i++)
+	{
+		DeleteTexture(Pool[i].Desc, Pool[i].Texture);
+	}
+	Pool.clear();
+
+	Schedule.clear();
+	ResourceTextures.clear();
+	bCompiled = false;
+}
+
+RenderGraph::~RenderGraph()
+{
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <functional>
+#include <initializer_list>
+#include <memory_resource>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Index of a resource declared this frame
+typedef int RenderResource;
+const RenderResource INVALID_RENDER_RESOURCE = -1;
+
+// Resources a pass reads or writes, from a braced list or any vector, only valid during the AddPass call
+// A braced list is referred to as a whole, its array lives as long as the list object, until the call returns
+struct RenderResourceList
+{
+	RenderResourceList(const std::initializer_list<RenderResource>& List) : BracedList(&List), Data(nullptr), Count(0) {}
+
+	template <typename Allocator>
+	RenderResourceList(const std::vector<RenderResource, Allocator>& List) : BracedList(nullptr), Data(List.data()), Count(List.size()) {}
+
+	const RenderResource* begin() const { return BracedList ? BracedList->begin() : Data; }
+	const RenderResource* end() const { return BracedList ? BracedList->end() : Data + Count; }
+
+private:
+	const std::initializer_list<RenderResource>* BracedList;
+	const RenderResource* Data;
+	size_t Count;
+};
+
+struct RenderTargetDesc
+{
+	GLenum Target;				// GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+	GLsizei Width;
+	GLsizei Height;
+	GLenum InternalFormat;		// Depth formats attach as depth, anything else as color 0
+	GLsizei MipLevels;			// 0 or 1 = base level only, further levels are allocated for the writing pass to fill
+};
+
+// Frame graph
+// Every frame the passes are declared with the resources they read & write, then Execute():
+//  - culls passes whose output nothing reads (only the backbuffer counts as a final output)
+//  - orders the remaining passes so every write happens before its reads
+//  - gives each transient target a pooled texture, targets whose lifetimes don't overlap share one
+//  - binds each pass' framebuffer & sets the viewport to its target before running it
+// Compiling only happens when the declared topology differs from the last frame's, otherwise the
+// previous schedule, textures & framebuffers are reused as they are.
+class RenderGraph
+{
+public:
+	typedef std::function<void()> PassFunction;
+
+	RenderGraph();
+
+	// Drops last frame's declarations, keeps the compiled schedule & pooled textures
+	// Pass declarations are allocated from FrameMemory, which has to stay valid until the next BeginFrame
+	void BeginFrame(std::pmr::memory_resource* NewFrameMemory);
+
+	// Name must outlive the frame (a string literal), it is used for the profiler
+	RenderResource CreateTarget(const char* Name, const RenderTargetDesc& Desc);
+	RenderResource ImportBackbuffer(const char* Name, GLsizei Width, GLsizei Height);
+
+	// A texture owned outside the graph that keeps its contents across frames (e.g. a cached shadow map)
+	// It isn't pooled, & like a transient target its writer is culled unless a live pass reads it
+	RenderResource ImportTarget(const char* Name, const RenderTargetDesc& Desc, GLuint Texture);
+
+	void AddPass(const char* Name, RenderResourceList Reads, RenderResourceList Writes, PassFunction Execute);
+
+	void Execute();
+
+	// Texture backing a target this frame, 0 if the target was culled or is the backbuffer
+	GLuint GetTexture(RenderResource Resource) const;
+
+	size_t GetLivePassCount() const { return Schedule.size(); }
+	size_t GetPooledTargetCount() const { return Pool.size(); }
+
+	// Levels in a full mip chain down to 1x1
+	static GLsizei CalculateMipLevels(GLsizei Width, GLsizei Height);
+
+	// Allocates & frees a texture the way the graph does for its targets, for textures imported with ImportTarget
+	static GLuint CreateTexture(const RenderTargetDesc& Desc);
+	static void DeleteTexture(const RenderTargetDesc& Desc, GLuint Texture);
+
+	// Releases every GL object, call while the context is alive
+	void ReleaseResources();
+
+	~RenderGraph();
+
+private:
+	struct ResourceNode
+	{
+		const char* Name;
+		RenderTargetDesc Desc;
+		bool bImported;				// The backbuffer
+		GLuint ExternalTexture;		// From ImportTarget, 0 for graph owned targets
+	};
+
+	struct PassNode
+	{
+		const char* Name;
+		std::pmr::vector<RenderResource> Reads;
+		std::pmr::vector<RenderResource> Writes;
+		PassFunction Function;
+	};
+
+	// A compiled pass: which declared pass to run, its framebuffer & viewport
+	struct ScheduledPass
+	{
+		size_t PassIndex;
+		GLuint Framebuffer;
+		GLsizei Width;
+		GLsizei Height;
+	};
+
+	struct PooledTarget
+	{
+		RenderTargetDesc Desc;
+		GLuint Texture;
+		int AvailableAfter;			// Last schedule slot using it during the current compile
+		bool bUsed;
+	};
+
+	std::pmr::memory_resource* FrameMemory;
+	std::vector<ResourceNode> Resources;
+	std::vector<PassNode> Passes;
+
+	// Compiled state, valid while the topology signature matches
+	unsigned long long CompiledSignature;
+	bool bCompiled;
+	std::vector<ScheduledPass> Schedule;
+	std::vector<GLuint> ResourceTextures;
+	std::vector<GLuint> Framebuffers;
+	std::vector<PooledTarget> Pool;
+
+	unsigned long long CalculateSignature() const;
+	void Compile();
+	void CullPasses(std::vector<bool>* OutLive) const;
+	void SortPasses(const std::vector<bool>& Live, std::vector<size_t>* OutOrder) const;
+	void AssignTargets(const std::vector<size_t>& Order);
+	void CreateFramebuffers(const std::vector<size_t>& Order);
+
+	static bool IsDepthFormat(GLenum Format);
+};
@@ -1,22 +1,46 @@
 #include "Shader.h"
+#include "Log.h"
+
+unsigned int Shader::NextProgramGeneration = 1;
 
 
 Shader::Shader()
 {
     ShaderID = 0;
-    UniformModel = 0;
-    UniformView = 0;
-    UniformProjection = 0;
-    UniformEyePosition = 0;
-    UniformDirectionalLight.UniformAmbientIntensity = 0;
-    UniformDirectionalLight.UniformColor = 0;
-    UniformDirectionalLight.UniformDirection = 0;
-    UniformDirectionalLight.UniformDiffuseIntensity = 0;
-    UniformSpecularIntensity = 0;
-    UniformShininess = 0;
-    PointLightCount = 0;
-    UniformPointLightCount = 0;
-    UniformSpotLightCount = 0;
+    UniformModel = INVALID_UNIFORM;
+    UniformView = INVALID_UNIFORM;
+    UniformProjection = INVALID_UNIFORM;
+    UniformEyePosition = INVALID_UNIFORM;
+    UniformDirectionalLight.UniformAmbientIntensity = INVALID_UNIFORM;
+    UniformDirectionalLight.UniformColor = INVALID_UNIFORM;
+    UniformDirectionalLight.UniformDirection = INVALID_UNIFORM;
+    UniformDirectionalLight.UniformDiffuseIntensity = INVALID_UNIFORM;
+    UniformSpecularIntensity = INVALID_UNIFORM;
+    UniformShininess = INVALID_UNIFORM;
+    UniformTexture = INVALID_UNIFORM;
+    UniformDirectionalLightTransform = INVALID_UNIFORM;
+    UniformDirectionalShadowMap = INVALID_UNIFORM;
+    UniformOmniLightPosition = INVALID_UNIFORM;
+    UniformFarPlane = INVALID_UNIFORM;
+    PendingID = 0;
+    PendingCacheKey = 0;
+    PendingFrames = 0;
+    ProgramGeneration = 0;
+}
+
+void Shader::EnableParallelCompile()
+{
+    // Let the driver compile & link on as many of its own threads as it likes
+    if (GLEW_KHR_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        printf("Parallel shader compile enabled (KHR)\n");
+    }
+    else if (GLEW_ARB_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        printf("Parallel shader compile enabled (ARB)\n");
+    }
 }
 
 void Shader::CreateFromString(const char* VertexCode, const char* FragmentCode)
@@ -26,8 +50,13 @@ void Shader::CreateFromString(const char* VertexCode, const char* FragmentCode)
 
 void Shader::CreateFromFiles(const char* VertexPath, const char* FragmentPath)
 {
-    std::string VertexString = ReadFile(VertexPath);
-    std::string FragmentString = ReadFile(FragmentPath);
+    SourceVertexPath = VertexPath;
+    SourceFragmentPath = FragmentPath;
+    SourceGeometryPath = "";
+
+    IncludedFiles.clear();
+    std::string VertexString = PreprocessFile(VertexPath, 0);
+    std::string FragmentString = PreprocessFile(FragmentPath, 0);
     const char* VertexCode = VertexString.c_str();
     const char* FragmentCode = FragmentString.c_str();
     CompileShader(VertexCode, FragmentCode);
@@ -35,15 +64,154 @@ void Shader::CreateFromFiles(const char* VertexPath, const char* FragmentPath)
 
 void Shader::CreateFromFiles(const char* VertexPath, const char* FragmentPath, const char* GeometryPath)
 {
-    std::string VertexString = ReadFile(VertexPath);
-    std::string FragmentString = ReadFile(FragmentPath);
-    std::string GeometryString = ReadFile(GeometryPath);
+    SourceVertexPath = VertexPath;
+    SourceFragmentPath = FragmentPath;
+    SourceGeometryPath = GeometryPath;
+
+    IncludedFiles.clear();
+    std::string VertexString = PreprocessFile(VertexPath, 0);
+    std::string FragmentString = PreprocessFile(FragmentPath, 0);
+    std::string GeometryString = PreprocessFile(GeometryPath, 0);
     const char* VertexCode = VertexString.c_str();
     const char* FragmentCode = FragmentString.c_str();
     const char* GeometryCode = GeometryString.c_str();
     CompileShader(VertexCode, FragmentCode, GeometryCode);
 }
 
+void Shader::CreateFromFilesAsync(const char* VertexPath, const char* FragmentPath, const char* GeometryPath)
+{
+    SourceVertexPath = VertexPath;
+    SourceFragmentPath = FragmentPath;
+    SourceGeometryPath = GeometryPath;
+
+    IncludedFiles.clear();
+    std::string VertexString = PreprocessFile(SourceVertexPath, 0);
+    std::string FragmentString = PreprocessFile(SourceFragmentPath, 0);
+    std::string GeometryString = SourceGeometryPath.empty() ? "" : PreprocessFile(SourceGeometryPath, 0);
+    const char* GeometryCode = SourceGeometryPath.empty() ? nullptr : GeometryString.c_str();
+
+    // A cached binary only needs uploading, that is cheap enough to do right away
+    unsigned long long CacheKey = ShaderCache::CalculateKey({ VertexString.c_str(), FragmentString.c_str(), GeometryCode });
+    GLuint CachedID = glCreateProgram();
+    if (ShaderCache::LoadProgram(CacheKey, CachedID))
+    {
+        ShaderID = CachedID;
+        ResolveUniforms();
+        return;
+    }
+    glDeleteProgram(CachedID);
+
+    StartPendingLink(VertexString, FragmentString, GeometryCode);
+
+    LOG_INFO("Compiling shader %s in the background...", SourceFragmentPath.c_str());
+}
+
+bool Shader::UsesFile(const std::string& FilePath)
+{
+    if (FilePath == SourceVertexPath || FilePath == SourceFragmentPath || FilePath == SourceGeometryPath)
+    {
+        return true;
+    }
+
+    return std::find(IncludedFiles.begin(), IncludedFiles.end(), FilePath) != IncludedFiles.end();
+}
+
+void Shader::Reload()
+{
+    if (SourceVertexPath.empty())
+    {
+        return;
+    }
+
+    // A newer edit supersedes a compile that is still in flight
+    if (PendingID != 0)
+    {
+        glDeleteProgram(PendingID);
+        PendingID = 0;
+    }
+
+    IncludedFiles.clear();
+    std::string VertexString = PreprocessFile(SourceVertexPath, 0);
+    std::string FragmentString = PreprocessFile(SourceFragmentPath, 0);
+    std::string GeometryString = SourceGeometryPath.empty() ? "" : PreprocessFile(SourceGeometryPath, 0);
+    const char* GeometryCode = SourceGeometryPath.empty() ? nullptr : GeometryString.c_str();
+
+    StartPendingLink(VertexString, FragmentString, GeometryCode);
+
+    LOG_INFO("Recompiling shader %s...", SourceFragmentPath.c_str());
+}
+
+void Shader::StartPendingLink(const std::string& VertexString, const std::string& FragmentString, const char* GeometryCode)
+{
+    PendingCacheKey = ShaderCache::CalculateKey({ VertexString.c_str(), FragmentString.c_str(), GeometryCode });
+    PendingFrames = 0;
+
+    // Queue the compiles & link without asking for any status, so nothing here waits on the driver
+    PendingID = glCreateProgram();
+    AddShaderAsync(PendingID, VertexString.c_str(), GL_VERTEX_SHADER);
+    AddShaderAsync(PendingID, FragmentString.c_str(), GL_FRAGMENT_SHADER);
+    if (GeometryCode)
+    {
+        AddShaderAsync(PendingID, GeometryCode, GL_GEOMETRY_SHADER);
+    }
+
+    if (ShaderCache::IsSupported())
+    {
+        glProgramParameteri(PendingID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    glLinkProgram(PendingID);
+}
+
+bool Shader::UpdatePending()
+{
+    if (PendingID == 0)
+    {
+        return false;
+    }
+
+    PendingFrames++;
+
+    if (GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile)
+    {
+        // Non-blocking query, the link finishes on the driver's threads
+        GLint bComplete = GL_FALSE;
+        glGetProgramiv(PendingID, GL_COMPLETION_STATUS_KHR, &bComplete);
+        if (!bComplete)
+        {
+            return false;
+        }
+    }
+    else if (PendingFrames < DeferredStatusFrames)
+    {
+        // Without the extension any status query can block, so give the driver a few frames first
+        return false;
+    }
+
+    GLint Result = 0;
+    GLchar ErrorLog[1024] = { 0 };
+    glGetProgramiv(PendingID, GL_LINK_STATUS, &Result);
+    if (!Result)
+    {
+        glGetProgramInfoLog(PendingID, sizeof(ErrorLog), NULL, ErrorLog);
+        LOG_ERROR("Shader reload failed, keeping the previous program: '%s'", ErrorLog);
+        glDeleteProgram(PendingID);
+        PendingID = 0;
+        return false;
+    }
+
+    // Swap in the new program, the old one (if any) stayed in use until now
+    glDeleteProgram(ShaderID);
+    ShaderID = PendingID;
+    PendingID = 0;
+
+    ResolveUniforms();
+    ShaderCache::SaveProgram(PendingCacheKey, ShaderID);
+
+    LOG_INFO("Shader %s reloaded after %d frames", SourceFragmentPath.c_str(), PendingFrames);
+    return true;
+}
+
 std::string Shader::ReadFile(const char* FilePath)
 {
     std::string Content;
@@ -67,25 +235,80 @@ std::string Shader::ReadFile(const char* FilePath)
     return Content;
 }
 
+void Shader::SetDefines(const std::string& NewDefines)
+{
+    Defines = NewDefines;
+}
+
+std::string Shader::PreprocessFile(const std::string& FilePath, unsigned int Depth)
+{
+    if (Depth > MaxIncludeDepth)
+    {
+        printf("Shader includes nested too deep at %s, is there a cycle?\n", FilePath.c_str());
+        return "";
+    }
+
+    // Includes are relative to the file that includes them
+    std::string Directory = FilePath.substr(0, FilePath.find_last_of('/') + 1);
+
+    std::istringstream Source(ReadFile(FilePath.c_str()));
+    std::string Output;
+    std::string Line;
+
+    while (std::getline(Source, Line))
+    {
+        size_t Start = Line.find_first_not_of(" \t");
+        if (Start != std::string::npos && Line.compare(Start, 8, "#include") == 0)
+        {
+            size_t NameStart = Line.find('"', Start);
+            size_t NameEnd = NameStart == std::string::npos ? std::string::npos : Line.find('"', NameStart + 1);
+            if (NameEnd == std::string::npos)
+            {
+                printf("Malformed #include in %s: '%s'\n", FilePath.c_str(), Line.c_str());
+                continue;
+            }
+
+            std::string IncludePath = Directory + Line.substr(NameStart + 1, NameEnd - NameStart - 1);
+            if (std::find(IncludedFiles.begin(), IncludedFiles.end(), IncludePath) == IncludedFiles.end())
+            {
+                IncludedFiles.push_back(IncludePath);
+            }
+
+            Output += PreprocessFile(IncludePath, Depth + 1);
+            continue;
+        }
+
+        Output += Line + "\n";
+
+        // GLSL wants #version first, so the permutation defines go straight after it
+        if (Depth == 0 && Start != std::string::npos && Line.compare(Start, 8, "#version") == 0)
+        {
+            Output += Defines;
+        }
+    }
+
+    return Output;
+}
+
 // Getters for Uniform Variables
 GLuint Shader::GetProjectionLocation()
 {
-    return UniformProjection;
+    return Reflection.GetLocation(UniformProjection);
 }
 
 GLuint Shader::GetViewLocation()
 {
-    return UniformView;
+    return Reflection.GetLocation(UniformView);
 }
 
 GLuint Shader::GetModelLocation()
 {
-    return UniformModel;
+    return Reflection.GetLocation(UniformModel);
 }
 
 GLuint Shader::GetEyePositionLocation()
 {
-    return UniformEyePosition;
+    return Reflection.GetLocation(UniformEyePosition);
 }
 
 GLuint Shader::GetAmbientColorLocation()
@@ -110,22 +333,22 @@ GLuint Shader::GetDiffuseIntensityLocation()
 
 GLuint Shader::GetSpecularIntensityLocation()
 {
-    return UniformSpecularIntensity;
+    return Reflection.GetLocation(UniformSpecularIntensity);
 }
 
 GLuint Shader::GetShininessLocation()
 {
-    return UniformShininess;
+    return Reflection.GetLocation(UniformShininess);
 }
 
 GLuint Shader::GetOmniLightPositionLocation()
 {
-    return UniformOmniLightPosition;
+    return Reflection.GetLocation(UniformOmniLightPosition);
 }
 
 GLuint Shader::GetFarPlaneLocation()
 {
-    return UniformFarPlane;
+    return Reflection.GetLocation(UniformFarPlane);
 }
 
 void Shader::ValidateShader()
@@ -140,40 +363,19 @@ void Shader::ValidateShader()
     if (!Result)
     {
         glGetProgramInfoLog(ShaderID, sizeof(ErrorLog), NULL, ErrorLog);
-        printf("Error validating the Shader Program: '%s'\n", ErrorLog);
+        // Runs every pass of every frame, so a broken program would otherwise flood the log
+        LOG_RATE_LIMITED(1000, LOG_LEVEL_ERROR, "Error validating the Shader Program: '%s'", ErrorLog);
         return;
     }
     else
     {
-        printf("Validation succeeded!\n");
+        LOG_TRACE("Validation succeeded!");
     }
 }
 
 void Shader::CompileShader(const char* VertexCode, const char* FragmentCode)
 {
-    // Create the empty Shader Program
-    ShaderID = glCreateProgram();
-
-    printf("OpenGL version is (%s)\n", glGetString(GL_VERSION));
-
-    if (!ShaderID)
-    {
-        printf("Error creating the Shader Program!");
-        return;
-    }
-    else
-    {
-        printf("Clean shader program created\n");
-    }
-
-    // Add shaders to the program
-    printf("Add Vertex Shader...\n");
-    AddShader(ShaderID, VertexCode, GL_VERTEX_SHADER);
-
-    printf("Add Fragment Shader...\n");
-    AddShader(ShaderID, FragmentCode, GL_FRAGMENT_SHADER);
-
-    CompileProgram();
+    CompileShader(VertexCode, FragmentCode, nullptr);
 }
 
 void Shader::CompileShader(const char* VertexCode, const char* FragmentCode, const char* GeometryCode)
@@ -193,6 +395,19 @@ void Shader::CompileShader(const char* VertexCode, const char* FragmentCode, con
         printf("Clean shader program created\n");
     }
 
+    // Reuse the linked binary if this driver has built these sources before
+    unsigned long long CacheKey = ShaderCache::CalculateKey({ VertexCode, FragmentCode, GeometryCode });
+    if (ShaderCache::LoadProgram(CacheKey, ShaderID))
+    {
+        printf("Loaded Shader Program from cache (%016llx)\n", CacheKey);
+        ResolveUniforms();
+        return;
+    }
+
+    // No entry, or the driver rejected it: start over with a fresh program & compile from source
+    glDeleteProgram(ShaderID);
+    ShaderID = glCreateProgram();
+
     // Add shaders to the program
     printf("Add Vertex Shader...\n");
     AddShader(ShaderID, VertexCode, GL_VERTEX_SHADER);
@@ -200,10 +415,21 @@ void Shader::CompileShader(const char* VertexCode, const char* FragmentCode, con
     printf("Add Fragment Shader...\n");
     AddShader(ShaderID, FragmentCode, GL_FRAGMENT_SHADER);
 
-    printf("Add Geometry Shader...\n");
-    AddShader(ShaderID, GeometryCode, GL_GEOMETRY_SHADER);
+    if (GeometryCode)
+    {
+        printf("Add Geometry Shader...\n");
+        AddShader(ShaderID, GeometryCode, GL_GEOMETRY_SHADER);
+    }
+
+    if (ShaderCache::IsSupported())
+    {
+        glProgramParameteri(ShaderID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
 
-    CompileProgram();
+    if (CompileProgram())
+    {
+        ShaderCache::SaveProgram(CacheKey, ShaderID);
+    }
 }
 
 void Shader::UseShader()
@@ -219,27 +445,46 @@ void Shader::ClearShader()
         ShaderID = 0;
     }
 
-    UniformModel = 0;
-    UniformView = 0;
-    UniformProjection = 0;
-    UniformEyePosition = 0;
-    UniformDirectionalLight.UniformAmbientIntensity = 0;
-    UniformDirectionalLight.UniformColor = 0;
-    UniformDirectionalLight.UniformDirection = 0;
-    UniformDirectionalLight.UniformDiffuseIntensity = 0;
-    UniformSpecularIntensity = 0;
-    UniformShininess = 0;
+    if (PendingID != 0)
+    {
+        glDeleteProgram(PendingID);
+        PendingID = 0;
+    }
+
+    UniformModel = INVALID_UNIFORM;
+    UniformView = INVALID_UNIFORM;
+    UniformProjection = INVALID_UNIFORM;
+    UniformEyePosition = INVALID_UNIFORM;
+    UniformDirectionalLight.UniformAmbientIntensity = INVALID_UNIFORM;
+    UniformDirectionalLight.UniformColor = INVALID_UNIFORM;
+    UniformDirectionalLight.UniformDirection = INVALID_UNIFORM;
+    UniformDirectionalLight.UniformDiffuseIntensity = INVALID_UNIFORM;
+    UniformSpecularIntensity = INVALID_UNIFORM;
+    UniformShininess = INVALID_UNIFORM;
+    UniformTexture = INVALID_UNIFORM;
+    UniformDirectionalLightTransform = INVALID_UNIFORM;
+    UniformDirectionalShadowMap = INVALID_UNIFORM;
+    UniformOmniLightPosition = INVALID_UNIFORM;
+    UniformFarPlane = INVALID_UNIFORM;
+    UniformPointLights.clear();
+    UniformSpotLights.clear();
+    UniformOmniShadowMaps.clear();
+    UniformSpotShadowMaps.clear();
+    UniformLightMatrices.clear();
+    Reflection.Clear();
 }
 
 void Shader::SetDirectionalLight(DirectionalLight* MyDirectionalLight)
 {
     /*      Expected signature:
-    	void UseLight(GLuint AmbientIntensityLocation, 
-                        GLuint AmbientColorLocation,
-		                GLuint DiffuseIntensityLocation, 
-                        GLuint DirectionLocation);
+    	void UseLight(Shader* TheShader,
+                        UniformHandle AmbientIntensityHandle,
+                        UniformHandle AmbientColorHandle,
+                        UniformHandle DiffuseIntensityHandle,
+                        UniformHandle DirectionHandle);
     */
-    MyDirectionalLight->UseLight(UniformDirectionalLight.UniformAmbientIntensity, 
+    MyDirectionalLight->UseLight(this,
+                                    UniformDirectionalLight.UniformAmbientIntensity,
                                     UniformDirectionalLight.UniformColor,
                                     UniformDirectionalLight.UniformDiffuseIntensity, 
                                     UniformDirectionalLight.UniformDirection);
@@ -247,99 +492,199 @@ void Shader::SetDirectionalLight(DirectionalLight* MyDirectionalLight)
 
 void Shader::SetPointLights(PointLight* MyPointLights, unsigned int NewLightCount, unsigned int TextureUnit, unsigned int Offset)
 {
-    if (NewLightCount > MAX_POINT_LIGHTS)
+    // The permutation in use may declare fewer lights than the scene has
+    if (NewLightCount > UniformPointLights.size())
     {
-        NewLightCount = MAX_POINT_LIGHTS;
+        NewLightCount = (unsigned int)UniformPointLights.size();
     }
 
-    glUniform1i(UniformPointLightCount, NewLightCount);
-
     for (size_t i = 0; i < NewLightCount; i++)
     {
         /*      Expected signature:
-        * 	void UseLight(GLuint AmbientIntensityLocation, 
-        *                   GLuint AmbientColorLocation,
-		*			        GLuint DiffuseIntensityLocation, 
-        *                   GLuint PositionLocation,
-		*			        GLfloat ConstantLocation, 
-        *                   GLfloat LinearLocation, 
-        *                   GLfloat ExponentLocation);
+        * 	void UseLight(Shader* TheShader,
+        *                   UniformHandle AmbientIntensityHandle,
+        *                   UniformHandle AmbientColorHandle,
+        *                   UniformHandle DiffuseIntensityHandle,
+        *                   UniformHandle PositionHandle,
+        *                   UniformHandle ConstantHandle,
+        *                   UniformHandle LinearHandle,
+        *                   UniformHandle ExponentHandle);
         */
-        MyPointLights[i].UseLight(UniformPointLight[i].UniformAmbientIntensity,
-            UniformPointLight[i].UniformColor,
-            UniformPointLight[i].UniformDiffuseIntensity,
-            UniformPointLight[i].UniformPosition,
-            UniformPointLight[i].UniformConstant,
-            UniformPointLight[i].UniformLinear,
-            UniformPointLight[i].UniformExponent);
+        MyPointLights[i].UseLight(this,
+            UniformPointLights[i].UniformAmbientIntensity,
+            UniformPointLights[i].UniformColor,
+            UniformPointLights[i].UniformDiffuseIntensity,
+            UniformPointLights[i].UniformPosition,
+            UniformPointLights[i].UniformConstant,
+            UniformPointLights[i].UniformLinear,
+            UniformPointLights[i].UniformExponent);
 
         MyPointLights[i].GetShadowMap()->Read(GL_TEXTURE0 + TextureUnit + i);
-        glUniform1i(UniformOmniShadowMap[i + Offset].ShadowMapCube, TextureUnit + i);
-        glUniform1f(UniformOmniShadowMap[i + Offset].FarPlane, MyPointLights[i].GetFarPlane());
+        if (i + Offset < UniformOmniShadowMaps.size())
+        {
+            SetUniform(UniformOmniShadowMaps[i + Offset].ShadowMapCube, (GLint)(TextureUnit + i));
+            SetUniform(UniformOmniShadowMaps[i + Offset].FarPlane, MyPointLights[i].GetFarPlane());
+        }
     }
 }
 
-void Shader::SetSpotLights(SpotLight* MySpotLights, unsigned int NewLightCount, unsigned int TextureUnit, unsigned int Offset)
+void Shader::SetSpotLights(SpotLight* MySpotLights, unsigned int NewLightCount, unsigned int TextureUnit, const glm::mat4* ShadowTransforms,
+                           const glm::vec4* ShadowBounds)
 {
-    if (NewLightCount > MAX_SPOT_LIGHTS)
+    if (NewLightCount > UniformSpotLights.size())
     {
-        NewLightCount = MAX_SPOT_LIGHTS;
+        NewLightCount = (unsigned int)UniformSpotLights.size();
     }
 
-    glUniform1i(UniformSpotLightCount, NewLightCount);
-
     for (size_t i = 0; i < NewLightCount; i++)
     {
         /*      Expected signature:
-        * 	void UseLight(GLuint AmbientIntensityLocation, 
-                            GLuint AmbientColorLocation,
-		                    GLuint DiffuseIntensityLocation, 
-                            GLuint PositionLocation, 
-                            GLuint DirectionLocation,
-		                    GLuint ConstantLocation, 
-                            GLuint LinearLocation, 
-                            GLuint ExponentLocation,
-		                    GLuint EdgeLocation);
+        * 	void UseLight(Shader* TheShader,
+                            UniformHandle AmbientIntensityHandle,
+                            UniformHandle AmbientColorHandle,
+                            UniformHandle DiffuseIntensityHandle,
+                            UniformHandle PositionHandle,
+                            UniformHandle DirectionHandle,
+                            UniformHandle ConstantHandle,
+                            UniformHandle LinearHandle,
+                            UniformHandle ExponentHandle,
+                            UniformHandle EdgeHandle);
         */
-        MySpotLights[i].UseLight(UniformSpotLight[i].UniformAmbientIntensity,
-            UniformSpotLight[i].UniformColor,
-            UniformSpotLight[i].UniformDiffuseIntensity,
-            UniformSpotLight[i].UniformPosition,
-            UniformSpotLight[i].UniformDirection,
-            UniformSpotLight[i].UniformConstant,
-            UniformSpotLight[i].UniformLinear,
-            UniformSpotLight[i].UniformExponent,
-            UniformSpotLight[i].UniformEdge);
+        MySpotLights[i].UseLight(this,
+            UniformSpotLights[i].UniformAmbientIntensity,
+            UniformSpotLights[i].UniformColor,
+            UniformSpotLights[i].UniformDiffuseIntensity,
+            UniformSpotLights[i].UniformPosition,
+            UniformSpotLights[i].UniformDirection,
+            UniformSpotLights[i].UniformConstant,
+            UniformSpotLights[i].UniformLinear,
+            UniformSpotLights[i].UniformExponent,
+            UniformSpotLights[i].UniformEdge);
 
         MySpotLights[i].GetShadowMap()->Read(GL_TEXTURE0 + TextureUnit + i);
-        glUniform1i(UniformOmniShadowMap[i + Offset].ShadowMapCube, TextureUnit + i);
-        glUniform1f(UniformOmniShadowMap[i + Offset].FarPlane, MySpotLights[i].GetFarPlane());
+        if (i < UniformSpotShadowMaps.size())
+        {
+            SetUniform(UniformSpotShadowMaps[i].ShadowMap, (GLint)(TextureUnit + i));
+            SetUniform(UniformSpotShadowMaps[i].LightTransform, ShadowTransforms[i]);
+            SetUniform(UniformSpotShadowMaps[i].FarPlane, MySpotLights[i].GetFarPlane());
+            SetUniform(UniformSpotShadowMaps[i].TileBounds, ShadowBounds[i]);
+        }
     }
 }
 
 void Shader::SetTexture(GLuint TextureUnit)
 {
-    glUniform1i(UniformTexture, TextureUnit);
+    SetUniform(UniformTexture, (GLint)TextureUnit);
 }
 
 void Shader::SetDirectionalShadowMap(GLuint TextureUnit)
 {
-    glUniform1i(UniformDirectionalShadowMap, TextureUnit);
+    SetUniform(UniformDirectionalShadowMap, (GLint)TextureUnit);
 }
 
 void Shader::SetDirectionalLightTransform(glm::mat4* LightTransform)
 {
-    glUniformMatrix4fv(UniformDirectionalLightTransform, 1, GL_FALSE, glm::value_ptr(*LightTransform));
+    SetUniform(UniformDirectionalLightTransform, *LightTransform);
 }
 
-void Shader::SetOmniLightMatrices(std::vector<glm::mat4> InLightMatrices)
+void Shader::SetOmniLightMatrices(const glm::mat4* InLightMatrices, size_t MatrixCount)
 {
-    for (size_t i = 0; i < 6; i++)
+    for (size_t i = 0; i < UniformLightMatrices.size() && i < MatrixCount; i++)
     {
-        glUniformMatrix4fv(UniformLightMatrices[i], 1, GL_FALSE, glm::value_ptr(InLightMatrices[i]));
+        SetUniform(UniformLightMatrices[i], InLightMatrices[i]);
     }
 }
 
+void Shader::SetProjection(const glm::mat4& Projection)
+{
+    SetUniform(UniformProjection, Projection);
+}
+
+void Shader::SetView(const glm::mat4& View)
+{
+    SetUniform(UniformView, View);
+}
+
+void Shader::SetEyePosition(const glm::vec3& EyePosition)
+{
+    SetUniform(UniformEyePosition, EyePosition);
+}
+
+void Shader::SetOmniLight(const glm::vec3& Position, GLfloat FarPlane)
+{
+    SetUniform(UniformOmniLightPosition, Position);
+    SetUniform(UniformFarPlane, FarPlane);
+}
+
+UniformHandle Shader::FindUniform(const char* Name) const
+{
+    return Reflection.FindUniform(Name);
+}
+
+void Shader::SetUniform(UniformHandle Handle, GLint Value)
+{
+    if (Handle != INVALID_UNIFORM && Reflection.StoreValue(Handle, &Value, sizeof(Value)))
+    {
+        glUniform1i(Reflection.GetLocation(Handle), Value);
+    }
+}
+
+void Shader::SetUniform(UniformHandle Handle, GLfloat Value)
+{
+    if (Handle != INVALID_UNIFORM && Reflection.StoreValue(Handle, &Value, sizeof(Value)))
+    {
+        glUniform1f(Reflection.GetLocation(Handle), Value);
+    }
+}
+
+void Shader::SetUniform(UniformHandle Handle, const glm::vec2& Value)
+{
+    if (Handle != INVALID_UNIFORM && Reflection.StoreValue(Handle, glm::value_ptr(Value), sizeof(Value)))
+    {
+        glUniform2fv(Reflection.GetLocation(Handle), 1, glm::value_ptr(Value));
+    }
+}
+
+void Shader::SetUniform(UniformHandle Handle, const glm::vec3& Value)
+{
+    if (Handle != INVALID_UNIFORM && Reflection.StoreValue(Handle, glm::value_ptr(Value), sizeof(Value)))
+    {
+        glUniform3fv(Reflection.GetLocation(Handle), 1, glm::value_ptr(Value));
+    }
+}
+
+void Shader::SetUniform(UniformHandle Handle, const glm::vec4& Value)
+{
+    if (Handle != INVALID_UNIFORM && Reflection.StoreValue(Handle, glm::value_ptr(Value), sizeof(Value)))
+    {
+        glUniform4fv(Reflection.GetLocation(Handle), 1, glm::value_ptr(Value));
+    }
+}
+
+void Shader::SetUniform(UniformHandle Handle, const glm::mat4& Value)
+{
+    if (Handle != INVALID_UNIFORM && Reflection.StoreValue(Handle, glm::value_ptr(Value), sizeof(Value)))
+    {
+        glUniformMatrix4fv(Reflection.GetLocation(Handle), 1, GL_FALSE, glm::value_ptr(Value));
+    }
+}
+
+void Shader::AddShaderAsync(GLuint TheProgram, const char* ShaderCode, GLenum ShaderType)
+{
+    GLuint TheShader = glCreateShader(ShaderType);
+
+    const GLchar* TheCode[1] = { ShaderCode };
+    GLint CodeLength[1] = { (GLint)strlen(ShaderCode) };
+    glShaderSource(TheShader, 1, TheCode, CodeLength);
+    glCompileShader(TheShader);
+
+    // Compile errors surface through the program's link log in UpdatePending
+    glAttachShader(TheProgram, TheShader);
+
+    // Only flagged for deletion, it lives until the program is deleted
+    glDeleteShader(TheShader);
+}
+
 void Shader::AddShader(GLuint TheProgram, const char* ShaderCode, GLenum ShaderType)
 {
     // Create a new shader of the specified type
@@ -379,7 +724,14 @@ void Shader::AddShader(GLuint TheProgram, const char* ShaderCode, GLenum ShaderT
     glAttachShader(TheProgram, TheShader);
 }
 
-void Shader::CompileProgram()
+UniformHandle Shader::FindMember(const char* ArrayName, size_t Index, const char* MemberName)
+{
+    char LocationBuffer[100] = { '\0' };
+    snprintf(LocationBuffer, sizeof(LocationBuffer), "%s[%zu].%s", ArrayName, Index, MemberName);
+    return Reflection.FindUniform(LocationBuffer);
+}
+
+bool Shader::CompileProgram()
 {
     // Logging errors for the shader
     GLint Result = 0;
@@ -392,138 +744,108 @@ void Shader::CompileProgram()
     {
         glGetProgramInfoLog(ShaderID, sizeof(ErrorLog), NULL, ErrorLog);
         printf("Error linking the Shader Program: '%s'\n", ErrorLog);
-        return;
+        return false;
     }
     else
     {
         printf("Linking Successful!\n");
     }
 
-    // Bind uniform variables to the location of the model in the shader code
-    // Note the struct member variable access for the light variables
-    UniformModel = glGetUniformLocation(ShaderID, "Model");
-    UniformView = glGetUniformLocation(ShaderID, "View");
-    UniformProjection = glGetUniformLocation(ShaderID, "Projection");
-
-    // Bind uniforms for Material Uses
-    UniformEyePosition = glGetUniformLocation(ShaderID, "EyePosition");
-    UniformSpecularIntensity = glGetUniformLocation(ShaderID, "MyMaterial.SpecularIntensity");
-    UniformShininess = glGetUniformLocation(ShaderID, "MyMaterial.Shininess");
-    UniformTexture = glGetUniformLocation(ShaderID, "MyTexture");
-
-    // Bind Uniforms for Directional Shadow Map
-    UniformDirectionalLightTransform = glGetUniformLocation(ShaderID, "DirectionalLightTransform");
-    UniformDirectionalShadowMap = glGetUniformLocation(ShaderID, "DirectionalShadowMap");
-
-    // Bind uniforms for Directional Light
-    UniformDirectionalLight.UniformAmbientIntensity = glGetUniformLocation(ShaderID, "MyDirectionalLight.Base.AmbientIntensity");
-    UniformDirectionalLight.UniformColor = glGetUniformLocation(ShaderID, "MyDirectionalLight.Base.Color");
-    UniformDirectionalLight.UniformDiffuseIntensity = glGetUniformLocation(ShaderID, "MyDirectionalLight.Base.DiffuseIntensity");
-    UniformDirectionalLight.UniformDirection = glGetUniformLocation(ShaderID, "MyDirectionalLight.Direction");
-
-    // Bind uniforms for Point Lights
-    UniformPointLightCount = glGetUniformLocation(ShaderID, "PointLightCount");
+    ResolveUniforms();
+    return true;
+}
 
-    //Binds uniforms for Omnidirectional Shadow CubeMap
-    UniformOmniLightPosition = glGetUniformLocation(ShaderID, "LightPosition");
-    UniformFarPlane = glGetUniformLocation(ShaderID, "FarPlane");
-    for (size_t i = 0; i < 6; i++)
-    {
-        char LocationBuffer[100] = { '\0' };
+void Shader::ResolveUniforms()
+{
+    // Enumerate what the linked program actually uses, every lookup below is a hash table probe
+    Reflection.Reflect(ShaderID);
+    ProgramGeneration = NextProgramGeneration++;
 
-        // Bind light matrix for cube map face
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "LightMatrices[%d]", i);
-        UniformLightMatrices[i] = glGetUniformLocation(ShaderID, LocationBuffer);
-    }
+    printf("Reflected %zu uniforms (%zu samplers), %zu uniform blocks, %zu attributes\n",
+           Reflection.GetUniformCount(), Reflection.GetSamplerCount(), Reflection.GetBlockCount(), Reflection.GetAttributeCount());
 
-    for (size_t i = 0; i < MAX_POINT_LIGHTS + MAX_SPOT_LIGHTS; i++)
+    // Shared blocks sit at fixed binding points, so one buffer bind serves every program
+    const ReflectedBlock* CameraBlock = Reflection.FindBlock("CameraBlock");
+    if (CameraBlock)
     {
-        char LocationBuffer[100] = { '\0' };
-
-        // Bind Shadow map to OmniShadowMap struct in shader
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "OmniShadowMaps[%d].ShadowMapCube", i);
-        UniformOmniShadowMap[i].ShadowMapCube = glGetUniformLocation(ShaderID, LocationBuffer);
-
-        // Bind Far Plane to OmniShadowMap struct in shader
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "OmniShadowMaps[%d].FarPlane", i);
-        UniformOmniShadowMap[i].FarPlane = glGetUniformLocation(ShaderID, LocationBuffer);
+        glUniformBlockBinding(ShaderID, CameraBlock->Index, CAMERA_BLOCK_BINDING);
     }
 
-    for (size_t i = 0; i < MAX_POINT_LIGHTS; i++)
-    {
-        char LocationBuffer[100] = { '\0' };
-
-        // Bind point light Color Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MyPointLights[%d].Base.Color", i);
-        UniformPointLight[i].UniformColor = glGetUniformLocation(ShaderID, LocationBuffer);
-
-        // Bind point light Ambient Intensity Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MyPointLights[%d].Base.AmbientIntensity", i);
-        UniformPointLight[i].UniformAmbientIntensity = glGetUniformLocation(ShaderID, LocationBuffer);
+    UniformModel = Reflection.FindUniform("Model");
+    UniformView = Reflection.FindUniform("View");
+    UniformProjection = Reflection.FindUniform("Projection");
 
-        // Bind point light Diffuse Intensity Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MyPointLights[%d].Base.DiffuseIntensity", i);
-        UniformPointLight[i].UniformDiffuseIntensity = glGetUniformLocation(ShaderID, LocationBuffer);
+    // Material Uses
+    UniformEyePosition = Reflection.FindUniform("EyePosition");
+    UniformSpecularIntensity = Reflection.FindUniform("MyMaterial.SpecularIntensity");
+    UniformShininess = Reflection.FindUniform("MyMaterial.Shininess");
+    UniformTexture = Reflection.FindUniform("MyTexture");
 
-        // Bind point light Position Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MyPointLights[%d].Position", i);
-        UniformPointLight[i].UniformPosition = glGetUniformLocation(ShaderID, LocationBuffer);
+    // Directional Shadow Map
+    UniformDirectionalLightTransform = Reflection.FindUniform("DirectionalLightTransform");
+    UniformDirectionalShadowMap = Reflection.FindUniform("DirectionalShadowMap");
 
-        // Bind point light Constant Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MyPointLights[%d].Constant", i);
-        UniformPointLight[i].UniformConstant = glGetUniformLocation(ShaderID, LocationBuffer);
-
-        // Bind point light Linear Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MyPointLights[%d].Linear", i);
-        UniformPointLight[i].UniformLinear = glGetUniformLocation(ShaderID, LocationBuffer);
-
-        // Bind point light Exponent Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MyPointLights[%d].Exponent", i);
-        UniformPointLight[i].UniformExponent = glGetUniformLocation(ShaderID, LocationBuffer);
-    }
+    // Directional Light
+    UniformDirectionalLight.UniformAmbientIntensity = Reflection.FindUniform("MyDirectionalLight.Base.AmbientIntensity");
+    UniformDirectionalLight.UniformColor = Reflection.FindUniform("MyDirectionalLight.Base.Color");
+    UniformDirectionalLight.UniformDiffuseIntensity = Reflection.FindUniform("MyDirectionalLight.Base.DiffuseIntensity");
+    UniformDirectionalLight.UniformDirection = Reflection.FindUniform("MyDirectionalLight.Direction");
 
-    // Bind uniforms for Spot Lights
-    UniformSpotLightCount = glGetUniformLocation(ShaderID, "SpotLightCount");
+    // Omnidirectional Shadow CubeMap
+    UniformOmniLightPosition = Reflection.FindUniform("LightPosition");
+    UniformFarPlane = Reflection.FindUniform("FarPlane");
 
-    for (size_t i = 0; i < MAX_SPOT_LIGHTS; i++)
+    UniformLightMatrices.resize(Reflection.CountArrayElements("LightMatrices"));
+    for (size_t i = 0; i < UniformLightMatrices.size(); i++)
     {
         char LocationBuffer[100] = { '\0' };
+        snprintf(LocationBuffer, sizeof(LocationBuffer), "LightMatrices[%zu]", i);
+        UniformLightMatrices[i] = Reflection.FindUniform(LocationBuffer);
+    }
 
-        // Bind spot light Color Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MySpotLights[%d].Base.Base.Color", i);
-        UniformSpotLight[i].UniformColor = glGetUniformLocation(ShaderID, LocationBuffer);
-
-        // Bind spot light Ambient Intensity Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MySpotLights[%d].Base.Base.AmbientIntensity", i);
-        UniformSpotLight[i].UniformAmbientIntensity = glGetUniformLocation(ShaderID, LocationBuffer);
-
-        // Bind spot light Diffuse Intensity Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MySpotLights[%d].Base.Base.DiffuseIntensity", i);
-        UniformSpotLight[i].UniformDiffuseIntensity = glGetUniformLocation(ShaderID, LocationBuffer);
-
-        // Bind spot light Position Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MySpotLights[%d].Base.Position", i);
-        UniformSpotLight[i].UniformPosition = glGetUniformLocation(ShaderID, LocationBuffer);
-
-        // Bind spot light Constant Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MySpotLights[%d].Base.Constant", i);
-        UniformSpotLight[i].UniformConstant = glGetUniformLocation(ShaderID, LocationBuffer);
-
-        // Bind spot light Linear Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MySpotLights[%d].Base.Linear", i);
-        UniformSpotLight[i].UniformLinear = glGetUniformLocation(ShaderID, LocationBuffer);
+    // Array lengths come from the program, so each permutation gets exactly as many entries as it declares
+    UniformOmniShadowMaps.resize(Reflection.CountArrayElements("OmniShadowMaps"));
+    for (size_t i = 0; i < UniformOmniShadowMaps.size(); i++)
+    {
+        UniformOmniShadowMaps[i].ShadowMapCube = FindMember("OmniShadowMaps", i, "ShadowMapCube");
+        UniformOmniShadowMaps[i].FarPlane = FindMember("OmniShadowMaps", i, "FarPlane");
+    }
 
-        // Bind spot light Exponent Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MySpotLights[%d].Base.Exponent", i);
-        UniformSpotLight[i].UniformExponent = glGetUniformLocation(ShaderID, LocationBuffer);
+    UniformSpotShadowMaps.resize(Reflection.CountArrayElements("SpotShadowMaps"));
+    for (size_t i = 0; i < UniformSpotShadowMaps.size(); i++)
+    {
+        UniformSpotShadowMaps[i].ShadowMap = FindMember("SpotShadowMaps", i, "ShadowMap");
+        UniformSpotShadowMaps[i].LightTransform = FindMember("SpotShadowMaps", i, "LightTransform");
+        UniformSpotShadowMaps[i].FarPlane = FindMember("SpotShadowMaps", i, "FarPlane");
+        UniformSpotShadowMaps[i].TileBounds = FindMember("SpotShadowMaps", i, "TileBounds");
+    }
 
-        // Bind spot light Direction Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MySpotLights[%d].Direction", i);
-        UniformSpotLight[i].UniformDirection = glGetUniformLocation(ShaderID, LocationBuffer);
+    // Point Lights
+    UniformPointLights.resize(Reflection.CountArrayElements("MyPointLights"));
+    for (size_t i = 0; i < UniformPointLights.size(); i++)
+    {
+        UniformPointLights[i].UniformColor = FindMember("MyPointLights", i, "Base.Color");
+        UniformPointLights[i].UniformAmbientIntensity = FindMember("MyPointLights", i, "Base.AmbientIntensity");
+        UniformPointLights[i].UniformDiffuseIntensity = FindMember("MyPointLights", i, "Base.DiffuseIntensity");
+        UniformPointLights[i].UniformPosition = FindMember("MyPointLights", i, "Position");
+        UniformPointLights[i].UniformConstant = FindMember("MyPointLights", i, "Constant");
+        UniformPointLights[i].UniformLinear = FindMember("MyPointLights", i, "Linear");
+        UniformPointLights[i].UniformExponent = FindMember("MyPointLights", i, "Exponent");
+    }
 
-        // Bind spot light Edge Uniform
-        snprintf(LocationBuffer, sizeof(LocationBuffer), "MySpotLights[%d].Edge", i);
-        UniformSpotLight[i].UniformEdge = glGetUniformLocation(ShaderID, LocationBuffer);
+    // Spot Lights
+    UniformSpotLights.resize(Reflection.CountArrayElements("MySpotLights"));
+    for (size_t i = 0; i < UniformSpotLights.size(); i++)
+    {
+        UniformSpotLights[i].UniformColor = FindMember("MySpotLights", i, "Base.Base.Color");
+        UniformSpotLights[i].UniformAmbientIntensity = FindMember("MySpotLights", i, "Base.Base.AmbientIntensity");
+        UniformSpotLights[i].UniformDiffuseIntensity = FindMember("MySpotLights", i, "Base.Base.DiffuseIntensity");
+        UniformSpotLights[i].UniformPosition = FindMember("MySpotLights", i, "Base.Position");
+        UniformSpotLights[i].UniformConstant = FindMember("MySpotLights", i, "Base.Constant");
+        UniformSpotLights[i].UniformLinear = FindMember("MySpotLights", i, "Base.Linear");
+        UniformSpotLights[i].UniformExponent = FindMember("MySpotLights", i, "Base.Exponent");
+        UniformSpotLights[i].UniformDirection = FindMember("MySpotLights", i, "Direction");
+        UniformSpotLights[i].UniformEdge = FindMember("MySpotLights", i, "Edge");
     }
 }
 
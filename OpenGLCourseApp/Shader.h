@@ -1,9 +1,12 @@
 #pragma once
 
 #include <stdio.h>
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GLM/glm.hpp>
@@ -13,6 +16,8 @@
 #include "DirectionalLight.h"
 #include "PointLight.h"
 #include "SpotLight.h"
+#include "ShaderCache.h"
+#include "ShaderReflection.h"
 
 
 class Shader
@@ -20,10 +25,33 @@ class Shader
 public:
 	Shader();
 
+	// Owns the program, share it through a pointer instead of copying
+	Shader(const Shader&) = delete;
+	Shader& operator=(const Shader&) = delete;
+
 	void CreateFromString(const char* VertexCode, const char* FragmentCode);
 	void CreateFromFiles(const char* VertexPath, const char* FragmentPath);
 	void CreateFromFiles(const char* VertexPath, const char* FragmentPath, const char* GeometrytPath);
+	// Like CreateFromFiles, but a program missing from the ShaderCache links through the hot reload path below
+	// instead of stalling the caller. GeometryPath may be empty. Not usable until IsReady().
+	void CreateFromFilesAsync(const char* VertexPath, const char* FragmentPath, const char* GeometryPath);
+	bool IsReady() const { return ShaderID != 0; }
 	void ValidateShader();
+
+	// Text injected right after the #version line of every stage (e.g. "#define POINT_LIGHT_COUNT 2\n"),
+	// set before CreateFromFiles. #include "file" lines are expanded relative to the including file.
+	void SetDefines(const std::string& NewDefines);
+
+	// Lets the driver compile on its own threads (GL_KHR_parallel_shader_compile), call once after GLEW is initialized
+	static void EnableParallelCompile();
+
+	// Hot reload: Reload() starts a non-blocking rebuild from the files given to CreateFromFiles,
+	// UpdatePending() is polled once per frame & swaps the new program in once it has linked.
+	// The current program stays in use until then, or for good if the new one fails to link.
+	bool UsesFile(const std::string& FilePath);
+	void Reload();
+	bool UpdatePending();
+
 	std::string ReadFile(const char* FilePath);
 	GLuint GetProjectionLocation();
 	GLuint GetViewLocation();
@@ -37,96 +65,149 @@ public:
 	GLuint GetShininessLocation();
 	GLuint GetOmniLightPositionLocation();
 	GLuint GetFarPlaneLocation();
+	GLuint GetShaderID() { return ShaderID; }
+	const ShaderReflection& GetReflection() const { return Reflection; }
+
+	// Typed setters for reflected uniforms, a value equal to the last one set is skipped
+	// The program must be in use. Uploads made elsewhere (e.g. a CommandBuffer) aren't tracked.
+	UniformHandle FindUniform(const char* Name) const;
+
+	// Unique to each linked program, handles from FindUniform need looking up again once it changes (e.g. a hot reload)
+	unsigned int GetProgramGeneration() const { return ProgramGeneration; }
+	void SetUniform(UniformHandle Handle, GLint Value);
+	void SetUniform(UniformHandle Handle, GLfloat Value);
+	void SetUniform(UniformHandle Handle, const glm::vec2& Value);
+	void SetUniform(UniformHandle Handle, const glm::vec3& Value);
+	void SetUniform(UniformHandle Handle, const glm::vec4& Value);
+	void SetUniform(UniformHandle Handle, const glm::mat4& Value);
 
 	void UseShader();
 	void ClearShader();
 	void SetDirectionalLight(DirectionalLight* MyDirectionalLight);
 	void SetPointLights(PointLight* MyPointLights, unsigned int NewLightCount, unsigned int TextureUnit, unsigned int Offset);
-	void SetSpotLights(SpotLight* MySpotLights, unsigned int NewLightCount, unsigned int TextureUnit, unsigned int Offset);
+	// ShadowTransforms holds one view-projection per spot light, the one its shadow map was drawn with
+	void SetSpotLights(SpotLight* MySpotLights, unsigned int NewLightCount, unsigned int TextureUnit, const glm::mat4* ShadowTransforms,
+					   const glm::vec4* ShadowBounds);
 	void SetTexture(GLuint TextureUnit);
 	void SetDirectionalShadowMap(GLuint TextureUnit);
 	void SetDirectionalLightTransform(glm::mat4* LightTransform);
-	void SetOmniLightMatrices(std::vector<glm::mat4> InLightMatrices);
+	void SetOmniLightMatrices(const glm::mat4* InLightMatrices, size_t MatrixCount);
+	void SetProjection(const glm::mat4& Projection);
+	void SetView(const glm::mat4& View);
+	void SetEyePosition(const glm::vec3& EyePosition);
+	void SetOmniLight(const glm::vec3& Position, GLfloat FarPlane);
 
 	~Shader();
 
 private:
-	// Lights
-	int PointLightCount;
-	int SpotLightCount;
-
 	// Lighting Values - Directional
 	struct
 	{
-		GLuint UniformColor;
-		GLuint UniformAmbientIntensity;
-		GLuint UniformDiffuseIntensity;
+		UniformHandle UniformColor;
+		UniformHandle UniformAmbientIntensity;
+		UniformHandle UniformDiffuseIntensity;
 
-		GLuint UniformDirection;
+		UniformHandle UniformDirection;
 	} UniformDirectionalLight;
 
-	GLuint UniformPointLightCount;
-
 	// Lighting Values - Point
-	struct
+	struct PointLightUniforms
 	{
-		GLuint UniformColor;
-		GLuint UniformAmbientIntensity;
-		GLuint UniformDiffuseIntensity;
-
-		GLuint UniformPosition;
-		GLuint UniformConstant;
-		GLuint UniformLinear;
-		GLuint UniformExponent;
-	} UniformPointLight[MAX_POINT_LIGHTS];
+		UniformHandle UniformColor;
+		UniformHandle UniformAmbientIntensity;
+		UniformHandle UniformDiffuseIntensity;
 
-	GLuint UniformSpotLightCount;
+		UniformHandle UniformPosition;
+		UniformHandle UniformConstant;
+		UniformHandle UniformLinear;
+		UniformHandle UniformExponent;
+	};
 
 	// Lighting Values - Spot
-	struct
+	struct SpotLightUniforms
 	{
-		GLuint UniformColor;
-		GLuint UniformAmbientIntensity;
-		GLuint UniformDiffuseIntensity;
+		UniformHandle UniformColor;
+		UniformHandle UniformAmbientIntensity;
+		UniformHandle UniformDiffuseIntensity;
 
-		GLuint UniformPosition;
-		GLuint UniformConstant;
-		GLuint UniformLinear;
-		GLuint UniformExponent;
+		UniformHandle UniformPosition;
+		UniformHandle UniformConstant;
+		UniformHandle UniformLinear;
+		UniformHandle UniformExponent;
 
-		GLuint UniformDirection;
-		GLuint UniformEdge;
-	} UniformSpotLight[MAX_SPOT_LIGHTS];
+		UniformHandle UniformDirection;
+		UniformHandle UniformEdge;
+	};
+
+	// Omni Shadow Map
+	struct OmniShadowMapUniforms
+	{
+		UniformHandle ShadowMapCube;
+		UniformHandle FarPlane;
+	};
+
+	// Spot Shadow Map
+	struct SpotShadowMapUniforms
+	{
+		UniformHandle ShadowMap;
+		UniformHandle LightTransform;
+		UniformHandle FarPlane;
+		UniformHandle TileBounds;
+	};
+
+	// One entry per light the linked program declares, however many that permutation has
+	std::vector<PointLightUniforms> UniformPointLights;
+	std::vector<SpotLightUniforms> UniformSpotLights;
+	std::vector<OmniShadowMapUniforms> UniformOmniShadowMaps;
+	std::vector<SpotShadowMapUniforms> UniformSpotShadowMaps;
 
 	// World Values
 	GLuint ShaderID;
-	GLuint UniformProjection;
-	GLuint UniformView;
-	GLuint UniformModel;
-	GLuint UniformEyePosition;
+	UniformHandle UniformProjection;
+	UniformHandle UniformView;
+	UniformHandle UniformModel;
+	UniformHandle UniformEyePosition;
 
 	// Material Values
-	GLuint UniformSpecularIntensity;
-	GLuint UniformShininess;
-	GLuint UniformTexture;
+	UniformHandle UniformSpecularIntensity;
+	UniformHandle UniformShininess;
+	UniformHandle UniformTexture;
 
 	// Shadow Map Values
-	GLuint UniformDirectionalLightTransform;
-	GLuint UniformDirectionalShadowMap;
-	GLuint UniformOmniLightPosition;
-	GLuint UniformFarPlane;
-	GLuint UniformLightMatrices[6];
+	UniformHandle UniformDirectionalLightTransform;
+	UniformHandle UniformDirectionalShadowMap;
+	UniformHandle UniformOmniLightPosition;
+	UniformHandle UniformFarPlane;
+	std::vector<UniformHandle> UniformLightMatrices;
 
-	// Omni Shadow Map
-	struct
-	{
-		GLuint ShadowMapCube;
-		GLuint FarPlane;
-	} UniformOmniShadowMap[MAX_POINT_LIGHTS + MAX_SPOT_LIGHTS];
+	ShaderReflection Reflection;
 
 	void CompileShader(const char* VertexCode, const char* FragmentCode);
 	void CompileShader(const char* VertexCode, const char* FragmentCode, const char* GeometryCode);
 	void AddShader(GLuint TheProgram, const char* ShaderCode, GLenum ShaderType);
-	void CompileProgram();
+	void AddShaderAsync(GLuint TheProgram, const char* ShaderCode, GLenum ShaderType);
+	bool CompileProgram();
+	std::string PreprocessFile(const std::string& FilePath, unsigned int Depth);
+	void StartPendingLink(const std::string& VertexString, const std::string& FragmentString, const char* GeometryCode);
+	void ResolveUniforms();
+	UniformHandle FindMember(const char* ArrayName, size_t Index, const char* MemberName);
+
+	// Preprocessing
+	static const unsigned int MaxIncludeDepth = 8;
+	std::string Defines;
+
+	// Hot reload state
+	static const unsigned int DeferredStatusFrames = 3;
+	std::string SourceVertexPath;
+	std::string SourceFragmentPath;
+	std::string SourceGeometryPath;
+	std::vector<std::string> IncludedFiles;
+	GLuint PendingID;
+	unsigned long long PendingCacheKey;
+	unsigned int PendingFrames;
+
+	// Counts links across every shader, so no two programs share a generation
+	unsigned int ProgramGeneration;
+	static unsigned int NextProgramGeneration;
 };
 
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <string.h>
+#include <filesystem>
+
+#include "ShaderCache.h"
+
+static const char* CacheDirectory = "ShaderCache";
+static const unsigned int CacheMagic = 0x42504C47;		// "GLPB"
+static const unsigned int CacheVersion = 2;
+
+// 64-bit FNV-1a, stable across runs & compilers unlike std::hash
+static unsigned long long HashBytes(unsigned long long Hash, const void* Data, size_t Length)
+{
+	const unsigned char* Bytes = static_cast<const unsigned char*>(Data);
+	for (size_t i = 0; i < Length; i++)
+	{
+		Hash ^= Bytes[i];
+		Hash *= 1099511628211ULL;
+	}
+	return Hash;
+}
+
+static unsigned long long HashString(unsigned long long Hash, const char* Text)
+{
+	// Hash the terminator too, so "ab" + "c" differs from "a" + "bc"
+	if (!Text)
+	{
+		Text = "";
+	}
+	return HashBytes(Hash, Text, strlen(Text) + 1);
+}
+
+bool ShaderCache::IsSupported()
+{
+	if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+	{
+		return false;
+	}
+
+	// Some drivers expose the entry points but no binary formats at all
+	GLint FormatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &FormatCount);
+	return FormatCount > 0;
+}
+
+unsigned long long ShaderCache::CalculateKey(const std::vector<const char*>& Sources)
+{
+	unsigned long long Hash = 14695981039346656037ULL;
+
+	for (size_t i = 0; i < Sources.size(); i++)
+	{
+		Hash = HashString(Hash, Sources[i]);
+	}
+
+	// Binaries are only valid for the driver that produced them
+	Hash = HashString(Hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+	Hash = HashString(Hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	Hash = HashString(Hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+
+	return Hash;
+}
+
+std::string ShaderCache::GetEntryPath(unsigned long long Key)
+{
+	char FileName[64] = { '\0' };
+	snprintf(FileName, sizeof(FileName), "/%016llx.bin", Key);
+	return std::string(CacheDirectory) + FileName;
+}
+
+bool ShaderCache::LoadProgram(unsigned long long Key, GLuint Program)
+{
+	if (!IsSupported())
+	{
+		return false;
+	}
+
+	FILE* Entry = fopen(GetEntryPath(Key).c_str(), "rb");
+	if (!Entry)
+	{
+		return false;
+	}
+
+	unsigned int Header[4] = { 0 };			// Magic, Version, Format, BinaryLength
+	unsigned long long StoredKey = 0;
+	bool bValid = fread(Header, sizeof(Header), 1, Entry) == 1 &&
+				  fread(&StoredKey, sizeof(StoredKey), 1, Entry) == 1 &&
+				  Header[0] == CacheMagic && Header[1] == CacheVersion && StoredKey == Key;
+
+	std::vector<unsigned char> Binary;
+	if (bValid)
+	{
+		Binary.resize(Header[3]);
+		bValid = Header[3] > 0 && fread(Binary.data(), Binary.size(), 1, Entry) == 1;
+	}
+
+	fclose(Entry);
+
+	if (!bValid)
+	{
+		return false;
+	}
+
+	// The driver may still refuse the blob (e.g. after an update with the same version string)
+	glProgramBinary(Program, Header[2], Binary.data(), (GLsizei)Binary.size());
+
+	GLint Result = 0;
+	glGetProgramiv(Program, GL_LINK_STATUS, &Result);
+	return Result == GL_TRUE;
+}
+
+void ShaderCache::SaveProgram(unsigned long long Key, GLuint Program)
+{
+	if (!IsSupported())
+	{
+		return;
+	}
+
+	GLint BinaryLength = 0;
+	glGetProgramiv(Program, GL_PROGRAM_BINARY_LENGTH, &BinaryLength);
+	if (BinaryLength <= 0)
+	{
+		return;
+	}
+
+	std::vector<unsigned char> Binary(BinaryLength);
+	GLenum Format = 0;
+	glGetProgramBinary(Program, BinaryLength, nullptr, &Format, Binary.data());
+
+	std::error_code Error;
+	std::filesystem::create_directories(CacheDirectory, Error);
+
+	FILE* Entry = fopen(GetEntryPath(Key).c_str(), "wb");
+	if (!Entry)
+	{
+		printf("Failed to write shader cache entry %016llx\n", Key);
+		return;
+	}
+
+	unsigned int Header[4] = { CacheMagic, CacheVersion, Format, (unsigned int)BinaryLength };
+	fwrite(Header, sizeof(Header), 1, Entry);
+	fwrite(&Key, sizeof(Key), 1, Entry);
+	fwrite(Binary.data(), Binary.size(), 1, Entry);
+
+	fclose(Entry);
+}
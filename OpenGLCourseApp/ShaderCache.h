@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// On-disk cache of linked program binaries
+// Entries are keyed by a hash of the GLSL sources plus the driver's vendor, renderer & version strings,
+// so a driver update or a shader edit simply misses. Uniforms are reflected from the loaded program like a fresh link.
+class ShaderCache
+{
+public:
+	static bool IsSupported();
+
+	// Sources may contain nullptr for unused stages
+	static unsigned long long CalculateKey(const std::vector<const char*>& Sources);
+
+	// Returns false if there is no entry, or the driver rejects the binary (Program is left unlinked)
+	static bool LoadProgram(unsigned long long Key, GLuint Program);
+	static void SaveProgram(unsigned long long Key, GLuint Program);
+
+private:
+	static std::string GetEntryPath(unsigned long long Key);
+};
@@ -0,0 +1,126 @@
+#include <stdio.h>
+
+#include "ShaderPermutations.h"
+#include "Log.h"
+
+ShaderPermutations::ShaderPermutations()
+{
+	Assets = nullptr;
+	ReadyShader = nullptr;
+	ReadyKey = {};
+}
+
+void ShaderPermutations::Initialize(const char* NewVertexPath, const char* NewFragmentPath, AssetManager* NewAssets)
+{
+	ClearPermutations();
+	VertexPath = NewVertexPath;
+	FragmentPath = NewFragmentPath;
+	Assets = NewAssets;
+}
+
+Shader* ShaderPermutations::GetShader(const ShaderPermutationKey& InKey, ShaderPermutationKey* OutKey)
+{
+	ShaderPermutationKey Key = ClampKey(InKey);
+	unsigned int PackedKey = PackKey(Key);
+
+	Shader* Permutation = nullptr;
+	std::unordered_map<unsigned int, std::shared_ptr<Shader>>::iterator Found = Permutations.find(PackedKey);
+	if (Found != Permutations.end())
+	{
+		Permutation = Found->second.get();
+	}
+	else if (ReadyShader)
+	{
+		LOG_INFO("Compiling shader permutation %08x for %s", PackedKey, FragmentPath.c_str());
+		Permutations[PackedKey] = Assets->LoadShaderAsync(VertexPath, FragmentPath, "", BuildDefines(Key));
+		Permutation = Permutations[PackedKey].get();
+	}
+	else
+	{
+		// Nothing to fall back on yet (e.g. startup), this one has to be built right away
+		LOG_INFO("Compiling shader permutation %08x for %s", PackedKey, FragmentPath.c_str());
+		Permutations[PackedKey] = Assets->LoadShader(VertexPath, FragmentPath, "", BuildDefines(Key));
+		Permutation = Permutations[PackedKey].get();
+	}
+
+	// Still linking, or its link failed: keep drawing with the last one that worked
+	if (Permutation->IsReady() || !ReadyShader)
+	{
+		ReadyShader = Permutation;
+		ReadyKey = Key;
+	}
+
+	*OutKey = ReadyKey;
+	return ReadyShader;
+}
+
+void ShaderPermutations::Prewarm(const ShaderPermutationKey* Keys, size_t KeyCount)
+{
+	for (size_t i = 0; i < KeyCount; i++)
+	{
+		ShaderPermutationKey Key = ClampKey(Keys[i]);
+		unsigned int PackedKey = PackKey(Key);
+		if (Permutations.find(PackedKey) == Permutations.end())
+		{
+			Permutations[PackedKey] = Assets->LoadShaderAsync(VertexPath, FragmentPath, "", BuildDefines(Key));
+		}
+	}
+}
+
+void ShaderPermutations::GetShaders(std::vector<Shader*>* OutShaders)
+{
+	for (std::unordered_map<unsigned int, std::shared_ptr<Shader>>::iterator It = Permutations.begin(); It != Permutations.end(); ++It)
+	{
+		OutShaders->push_back(It->second.get());
+	}
+}
+
+void ShaderPermutations::ClearPermutations()
+{
+	// The asset cache keeps the programs until it evicts them
+	Permutations.clear();
+	ReadyShader = nullptr;
+}
+
+ShaderPermutationKey ShaderPermutations::ClampKey(const ShaderPermutationKey& Key)
+{
+	// The shader only unrolls up to the MAX_ counts
+	ShaderPermutationKey Clamped = Key;
+	Clamped.PointLightCount = Clamped.PointLightCount < MAX_POINT_LIGHTS ? Clamped.PointLightCount : MAX_POINT_LIGHTS;
+	Clamped.SpotLightCount = Clamped.SpotLightCount < MAX_SPOT_LIGHTS ? Clamped.SpotLightCount : MAX_SPOT_LIGHTS;
+	return Clamped;
+}
+
+unsigned int ShaderPermutations::PackKey(const ShaderPermutationKey& Key)
+{
+	// 4 bits per light count & filter, features in the upper bits
+	return (Key.PointLightCount & 0xF) |
+		   ((Key.SpotLightCount & 0xF) << 4) |
+		   (((unsigned int)Key.Filter & 0xF) << 8) |
+		   (Key.Features << 12);
+}
+
+std::string ShaderPermutations::BuildDefines(const ShaderPermutationKey& Key)
+{
+	char Defines[512] = { '\0' };
+	snprintf(Defines, sizeof(Defines),
+			 "#define POINT_LIGHT_COUNT %u\n"
+			 "#define SPOT_LIGHT_COUNT %u\n"
+			 "#define SHADOW_FILTER %d\n"
+			 "#define ENABLE_DIRECTIONAL_SHADOWS %d\n"
+			 "#define ENABLE_OMNI_SHADOWS %d\n"
+			 "#define ENABLE_SPECULAR %d\n",
+			 Key.PointLightCount,
+			 Key.SpotLightCount,
+			 (int)Key.Filter,
+			 (Key.Features & SHADER_FEATURE_DIRECTIONAL_SHADOWS) ? 1 : 0,
+			 (Key.Features & SHADER_FEATURE_OMNI_SHADOWS) ? 1 : 0,
+			 (Key.Features & SHADER_FEATURE_SPECULAR) ? 1 : 0);
+
+	return Defines;
+}
+
+ShaderPermutations::~ShaderPermutations()
+{
+	ClearPermutations();
+}
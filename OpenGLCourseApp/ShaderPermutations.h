@@ -0,0 +1,75 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CommonValues.h"
+#include "Shader.h"
+#include "AssetManager.h"
+
+// Shadow filtering compiled into a permutation, must match SHADOW_FILTER_* in shader.frag
+enum ShadowFilter
+{
+	SHADOW_FILTER_HARD = 0,		// Single tap
+	SHADOW_FILTER_PCF_LOW,		// 3x3 directional, 8 tap omni, 4 taps each outside penumbrae
+	SHADOW_FILTER_PCF_HIGH,		// 3x3 directional, 20 tap omni, 4 taps each outside penumbrae
+	SHADOW_FILTER_EVSM,			// One trilinear fetch of prefiltered exponential moments per light
+	SHADOW_FILTER_COUNT
+};
+
+// Optional parts of the lighting shader, a disabled feature compiles to nothing
+enum ShaderFeature
+{
+	SHADER_FEATURE_DIRECTIONAL_SHADOWS = 1 << 0,
+	SHADER_FEATURE_OMNI_SHADOWS = 1 << 1,
+	SHADER_FEATURE_SPECULAR = 1 << 2,
+	SHADER_FEATURE_ALL = SHADER_FEATURE_DIRECTIONAL_SHADOWS | SHADER_FEATURE_OMNI_SHADOWS | SHADER_FEATURE_SPECULAR
+};
+
+struct ShaderPermutationKey
+{
+	unsigned int PointLightCount;
+	unsigned int SpotLightCount;
+	ShadowFilter Filter;
+	unsigned int Features;		// ShaderFeature flags
+};
+
+// One program per permutation of a shader pair, compiled on first use & kept for the rest of the run
+// Only the first one blocks, later ones link in the background while the last ready one keeps drawing.
+// Each permutation sees different defines, so it also gets its own program binary cache entry.
+// Programs are owned by the asset cache, another user asking for the same defines gets the same program.
+class ShaderPermutations
+{
+public:
+	ShaderPermutations();
+
+	void Initialize(const char* NewVertexPath, const char* NewFragmentPath, AssetManager* NewAssets);
+
+	// Starts compiling the permutation the first time it is asked for. Until it has linked this returns
+	// the permutation used last, OutKey says which one came back. Blocks only when none is ready yet.
+	Shader* GetShader(const ShaderPermutationKey& InKey, ShaderPermutationKey* OutKey);
+
+	// Starts compiling permutations likely to be asked for later, call after the first GetShader
+	void Prewarm(const ShaderPermutationKey* Keys, size_t KeyCount);
+
+	// Every permutation compiled so far, for hot reload. Pending ones are in here too, polling them finishes the link.
+	void GetShaders(std::vector<Shader*>* OutShaders);
+
+	void ClearPermutations();
+
+	~ShaderPermutations();
+
+private:
+	std::string VertexPath;
+	std::string FragmentPath;
+	AssetManager* Assets;
+	std::unordered_map<unsigned int, std::shared_ptr<Shader>> Permutations;
+	Shader* ReadyShader;
+	ShaderPermutationKey ReadyKey;
+
+	static ShaderPermutationKey ClampKey(const ShaderPermutationKey& Key);
+	static unsigned int PackKey(const ShaderPermutationKey& Key);
+	static std::string BuildDefines(const ShaderPermutationKey& Key);
+};
@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ShaderReflection.h"
+
+ShaderReflection::ShaderReflection()
+{
+}
+
+void ShaderReflection::Reflect(GLuint Program)
+{
+	Clear();
+
+	ReflectUniforms(Program);
+	ReflectBlocks(Program);
+	ReflectAttributes(Program);
+	BuildTable();
+}
+
+void ShaderReflection::Clear()
+{
+	Uniforms.clear();
+	Blocks.clear();
+	Attributes.clear();
+	Slots.clear();
+}
+
+void ShaderReflection::ReflectUniforms(GLuint Program)
+{
+	char Name[256] = { '\0' };
+
+	if (GLEW_VERSION_4_3 || GLEW_ARB_program_interface_query)
+	{
+		GLint Count = 0;
+		glGetProgramInterfaceiv(Program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &Count);
+
+		const GLenum Properties[4] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION, GL_BLOCK_INDEX };
+		for (GLint i = 0; i < Count; i++)
+		{
+			GLint Values[4] = { 0 };
+			glGetProgramResourceiv(Program, GL_UNIFORM, i, 4, Properties, 4, nullptr, Values);
+
+			// Block members are set through their buffer, not glUniform*
+			if (Values[3] != -1)
+			{
+				continue;
+			}
+
+			glGetProgramResourceName(Program, GL_UNIFORM, i, sizeof(Name), nullptr, Name);
+			AddUniform(Program, Name, Values[0], Values[1], Values[2]);
+		}
+		return;
+	}
+
+	GLint Count = 0;
+	glGetProgramiv(Program, GL_ACTIVE_UNIFORMS, &Count);
+
+	for (GLint i = 0; i < Count; i++)
+	{
+		GLuint Index = i;
+		GLint BlockIndex = -1;
+		glGetActiveUniformsiv(Program, 1, &Index, GL_UNIFORM_BLOCK_INDEX, &BlockIndex);
+		if (BlockIndex != -1)
+		{
+			continue;
+		}
+
+		GLint ArraySize = 0;
+		GLenum Type = 0;
+		glGetActiveUniform(Program, Index, sizeof(Name), nullptr, &ArraySize, &Type, Name);
+		AddUniform(Program, Name, Type, ArraySize, glGetUniformLocation(Program, Name));
+	}
+}
+
+void ShaderReflection::AddUniform(GLuint Program, const char* Name, GLenum Type, GLint ArraySize, GLint Location)
+{
+	ReflectedUniform Uniform = {};
+	Uniform.Type = Type;
+	Uniform.bSampler = IsSamplerType(Type);
+	Uniform.bHasValue = false;
+
+	// Arrays of basic types come back once as "Name[0]", give every element its own entry
+	size_t Length = strlen(Name);
+	if (ArraySize > 1 && Length > 3 && strcmp(Name + Length - 3, "[0]") == 0)
+	{
+		std::string BaseName(Name, Length - 3);
+		for (GLint i = 0; i < ArraySize; i++)
+		{
+			char ElementName[256] = { '\0' };
+			snprintf(ElementName, sizeof(ElementName), "%s[%d]", BaseName.c_str(), i);
+
+			Uniform.Name = ElementName;
+			Uniform.Location = i == 0 ? Location : glGetUniformLocation(Program, ElementName);
+			Uniforms.push_back(Uniform);
+		}
+		return;
+	}
+
+	Uniform.Name = Name;
+	Uniform.Location = Location;
+	Uniforms.push_back(Uniform);
+}
+
+void ShaderReflection::ReflectBlocks(GLuint Program)
+{
+	GLint Count = 0;
+	glGetProgramiv(Program, GL_ACTIVE_UNIFORM_BLOCKS, &Count);
+
+	for (GLint i = 0; i < Count; i++)
+	{
+		char Name[256] = { '\0' };
+		glGetActiveUniformBlockName(Program, i, sizeof(Name), nullptr, Name);
+
+		ReflectedBlock Block = {};
+		Block.Name = Name;
+		Block.Index = i;
+		glGetActiveUniformBlockiv(Program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &Block.DataSize);
+		glGetActiveUniformBlockiv(Program, i, GL_UNIFORM_BLOCK_BINDING, &Block.Binding);
+		Blocks.push_back(Block);
+	}
+}
+
+void ShaderReflection::ReflectAttributes(GLuint Program)
+{
+	GLint Count = 0;
+	glGetProgramiv(Program, GL_ACTIVE_ATTRIBUTES, &Count);
+
+	for (GLint i = 0; i < Count; i++)
+	{
+		char Name[256] = { '\0' };
+		ReflectedAttribute Attribute = {};
+		glGetActiveAttrib(Program, i, sizeof(Name), nullptr, &Attribute.Size, &Attribute.Type, Name);
+
+		Attribute.Name = Name;
+		Attribute.Location = glGetAttribLocation(Program, Name);
+		Attributes.push_back(Attribute);
+	}
+}
+
+void ShaderReflection::BuildTable()
+{
+	// Keep the table at most half full so probe chains stay short
+	size_t SlotCount = 16;
+	while (SlotCount < Uniforms.size() * 2)
+	{
+		SlotCount *= 2;
+	}
+	Slots.assign(SlotCount, -1);
+
+	for (size_t i = 0; i < Uniforms.size(); i++)
+	{
+		Uniforms[i].Hash = HashName(Uniforms[i].Name.c_str());
+
+		size_t Slot = Uniforms[i].Hash & (SlotCount - 1);
+		while (Slots[Slot] != -1)
+		{
+			Slot = (Slot + 1) & (SlotCount - 1);
+		}
+		Slots[Slot] = (int)i;
+	}
+}
+
+UniformHandle ShaderReflection::FindUniform(const char* Name) const
+{
+	if (Slots.empty())
+	{
+		return INVALID_UNIFORM;
+	}
+
+	unsigned int Hash = HashName(Name);
+	size_t Mask = Slots.size() - 1;
+
+	for (size_t Slot = Hash & Mask; Slots[Slot] != -1; Slot = (Slot + 1) & Mask)
+	{
+		const ReflectedUniform& Uniform = Uniforms[Slots[Slot]];
+		if (Uniform.Hash == Hash && Uniform.Name == Name)
+		{
+			return Slots[Slot];
+		}
+	}
+
+	return INVALID_UNIFORM;
+}
+
+GLint ShaderReflection::GetLocation(UniformHandle Handle) const
+{
+	return Handle == INVALID_UNIFORM ? -1 : Uniforms[Handle].Location;
+}
+
+bool ShaderReflection::StoreValue(UniformHandle Handle, const void* Value, size_t Size)
+{
+	ReflectedUniform& Uniform = Uniforms[Handle];
+	if (Uniform.bHasValue && memcmp(Uniform.Value, Value, Size) == 0)
+	{
+		return false;
+	}
+
+	memcpy(Uniform.Value, Value, Size);
+	Uniform.bHasValue = true;
+	return true;
+}
+
+const ReflectedBlock* ShaderReflection::FindBlock(const char* Name) const
+{
+	for (size_t i = 0; i < Blocks.size(); i++)
+	{
+		if (Blocks[i].Name == Name)
+		{
+			return &Blocks[i];
+		}
+	}
+	return nullptr;
+}
+
+GLint ShaderReflection::FindAttribute(const char* Name) const
+{
+	for (size_t i = 0; i < Attributes.size(); i++)
+	{
+		if (Attributes[i].Name == Name)
+		{
+			return Attributes[i].Location;
+		}
+	}
+	return -1;
+}
+
+size_t ShaderReflection::CountArrayElements(const char* ArrayName) const
+{
+	size_t PrefixLength = strlen(ArrayName);
+	size_t Count = 0;
+
+	for (size_t i = 0; i < Uniforms.size(); i++)
+	{
+		const std::string& Name = Uniforms[i].Name;
+		if (Name.size() > PrefixLength + 1 && Name.compare(0, PrefixLength, ArrayName) == 0 && Name[PrefixLength] == '[')
+		{
+			size_t Index = (size_t)atoi(Name.c_str() + PrefixLength + 1);
+			Count = Index + 1 > Count ? Index + 1 : Count;
+		}
+	}
+
+	return Count;
+}
+
+size_t ShaderReflection::GetSamplerCount() const
+{
+	size_t Count = 0;
+	for (size_t i = 0; i < Uniforms.size(); i++)
+	{
+		if (Uniforms[i].bSampler)
+		{
+			Count++;
+		}
+	}
+	return Count;
+}
+
+unsigned int ShaderReflection::HashName(const char* Name)
+{
+	// 32-bit FNV-1a
+	unsigned int Hash = 2166136261u;
+	for (; *Name; Name++)
+	{
+		Hash ^= (unsigned char)*Name;
+		Hash *= 16777619u;
+	}
+	return Hash;
+}
+
+bool ShaderReflection::IsSamplerType(GLenum Type)
+{
+	switch (Type)
+	{
+	case GL_SAMPLER_1D:
+	case GL_SAMPLER_2D:
+	case GL_SAMPLER_3D:
+	case GL_SAMPLER_CUBE:
+	case GL_SAMPLER_1D_SHADOW:
+	case GL_SAMPLER_2D_SHADOW:
+	case GL_SAMPLER_CUBE_SHADOW:
+	case GL_SAMPLER_1D_ARRAY:
+	case GL_SAMPLER_2D_ARRAY:
+	case GL_SAMPLER_1D_ARRAY_SHADOW:
+	case GL_SAMPLER_2D_ARRAY_SHADOW:
+	case GL_SAMPLER_2D_MULTISAMPLE:
+	case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+	case GL_SAMPLER_BUFFER:
+	case GL_SAMPLER_2D_RECT:
+	case GL_SAMPLER_2D_RECT_SHADOW:
+	case GL_INT_SAMPLER_2D:
+	case GL_INT_SAMPLER_3D:
+	case GL_INT_SAMPLER_CUBE:
+	case GL_INT_SAMPLER_2D_ARRAY:
+	case GL_UNSIGNED_INT_SAMPLER_2D:
+	case GL_UNSIGNED_INT_SAMPLER_3D:
+	case GL_UNSIGNED_INT_SAMPLER_CUBE:
+	case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+		return true;
+	default:
+		return false;
+	}
+}
+
+ShaderReflection::~ShaderReflection()
+{
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Index of a reflected uniform in its program's table, stays valid until the program is relinked
+typedef int UniformHandle;
+const UniformHandle INVALID_UNIFORM = -1;
+
+struct ReflectedUniform
+{
+	std::string Name;			// Arrays are split per element, "LightMatrices[3]"
+	unsigned int Hash;
+	GLint Location;
+	GLenum Type;
+	bool bSampler;
+
+	// Last value uploaded through Shader's setters (up to a mat4), so repeated values skip the GL call
+	bool bHasValue;
+	GLfloat Value[16];
+};
+
+struct ReflectedBlock
+{
+	std::string Name;
+	GLuint Index;
+	GLint DataSize;
+	GLint Binding;
+};
+
+struct ReflectedAttribute
+{
+	std::string Name;
+	GLint Location;
+	GLenum Type;
+	GLint Size;
+};
+
+// Everything a linked program actually uses, enumerated once after link (or after loading a cached binary)
+// Uses GL_ARB_program_interface_query when available, the older glGetActive* queries otherwise.
+// Uniform names live in a flat open addressed hash table, so lookups don't allocate or walk nodes.
+class ShaderReflection
+{
+public:
+	ShaderReflection();
+
+	void Reflect(GLuint Program);
+	void Clear();
+
+	UniformHandle FindUniform(const char* Name) const;
+	GLint GetLocation(UniformHandle Handle) const;
+	ReflectedUniform& GetUniform(UniformHandle Handle) { return Uniforms[Handle]; }
+
+	// Records Value as the uniform's current value, false if it already held exactly that
+	bool StoreValue(UniformHandle Handle, const void* Value, size_t Size);
+
+	const ReflectedBlock* FindBlock(const char* Name) const;
+	GLint FindAttribute(const char* Name) const;
+
+	// Length of a uniform array ("MyPointLights") as far as the program uses it
+	size_t CountArrayElements(const char* ArrayName) const;
+
+	size_t GetUniformCount() const { return Uniforms.size(); }
+	size_t GetSamplerCount() const;
+	size_t GetBlockCount() const { return Blocks.size(); }
+	size_t GetAttributeCount() const { return Attributes.size(); }
+
+	~ShaderReflection();
+
+private:
+	std::vector<ReflectedUniform> Uniforms;
+	std::vector<ReflectedBlock> Blocks;
+	std::vector<ReflectedAttribute> Attributes;
+
+	// Power of two sized, each slot holds an index into Uniforms or -1
+	std::vector<int> Slots;
+
+	void ReflectUniforms(GLuint Program);
+	void ReflectBlocks(GLuint Program);
+	void ReflectAttributes(GLuint Program);
+	void AddUniform(GLuint Program, const char* Name, GLenum Type, GLint ArraySize, GLint Location);
+	void BuildTable();
+
+	static unsigned int HashName(const char* Name);
+	static bool IsSamplerType(GLenum Type);
+};
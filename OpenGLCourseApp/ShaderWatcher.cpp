@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <map>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "ShaderWatcher.h"
+
+ShaderWatcher::ShaderWatcher()
+{
+	bRunning = false;
+}
+
+bool ShaderWatcher::Start(const std::string& NewDirectory)
+{
+	if (bRunning)
+	{
+		return true;
+	}
+
+	if (!std::filesystem::is_directory(NewDirectory))
+	{
+		printf("Shader watcher can't find directory %s\n", NewDirectory.c_str());
+		return false;
+	}
+
+	Directory = NewDirectory;
+	bRunning = true;
+	WatchThread = std::thread(&ShaderWatcher::WatchLoop, this);
+
+	printf("Watching %s for shader changes\n", Directory.c_str());
+	return true;
+}
+
+void ShaderWatcher::Stop()
+{
+	bRunning = false;
+	if (WatchThread.joinable())
+	{
+		WatchThread.join();
+	}
+}
+
+std::vector<std::string> ShaderWatcher::ConsumeChangedFiles()
+{
+	std::lock_guard<std::mutex> Guard(ChangeLock);
+	std::vector<std::string> Changes;
+	Changes.swap(ChangedFiles);
+	return Changes;
+}
+
+void ShaderWatcher::AddChange(const std::string& FileName)
+{
+	std::string Path = Directory + "/" + FileName;
+
+	// Editors often write a file several times per save, only report it once
+	std::lock_guard<std::mutex> Guard(ChangeLock);
+	if (std::find(ChangedFiles.begin(), ChangedFiles.end(), Path) == ChangedFiles.end())
+	{
+		ChangedFiles.push_back(Path);
+	}
+}
+
+#ifdef __linux__
+
+void ShaderWatcher::WatchLoop()
+{
+	int Notify = inotify_init1(IN_NONBLOCK);
+	if (Notify < 0 || inotify_add_watch(Notify, Directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		printf("Failed to start inotify on %s\n", Directory.c_str());
+		if (Notify >= 0)
+		{
+			close(Notify);
+		}
+		return;
+	}
+
+	alignas(inotify_event) char Buffer[4096];
+	while (bRunning)
+	{
+		// Wake up regularly so Stop() doesn't wait on the next file change
+		pollfd Poll = { Notify, POLLIN, 0 };
+		if (poll(&Poll, 1, 100) <= 0)
+		{
+			continue;
+		}
+
+		ssize_t Length = read(Notify, Buffer, sizeof(Buffer));
+		for (ssize_t Offset = 0; Offset < Length;)
+		{
+			const inotify_event* Event = reinterpret_cast<const inotify_event*>(Buffer + Offset);
+			if (Event->len > 0)
+			{
+				AddChange(Event->name);
+			}
+			Offset += sizeof(inotify_event) + Event->len;
+		}
+	}
+
+	close(Notify);
+}
+
+#else
+
+void ShaderWatcher::WatchLoop()
+{
+	std::map<std::string, std::filesystem::file_time_type> WriteTimes;
+	bool bFirstScan = true;
+
+	while (bRunning)
+	{
+		std::error_code Error;
+		for (const std::filesystem::directory_entry& Entry : std::filesystem::directory_iterator(Directory, Error))
+		{
+			if (!Entry.is_regular_file(Error))
+			{
+				continue;
+			}
+
+			std::string FileName = Entry.path().filename().string();
+			std::filesystem::file_time_type WriteTime = Entry.last_write_time(Error);
+
+			// The first scan only records the starting state
+			std::map<std::string, std::filesystem::file_time_type>::iterator Known = WriteTimes.find(FileName);
+			if (!bFirstScan && (Known == WriteTimes.end() || Known->second != WriteTime))
+			{
+				AddChange(FileName);
+			}
+			WriteTimes[FileName] = WriteTime;
+		}
+
+		bFirstScan = false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+	}
+}
+
+#endif
+
+ShaderWatcher::~ShaderWatcher()
+{
+	Stop();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Watches a directory on a background thread & reports files that were written
+// Linux uses inotify, other platforms poll the modification times a few times per second.
+class ShaderWatcher
+{
+public:
+	ShaderWatcher();
+
+	bool Start(const std::string& NewDirectory);
+	void Stop();
+
+	// Paths ("Shaders/shader.frag") changed since the last call, each reported once
+	std::vector<std::string> ConsumeChangedFiles();
+
+	~ShaderWatcher();
+
+private:
+	std::string Directory;
+	std::thread WatchThread;
+	std::atomic<bool> bRunning;
+
+	std::mutex ChangeLock;
+	std::vector<std::string> ChangedFiles;
+
+	void AddChange(const std::string& FileName);
+	void WatchLoop();
+};
@@ -0,0 +1,8 @@
+// Main view camera, written by CameraBuffer just before the main pass draws
+// std140, mirrors CameraBlockData in CameraBuffer.h
+layout (std140) uniform CameraBlock
+{
+    mat4 View;
+    mat4 Projection;
+    vec3 EyePosition;
+};
@@ -3,9 +3,21 @@
 layout (location = 0) in vec3 pos;
 
 uniform mat4 Model;
+
+#ifdef DEPTH_PREPASS
+#include "camera.glsl"
+
+// Must match shader.vert exactly, the main pass depth tests GL_EQUAL against this
+invariant gl_Position;
+#else
 uniform mat4 DirectionalLightTransform;
+#endif
 
 void main()
 {
+#ifdef DEPTH_PREPASS
+	gl_Position = Projection * View * Model * vec4(pos,1.0);
+#else
 	gl_Position = DirectionalLightTransform * Model * vec4(pos, 1.0);
-}
\ No newline at end of file
+#endif
+}
@@ -0,0 +1,11 @@
+#version 330
+
+// Fullscreen triangle from the vertex index, no vertex buffer needed
+out vec2 TextureCoordinates;
+
+void main()
+{
+	vec2 Corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	TextureCoordinates = Corner;
+	gl_Position = vec4(Corner * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,59 @@
+// Light & material structs shared by the lit shaders, mirrors the uniform names Shader resolves
+
+struct Light
+{
+    vec3 Color;
+    float AmbientIntensity;
+    float DiffuseIntensity;
+};
+
+struct DirectionalLight 
+{
+    Light Base;
+    vec3 Direction;
+};
+
+struct PointLight
+{
+    Light Base;
+    vec3 Position;
+    float Constant;
+    float Linear;
+    float Exponent;
+};
+
+struct SpotLight
+{
+    PointLight Base;
+    vec3 Direction;
+    float Edge;
+};
+
+struct OmniShadowMap
+{
+#if SHADOW_FILTER == SHADOW_FILTER_EVSM
+    samplerCube ShadowMapCube;          // Blurred moments instead of depth
+#else
+    samplerCubeShadow ShadowMapCube;
+#endif
+    float FarPlane;
+};
+
+// Spot lights project one perspective map over their cone, holding distance / FarPlane like the cube maps
+struct SpotShadowMap
+{
+#if SHADOW_FILTER == SHADOW_FILTER_EVSM
+    sampler2D ShadowMap;
+#else
+    sampler2DShadow ShadowMap;
+#endif
+    mat4 LightTransform;                // The view-projection the map was drawn with, onto the light's atlas tile
+    float FarPlane;
+    vec4 TileBounds;                    // The tile in texture coordinates, min xy & max xy, lookups stay inside it
+};
+
+struct Material
+{
+    float SpecularIntensity;
+    float Shininess;
+};
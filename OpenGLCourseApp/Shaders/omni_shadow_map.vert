@@ -4,7 +4,19 @@ layout (location = 0) in vec3 pos;
 
 uniform mat4 Model;
 
+#ifdef SPOT_SHADOW
+// A spot light's single perspective map is drawn straight from here, no cube faces to fan out to
+uniform mat4 LightMatrices[1];
+
+out vec4 FragmentPosition;
+#endif
+
 void main()
 {
+#ifdef SPOT_SHADOW
+	FragmentPosition = Model * vec4(pos, 1.0);
+	gl_Position = LightMatrices[0] * FragmentPosition;
+#else
 	gl_Position = Model * vec4(pos, 1.0);
+#endif
 }
\ No newline at end of file
@@ -8,107 +8,185 @@ in vec4 DirectionalLightSpacePosition;
 
 out vec4 color;
 
-const int MAX_POINT_LIGHTS = 3;
-const int MAX_SPOT_LIGHTS = 3;
-
-struct Light
-{
-    vec3 Color;
-    float AmbientIntensity;
-    float DiffuseIntensity;
-};
-
-struct DirectionalLight 
-{
-    Light Base;
-    vec3 Direction;
-};
-
-struct PointLight
-{
-    Light Base;
-    vec3 Position;
-    float Constant;
-    float Linear;
-    float Exponent;
-};
-
-struct SpotLight
-{
-    PointLight Base;
-    vec3 Direction;
-    float Edge;
-};
-
-struct OmniShadowMap
-{
-    samplerCube ShadowMapCube;
-    float FarPlane;
-};
-
-struct Material
-{
-    float SpecularIntensity;
-    float Shininess;
-};
-
-uniform int PointLightCount;
-uniform int SpotLightCount;
+// Shadow filter qualities, must match ShadowFilter in ShaderPermutations.h
+#define SHADOW_FILTER_HARD 0
+#define SHADOW_FILTER_PCF_LOW 1
+#define SHADOW_FILTER_PCF_HIGH 2
+#define SHADOW_FILTER_EVSM 3
+
+// ShaderPermutations injects these after #version, the defaults only apply when compiled on its own
+#ifndef POINT_LIGHT_COUNT
+#define POINT_LIGHT_COUNT 3
+#endif
+#ifndef SPOT_LIGHT_COUNT
+#define SPOT_LIGHT_COUNT 3
+#endif
+#ifndef SHADOW_FILTER
+#define SHADOW_FILTER SHADOW_FILTER_PCF_HIGH
+#endif
+#ifndef ENABLE_DIRECTIONAL_SHADOWS
+#define ENABLE_DIRECTIONAL_SHADOWS 1
+#endif
+#ifndef ENABLE_OMNI_SHADOWS
+#define ENABLE_OMNI_SHADOWS 1
+#endif
+#ifndef ENABLE_SPECULAR
+#define ENABLE_SPECULAR 1
+#endif
+
+#if POINT_LIGHT_COUNT > 3 || SPOT_LIGHT_COUNT > 3
+#error "Light counts above MAX_POINT_LIGHTS / MAX_SPOT_LIGHTS need more unrolled terms below"
+#endif
+
+#include "lights.glsl"
+#include "camera.glsl"
 
 uniform DirectionalLight MyDirectionalLight;
-uniform PointLight MyPointLights[MAX_POINT_LIGHTS];
-uniform SpotLight MySpotLights[MAX_SPOT_LIGHTS];
+#if POINT_LIGHT_COUNT > 0
+uniform PointLight MyPointLights[POINT_LIGHT_COUNT];
+#endif
+#if SPOT_LIGHT_COUNT > 0
+uniform SpotLight MySpotLights[SPOT_LIGHT_COUNT];
+#endif
 
 uniform sampler2D MyTexture;
+#if SHADOW_FILTER == SHADOW_FILTER_EVSM
 uniform sampler2D DirectionalShadowMap;
+#else
+uniform sampler2DShadow DirectionalShadowMap;
+#endif
 uniform Material MyMaterial;
-uniform vec3 EyePosition;
 
-uniform OmniShadowMap OmniShadowMaps[MAX_POINT_LIGHTS + MAX_SPOT_LIGHTS];
-
-vec3 SampleDisk[20] = vec3[]
+#if POINT_LIGHT_COUNT > 0
+uniform OmniShadowMap OmniShadowMaps[POINT_LIGHT_COUNT];
+#endif
+#if SPOT_LIGHT_COUNT > 0
+uniform SpotShadowMap SpotShadowMaps[SPOT_LIGHT_COUNT];
+#endif
+
+// Shadow maps hold depth for the hardware comparison, or moments for EVSM
+#if SHADOW_FILTER == SHADOW_FILTER_EVSM
+#define OMNI_SHADOW_SAMPLER samplerCube
+#define SPOT_SHADOW_SAMPLER sampler2D
+#else
+#define OMNI_SHADOW_SAMPLER samplerCubeShadow
+#define SPOT_SHADOW_SAMPLER sampler2DShadow
+#endif
+
+// The first 8 taps are the cube corners, PCF_LOW only uses those
+#if SHADOW_FILTER == SHADOW_FILTER_PCF_HIGH
+const int OMNI_SHADOW_SAMPLES = 20;
+#else
+const int OMNI_SHADOW_SAMPLES = 8;
+#endif
+
+// Taps taken before deciding whether the fragment is in a penumbra at all
+const int EARLY_SHADOW_SAMPLES = 4;
+
+// Starts with alternate cube corners (a tetrahedron), so the early taps are spread in every direction
+const vec3 SampleDisk[20] = vec3[]
 (
-   vec3(1,  1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1,  1,  1), 
-   vec3(1,  1, -1), vec3( 1, -1, -1), vec3(-1, -1, -1), vec3(-1,  1, -1),
+   vec3(1,  1,  1), vec3(-1, -1,  1), vec3( 1, -1, -1), vec3(-1,  1, -1),
+   vec3(1, -1,  1), vec3(-1,  1,  1), vec3( 1,  1, -1), vec3(-1, -1, -1),
    vec3(1,  1,  0), vec3( 1, -1,  0), vec3(-1, -1,  0), vec3(-1,  1,  0),
    vec3(1,  0,  1), vec3(-1,  0,  1), vec3( 1,  0, -1), vec3(-1,  0, -1),
    vec3(0,  1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0,  1, -1)
 );
 
+// Directional 3x3 grid, the corners first for the same reason
+const vec2 GridOffsets[9] = vec2[]
+(
+   vec2(-1, -1), vec2( 1, -1), vec2(-1,  1), vec2( 1,  1),
+   vec2( 0, -1), vec2(-1,  0), vec2( 0,  0), vec2( 1,  0), vec2( 0,  1)
+);
+
+#if SHADOW_FILTER == SHADOW_FILTER_EVSM
+// Must match the ShadowMomentFilter settings the moments were built with
+uniform float ShadowExponent;
+uniform float LightBleedReduction;
+uniform float VarianceBias;
+
+// Shadow from prefiltered moments: Chebyshev's upper bound on the lit fraction, computed on warped depth
+float CalculateMomentShadow(vec2 Moments, float Depth)
+{
+    float Warped = exp(ShadowExponent * Depth);
+    if(Warped <= Moments.x)
+    {
+        return 0.0;
+    }
+
+    // The bias is in depth units, scaled by the warp's slope at this depth
+    float WarpSlope = ShadowExponent * Warped;
+    float Variance = max(Moments.y - Moments.x * Moments.x, VarianceBias * WarpSlope * WarpSlope);
+    float Distance = Warped - Moments.x;
+    float Lit = Variance / (Variance + Distance * Distance);
+
+    // Clip the tail of the bound, where overlapping occluders leak light
+    Lit = clamp((Lit - LightBleedReduction) / (1.0 - LightBleedReduction), 0.0, 1.0);
+    return 1.0 - Lit;
+}
+#else
+// 3x3 grid of compares around Reference.xy, the corners decide whether the rest are needed
+float SampleShadowGrid(sampler2DShadow ShadowMap, vec3 Reference)
+{
+    vec2 TexelSize = 1.0 / textureSize(ShadowMap, 0);
+
+    // Fully lit or fully shadowed at the corners, the rest of the grid would only agree
+    float Lit = 0.0;
+    for(int i = 0; i < EARLY_SHADOW_SAMPLES; i++)
+    {
+        Lit += texture(ShadowMap, Reference + vec3(GridOffsets[i] * TexelSize, 0.0));
+    }
+    if(Lit == 0.0 || Lit == float(EARLY_SHADOW_SAMPLES))
+    {
+        return 1.0 - Lit / float(EARLY_SHADOW_SAMPLES);
+    }
+
+    // Penumbra, take the remaining taps
+    for(int i = EARLY_SHADOW_SAMPLES; i < 9; i++)
+    {
+        Lit += texture(ShadowMap, Reference + vec3(GridOffsets[i] * TexelSize, 0.0));
+    }
+
+    return 1.0 - Lit / 9.0;
+}
+#endif
 
 float CalculateDirectionalShadowFactor(DirectionalLight Light)
 {
+#if ENABLE_DIRECTIONAL_SHADOWS
     vec3 ProjectedCoords = DirectionalLightSpacePosition.xyz / DirectionalLightSpacePosition.w;
     // Map "-1 to +1" to "0 to +1"
     ProjectedCoords = (ProjectedCoords * 0.5) + 0.5;
 
-    float CurrentDepth = ProjectedCoords.z;
+    if(ProjectedCoords.z > 1.0)
+    {
+        return 0.0;
+    }
 
     vec3 MyNormal = normalize(Normal);
     vec3 LightDirection = normalize(Light.Direction);
 
     float Bias = max(0.005 * (1 - dot(MyNormal, LightDirection)), 0.005);
 
-    float Shadow = 0.0;
-
-    vec2 TexelSize = 1.0 / textureSize(DirectionalShadowMap, 0);
-    for(int x = -1; x <= 1; x++)
-    {
-        for(int y = -1; y <= 1; y++)
-        {
-            float PCF_Depth = texture(DirectionalShadowMap, ProjectedCoords.xy + vec2(x, y) * TexelSize).r;
-            Shadow += CurrentDepth - Bias > PCF_Depth ? 1.0 : 0.0;
-        }
-    }
-
-    Shadow /= 9.0f;
+    // The sampler compares against the reference depth in z, each tap returns the lit fraction of a bilinear 2x2
+    vec3 Reference = vec3(ProjectedCoords.xy, ProjectedCoords.z - Bias);
 
-    if(ProjectedCoords.z > 1.0)
+#if SHADOW_FILTER == SHADOW_FILTER_EVSM
+    // Outside the map counts as lit, like the depth map's border. The variance bias stands in for Bias.
+    if(any(lessThan(ProjectedCoords.xy, vec2(0.0))) || any(greaterThan(ProjectedCoords.xy, vec2(1.0))))
     {
-        Shadow = 0.0;
+        return 0.0;
     }
-
-    return Shadow;
+    return CalculateMomentShadow(texture(DirectionalShadowMap, ProjectedCoords.xy).rg, ProjectedCoords.z);
+#elif SHADOW_FILTER == SHADOW_FILTER_HARD
+    return 1.0 - texture(DirectionalShadowMap, Reference);
+#else
+    return SampleShadowGrid(DirectionalShadowMap, Reference);
+#endif
+#else
+    return 0.0;
+#endif
 }
 
 vec4 CalculateLightByDirection(Light TheLight, vec3 TheDirection, float ShadowFactor)
@@ -120,6 +198,7 @@ vec4 CalculateLightByDirection(Light TheLight, vec3 TheDirection, float ShadowFa
 
     vec4 SpecularColor = vec4(0, 0, 0, 0);
 
+#if ENABLE_SPECULAR
     if(DiffuseFactor > 0.0f)
     {
         vec3 FragToEye = normalize(EyePosition - FragmentPosition);
@@ -133,36 +212,87 @@ vec4 CalculateLightByDirection(Light TheLight, vec3 TheDirection, float ShadowFa
             SpecularColor = vec4(TheLight.Color * MyMaterial.SpecularIntensity * SpecularFactor, 1.0f);
         }
     }
+#endif
 
     return (AmbientColor + (1.0 - ShadowFactor) * (DiffuseColor + SpecularColor));
 }
 
-float CalculateOmniShadowFactor(PointLight InLight, int ShadowIndex)
+// Samplers are passed in rather than indexed, GLSL 3.30 only allows constant sampler array indices
+float CalculateOmniShadowFactor(PointLight InLight, OMNI_SHADOW_SAMPLER ShadowMapCube, float FarPlane)
 {
+#if ENABLE_OMNI_SHADOWS
     vec3 FragmentToLight = FragmentPosition - InLight.Position;
     float CurrentDepth = length(FragmentToLight);
 
-    float Shadow = 0.0;
     float Bias = 0.05;
-    float Samples = 20;
 
+    // The cube map stores distance / FarPlane, the sampler compares it against w
+    float Reference = (CurrentDepth - Bias) / FarPlane;
+
+#if SHADOW_FILTER == SHADOW_FILTER_EVSM
+    // The moments were built from the same distance / FarPlane
+    return CalculateMomentShadow(texture(ShadowMapCube, FragmentToLight).rg, CurrentDepth / FarPlane);
+#elif SHADOW_FILTER == SHADOW_FILTER_HARD
+    return 1.0 - texture(ShadowMapCube, vec4(FragmentToLight, Reference));
+#else
     float ViewDistance = length(EyePosition - FragmentPosition);
-    float DiskRadius = (1.0 + (ViewDistance / OmniShadowMaps[ShadowIndex].FarPlane)) / 25.0;
+    float DiskRadius = (1.0 + (ViewDistance / FarPlane)) / 25.0;
 
-    for(int i = 0; i < Samples; i++)
+    // Fully lit or fully shadowed at the early taps, the rest would only agree
+    float Lit = 0.0;
+    for(int i = 0; i < EARLY_SHADOW_SAMPLES; i++)
     {
-        float ClosestDepth = texture(OmniShadowMaps[ShadowIndex].ShadowMapCube, FragmentToLight + SampleDisk[i] * DiskRadius).r;
-        ClosestDepth *= OmniShadowMaps[ShadowIndex].FarPlane;
-        if(CurrentDepth - Bias > ClosestDepth)
-        {
-            Shadow += 1.0;
-        }
+        Lit += texture(ShadowMapCube, vec4(FragmentToLight + SampleDisk[i] * DiskRadius, Reference));
+    }
+    if(Lit == 0.0 || Lit == float(EARLY_SHADOW_SAMPLES))
+    {
+        return 1.0 - Lit / float(EARLY_SHADOW_SAMPLES);
+    }
+
+    // Penumbra, take the remaining taps
+    for(int i = EARLY_SHADOW_SAMPLES; i < OMNI_SHADOW_SAMPLES; i++)
+    {
+        Lit += texture(ShadowMapCube, vec4(FragmentToLight + SampleDisk[i] * DiskRadius, Reference));
     }
 
-    Shadow /= float(Samples);
-    return Shadow;
+    return 1.0 - Lit / float(OMNI_SHADOW_SAMPLES);
+#endif
+#else
+    return 0.0;
+#endif
 }
 
+// Projects the fragment into the spot light's perspective map, compared on distance like the cube maps
+// The map is a tile of an atlas, lookups are clamped far enough inside TileBounds that no tap reaches the next tile
+float CalculateSpotShadowFactor(SpotLight InSpot, SPOT_SHADOW_SAMPLER ShadowMap, mat4 LightTransform, float FarPlane, vec4 TileBounds)
+{
+#if ENABLE_OMNI_SHADOWS
+    vec4 LightSpacePosition = LightTransform * vec4(FragmentPosition, 1.0);
+    float CurrentDepth = length(FragmentPosition - InSpot.Base.Position);
+    vec2 TexelSize = 1.0 / textureSize(ShadowMap, 0);
+
+    float Bias = 0.05;
+    float Reference = (CurrentDepth - Bias) / FarPlane;
+
+#if SHADOW_FILTER == SHADOW_FILTER_EVSM
+    vec2 Coords = (LightSpacePosition.xy / LightSpacePosition.w) * 0.5 + 0.5;
+    Coords = clamp(Coords, TileBounds.xy + 0.5 * TexelSize, TileBounds.zw - 0.5 * TexelSize);
+    return CalculateMomentShadow(texture(ShadowMap, Coords).rg, CurrentDepth / FarPlane);
+#elif SHADOW_FILTER == SHADOW_FILTER_HARD
+    // Projective lookup, the sampler divides xy & the reference by w, so the reference & the bounds are pre-multiplied
+    vec4 Projected = vec4((LightSpacePosition.xy + LightSpacePosition.w) * 0.5, Reference * LightSpacePosition.w, LightSpacePosition.w);
+    Projected.xy = clamp(Projected.xy, (TileBounds.xy + 0.5 * TexelSize) * Projected.w, (TileBounds.zw - 0.5 * TexelSize) * Projected.w);
+    return 1.0 - textureProj(ShadowMap, Projected);
+#else
+    // The grid reaches a texel out & each tap's bilinear compare half a texel further
+    vec2 Coords = (LightSpacePosition.xy / LightSpacePosition.w) * 0.5 + 0.5;
+    Coords = clamp(Coords, TileBounds.xy + 1.5 * TexelSize, TileBounds.zw - 1.5 * TexelSize);
+    return SampleShadowGrid(ShadowMap, vec3(Coords, Reference));
+#endif
+#else
+    return 0.0;
+#endif
+}
 
 vec4 CalculateDirectionalLight()
 {
@@ -170,14 +300,13 @@ vec4 CalculateDirectionalLight()
     return CalculateLightByDirection(MyDirectionalLight.Base, MyDirectionalLight.Direction, ShadowFactor);
 }
 
-vec4 CalculatePointLight(PointLight InLight, int ShadowIndex)
+// The shadow factor comes in from the caller, point & spot lights sample different kinds of map
+vec4 CalculatePointLight(PointLight InLight, float ShadowFactor)
 {
         vec3 Direction = FragmentPosition - InLight.Position;
         float Distance = length(Direction);
         Direction = normalize(Direction);
 
-        float ShadowFactor = CalculateOmniShadowFactor(InLight, ShadowIndex);
-
         vec4 PointColor = CalculateLightByDirection(InLight.Base, Direction, ShadowFactor);
 
         // ax^2 + bx + c  (Where Distance == x)
@@ -188,14 +317,16 @@ vec4 CalculatePointLight(PointLight InLight, int ShadowIndex)
         return (PointColor / Attenuation);
 }
 
-vec4 CalculateSpotLight(SpotLight InSpot, int ShadowIndex)
+vec4 CalculateSpotLight(SpotLight InSpot, SPOT_SHADOW_SAMPLER ShadowMap, mat4 LightTransform, float FarPlane, vec4 TileBounds)
 {
     vec3 RayDirection = normalize(FragmentPosition - InSpot.Base.Position);
     float SpotFactor = dot(RayDirection, InSpot.Direction);
 
+    // Outside the cone the shadow map isn't sampled at all
     if(SpotFactor > InSpot.Edge)
     {
-        vec4 SpotColor = CalculatePointLight(InSpot.Base, ShadowIndex);
+        float ShadowFactor = CalculateSpotShadowFactor(InSpot, ShadowMap, LightTransform, FarPlane, TileBounds);
+        vec4 SpotColor = CalculatePointLight(InSpot.Base, ShadowFactor);
 
         return SpotColor * (1.0f - (1.0f - SpotFactor)*(1.0f / (1.0f - InSpot.Edge)));
     }
@@ -205,13 +336,22 @@ vec4 CalculateSpotLight(SpotLight InSpot, int ShadowIndex)
     }
 }
 
+// One term per light, so every permutation is fully unrolled with constant shadow map indices
+#define POINT_LIGHT_TERM(i) CalculatePointLight(MyPointLights[i], CalculateOmniShadowFactor(MyPointLights[i], OmniShadowMaps[i].ShadowMapCube, OmniShadowMaps[i].FarPlane))
+#define SPOT_LIGHT_TERM(i) CalculateSpotLight(MySpotLights[i], SpotShadowMaps[i].ShadowMap, SpotShadowMaps[i].LightTransform, SpotShadowMaps[i].FarPlane, SpotShadowMaps[i].TileBounds)
+
 vec4 CalculatePointLights()
 {
     vec4 TotalColor = vec4(0,0,0,0);
-    for(int i = 0; i < PointLightCount; i++)
-    {
-        TotalColor += CalculatePointLight(MyPointLights[i], i);
-    }
+#if POINT_LIGHT_COUNT > 0
+    TotalColor += POINT_LIGHT_TERM(0);
+#endif
+#if POINT_LIGHT_COUNT > 1
+    TotalColor += POINT_LIGHT_TERM(1);
+#endif
+#if POINT_LIGHT_COUNT > 2
+    TotalColor += POINT_LIGHT_TERM(2);
+#endif
 
     return TotalColor;
 }
@@ -219,10 +359,15 @@ vec4 CalculatePointLights()
 vec4 CalculateSpotLights()
 {
     vec4 TotalColor = vec4(0, 0, 0, 0);
-    for(int i = 0; i < SpotLightCount; i++)
-    {
-        TotalColor += CalculateSpotLight(MySpotLights[i], i + PointLightCount);
-    }
+#if SPOT_LIGHT_COUNT > 0
+    TotalColor += SPOT_LIGHT_TERM(0);
+#endif
+#if SPOT_LIGHT_COUNT > 1
+    TotalColor += SPOT_LIGHT_TERM(1);
+#endif
+#if SPOT_LIGHT_COUNT > 2
+    TotalColor += SPOT_LIGHT_TERM(2);
+#endif
 
     return TotalColor;
 }
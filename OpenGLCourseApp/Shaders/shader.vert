@@ -10,9 +10,12 @@ out vec3 Normal;
 out vec3 FragmentPosition;
 out vec4 DirectionalLightSpacePosition;
 
+#include "camera.glsl"
+
+// The depth pre-pass computes the same position, GL_EQUAL needs both to match exactly
+invariant gl_Position;
+
 uniform mat4 Model;
-uniform mat4 View;
-uniform mat4 Projection;
 uniform mat4 DirectionalLightTransform;
 
 void main()
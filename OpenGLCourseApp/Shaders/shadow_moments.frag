@@ -0,0 +1,62 @@
+#version 330
+
+// One axis of the separable box blur over exponential shadow moments
+// MOMENTS_FROM_DEPTH: the source is a depth map, each tap is warped into moments before blurring
+// MOMENTS_CUBE: source & target are cube maps, the geometry shader picks the face
+
+out vec4 Moments;
+
+uniform vec2 BlurAxis;				// (1, 0) or (0, 1)
+uniform vec2 TargetOffset;			// Corner of the target rectangle, e.g. a tile of an atlas
+uniform vec2 TargetSize;			// May be smaller than the source, taps are in target pixels
+uniform int BlurRadius;				// Taps either side of the center
+uniform float ShadowExponent;
+
+#ifdef MOMENTS_CUBE
+uniform samplerCube Source;
+flat in int Face;
+
+// Direction through a face texel, following the GL cube map face orientation
+// Taps past the face edge point into the neighbouring face, so the blur crosses seams correctly
+vec3 CubeDirection(vec2 UV)
+{
+	vec2 P = UV * 2.0 - 1.0;
+	if(Face == 0) return vec3( 1.0, -P.y, -P.x);
+	if(Face == 1) return vec3(-1.0, -P.y,  P.x);
+	if(Face == 2) return vec3( P.x,  1.0,  P.y);
+	if(Face == 3) return vec3( P.x, -1.0, -P.y);
+	if(Face == 4) return vec3( P.x, -P.y,  1.0);
+	return vec3(-P.x, -P.y, -1.0);
+}
+#else
+uniform sampler2D Source;
+#endif
+
+vec2 FetchMoments(vec2 PixelCoordinates)
+{
+	vec2 UV = (PixelCoordinates - TargetOffset) / TargetSize;
+#ifdef MOMENTS_CUBE
+	vec4 Texel = texture(Source, CubeDirection(UV));
+#else
+	vec4 Texel = texture(Source, UV);
+#endif
+
+#ifdef MOMENTS_FROM_DEPTH
+	// Depth is 0 - 1 in both kinds of shadow map, exp(Exponent) squared has to stay inside a float
+	float Warped = exp(ShadowExponent * Texel.r);
+	return vec2(Warped, Warped * Warped);
+#else
+	return Texel.rg;
+#endif
+}
+
+void main()
+{
+	vec2 Sum = vec2(0.0);
+	for(int i = -BlurRadius; i <= BlurRadius; i++)
+	{
+		Sum += FetchMoments(gl_FragCoord.xy + BlurAxis * float(i));
+	}
+
+	Moments = vec4(Sum / float(2 * BlurRadius + 1), 0.0, 1.0);
+}
@@ -0,0 +1,30 @@
+#version 330
+
+in vec2 TextureCoordinates;
+
+out vec4 Color;
+
+uniform sampler2D SceneColor;
+uniform vec2 SourceScale;		// Part of SceneColor the main pass drew this frame
+uniform vec2 TexelSize;			// One texel of SceneColor
+uniform float Sharpness;
+
+void main()
+{
+	// Keep the bilinear taps inside the drawn part, the rest of the target holds older, larger frames
+	vec2 MaxCoordinates = SourceScale - TexelSize * 0.5;
+	vec2 UV = min(TextureCoordinates * SourceScale, MaxCoordinates);
+
+	vec3 Center = texture(SceneColor, UV).rgb;
+	vec3 North = texture(SceneColor, min(UV + vec2(0.0, TexelSize.y), MaxCoordinates)).rgb;
+	vec3 South = texture(SceneColor, UV - vec2(0.0, TexelSize.y)).rgb;
+	vec3 East = texture(SceneColor, min(UV + vec2(TexelSize.x, 0.0), MaxCoordinates)).rgb;
+	vec3 West = texture(SceneColor, UV - vec2(TexelSize.x, 0.0)).rgb;
+
+	// Unsharp mask against the neighbours, limited to their range so it can't overshoot into halos
+	vec3 Sharpened = Center + (4.0 * Center - North - South - East - West) * 0.25 * Sharpness;
+	vec3 MinColor = min(Center, min(min(North, South), min(East, West)));
+	vec3 MaxColor = max(Center, max(max(North, South), max(East, West)));
+
+	Color = vec4(clamp(Sharpened, MinColor, MaxColor), 1.0);
+}
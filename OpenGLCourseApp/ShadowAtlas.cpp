@@ -0,0 +1,209 @@
+#include <string.h>
+#include <algorithm>
+
+#include "ShadowAtlas.h"
+
+ShadowAtlas::ShadowAtlas()
+{
+	Size = 0;
+	MinTileSize = 0;
+	UsedTexels = 0;
+	Desc = { GL_TEXTURE_2D, 0, 0, GL_NONE, 0 };
+	Texture = 0;
+}
+
+void ShadowAtlas::Reset(GLsizei NewSize, GLsizei NewMinTileSize)
+{
+	Size = NewSize;
+	MinTileSize = NewMinTileSize;
+	UsedTexels = 0;
+
+	size_t Levels = 1;
+	while ((Size >> Levels) >= MinTileSize && (Size >> Levels) > 0)
+	{
+		Levels++;
+	}
+
+	FreeTiles.assign(Levels, std::vector<glm::ivec2>());
+	FreeTiles[0].push_back(glm::ivec2(0, 0));
+}
+
+bool ShadowAtlas::Allocate(GLsizei RequestedSize, ShadowTile* OutTile)
+{
+	if (FreeTiles.empty() || RequestedSize <= 0 || RequestedSize > Size)
+	{
+		return false;
+	}
+
+	size_t Level = GetAllocationLevel(RequestedSize);
+
+	// Closest level above with a free tile
+	int Source = (int)Level;
+	while (Source >= 0 && FreeTiles[Source].empty())
+	{
+		Source--;
+	}
+	if (Source < 0)
+	{
+		return false;
+	}
+
+	glm::ivec2 Origin = FreeTiles[Source].back();
+	FreeTiles[Source].pop_back();
+
+	// Split down to the wanted level, keeping the first child each time & freeing the other three
+	for (size_t Split = Source + 1; Split <= Level; Split++)
+	{
+		GLint Half = GetTileSize(Split);
+		FreeTiles[Split].push_back(Origin + glm::ivec2(Half, 0));
+		FreeTiles[Split].push_back(Origin + glm::ivec2(0, Half));
+		FreeTiles[Split].push_back(Origin + glm::ivec2(Half, Half));
+	}
+
+	*OutTile = { Origin.x, Origin.y, GetTileSize(Level) };
+	UsedTexels += (size_t)OutTile->Size * OutTile->Size;
+	return true;
+}
+
+void ShadowAtlas::Release(const ShadowTile& Tile)
+{
+	if (Tile.Size == 0 || FreeTiles.empty())
+	{
+		return;
+	}
+
+	UsedTexels -= (size_t)Tile.Size * Tile.Size;
+	size_t Level = GetLevel(Tile.Size);
+	glm::ivec2 Origin(Tile.X, Tile.Y);
+
+	// Merge upwards while the other three children of the parent are free too
+	while (Level > 0)
+	{
+		GLint Half = GetTileSize(Level);
+		GLint ParentSize = GetTileSize(Level - 1);
+		glm::ivec2 Parent = (Origin / ParentSize) * ParentSize;
+		glm::ivec2 Children[4] = { Parent, Parent + glm::ivec2(Half, 0), Parent + glm::ivec2(0, Half), Parent + glm::ivec2(Half, Half) };
+
+		bool bSiblingsFree = true;
+		for (int i = 0; i < 4 && bSiblingsFree; i++)
+		{
+			bSiblingsFree = Children[i] == Origin ||
+				std::find(FreeTiles[Level].begin(), FreeTiles[Level].end(), Children[i]) != FreeTiles[Level].end();
+		}
+		if (!bSiblingsFree)
+		{
+			break;
+		}
+
+		for (int i = 0; i < 4; i++)
+		{
+			if (Children[i] != Origin)
+			{
+				RemoveFree(Level, Children[i]);
+			}
+		}
+		Origin = Parent;
+		Level--;
+	}
+
+	FreeTiles[Level].push_back(Origin);
+}
+
+GLuint ShadowAtlas::AcquireTexture(const RenderTargetDesc& NewDesc, bool* bOutReallocated)
+{
+	*bOutReallocated = false;
+	if (Texture && memcmp(&Desc, &NewDesc, sizeof(RenderTargetDesc)) == 0)
+	{
+		return Texture;
+	}
+
+	if (Texture)
+	{
+		RenderGraph::DeleteTexture(Desc, Texture);
+	}
+	Desc = NewDesc;
+	Texture = RenderGraph::CreateTexture(Desc);
+	*bOutReallocated = true;
+	return Texture;
+}
+
+glm::mat4 ShadowAtlas::CalculateTileTransform(const ShadowTile& Tile) const
+{
+	// Shaders map clip xy / w to 0 - 1 with * 0.5 + 0.5, scaling & offsetting clip xy lands that in the tile instead
+	GLfloat Scale = (GLfloat)Tile.Size / Size;
+	glm::vec2 Offset = glm::vec2((GLfloat)Tile.X, (GLfloat)Tile.Y) / (GLfloat)Size;
+
+	glm::mat4 Transform(1.0f);
+	Transform[0][0] = Scale;
+	Transform[1][1] = Scale;
+	Transform[3][0] = Scale + 2.0f * Offset.x - 1.0f;
+	Transform[3][1] = Scale + 2.0f * Offset.y - 1.0f;
+	return Transform;
+}
+
+glm::vec4 ShadowAtlas::CalculateTileBounds(const ShadowTile& Tile) const
+{
+	if (Size <= 0)
+	{
+		return glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	}
+	return glm::vec4((GLfloat)Tile.X, (GLfloat)Tile.Y, (GLfloat)(Tile.X + Tile.Size), (GLfloat)(Tile.Y + Tile.Size)) / (GLfloat)Size;
+}
+
+float ShadowAtlas::GetUsage() const
+{
+	return Size > 0 ? (float)UsedTexels / ((float)Size * Size) : 0.0f;
+}
+
+size_t ShadowAtlas::GetLevel(GLsizei TileSize) const
+{
+	size_t Level = 0;
+	while (Level + 1 < FreeTiles.size() && GetTileSize(Level) > TileSize)
+	{
+		Level++;
+	}
+	return Level;
+}
+
+size_t ShadowAtlas::GetAllocationLevel(GLsizei RequestedSize) const
+{
+	// Deepest level whose tiles are still big enough
+	size_t Level = 0;
+	while (Level + 1 < FreeTiles.size() && GetTileSize(Level + 1) >= RequestedSize)
+	{
+		Level++;
+	}
+	return Level;
+}
+
+bool ShadowAtlas::RemoveFree(size_t Level, const glm::ivec2& Origin)
+{
+	std::vector<glm::ivec2>& Free = FreeTiles[Level];
+	std::vector<glm::ivec2>::iterator Found = std::find(Free.begin(), Free.end(), Origin);
+	if (Found == Free.end())
+	{
+		return false;
+	}
+
+	*Found = Free.back();
+	Free.pop_back();
+	return true;
+}
+
+void ShadowAtlas::Clear()
+{
+	if (Texture)
+	{
+		RenderGraph::DeleteTexture(Desc, Texture);
+		Texture = 0;
+	}
+	Desc = { GL_TEXTURE_2D, 0, 0, GL_NONE, 0 };
+
+	FreeTiles.clear();
+	Size = 0;
+	UsedTexels = 0;
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <GLM/glm.hpp>
+
+#include "RenderGraph.h"
+
+// Square region of the atlas in texels, Size 0 is no tile
+struct ShadowTile
+{
+	GLint X;
+	GLint Y;
+	GLsizei Size;
+};
+
+const ShadowTile NO_SHADOW_TILE = { 0, 0, 0 };
+
+// One square shadow texture shared by many lights, each drawing into a tile of it
+// Tiles come from a quadtree: every level halves the side of the one above, a tile is split into its
+// four children to serve a smaller request & four free siblings merge back into their parent.
+// Tiles are aligned to their own size, so a mipmapped atlas keeps each tile's mips inside it.
+// The memory is fixed by the atlas size, however many lights share it.
+class ShadowAtlas
+{
+public:
+	ShadowAtlas();
+
+	// Empties the allocator, every tile handed out before is gone
+	// NewSize & NewMinTileSize are powers of two
+	void Reset(GLsizei NewSize, GLsizei NewMinTileSize);
+
+	// A free tile at least RequestedSize texels a side, rounded up to a quadtree level, false when none is free
+	bool Allocate(GLsizei RequestedSize, ShadowTile* OutTile);
+	void Release(const ShadowTile& Tile);
+
+	// Side of the tile Allocate hands out for RequestedSize
+	GLsizei CalculateTileSize(GLsizei RequestedSize) const { return FreeTiles.empty() ? 0 : GetTileSize(GetAllocationLevel(RequestedSize)); }
+
+	// Backing texture, reallocated when NewDesc differs from the last one, which loses what every tile held
+	GLuint AcquireTexture(const RenderTargetDesc& NewDesc, bool* bOutReallocated);
+	GLuint GetTexture() const { return Texture; }
+
+	// Maps a projection's clip space onto the tile, a shader sampling the whole map samples the tile instead
+	glm::mat4 CalculateTileTransform(const ShadowTile& Tile) const;
+
+	// The tile in texture coordinates, min xy & max xy
+	glm::vec4 CalculateTileBounds(const ShadowTile& Tile) const;
+
+	GLsizei GetSize() const { return Size; }
+
+	// Fraction of the atlas handed out as tiles
+	float GetUsage() const;
+
+	void Clear();
+
+	~ShadowAtlas();
+
+private:
+	GLsizei Size;
+	GLsizei MinTileSize;
+	size_t UsedTexels;
+
+	// Origins of the free tiles, per level, level 0 is the whole atlas
+	std::vector<std::vector<glm::ivec2>> FreeTiles;
+
+	RenderTargetDesc Desc;
+	GLuint Texture;
+
+	GLsizei GetTileSize(size_t Level) const { return Size >> Level; }
+	size_t GetLevel(GLsizei TileSize) const;
+	size_t GetAllocationLevel(GLsizei RequestedSize) const;
+	bool RemoveFree(size_t Level, const glm::ivec2& Origin);
+};
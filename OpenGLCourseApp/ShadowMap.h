@@ -6,21 +6,23 @@
 
 
 
+// Describes a light's shadow map, the depth texture itself is a transient render graph target
+// handed over with SetTexture() each frame before the lit pass reads it.
 class ShadowMap
 {
 public:
 	ShadowMap();
 
 	virtual bool Initialize(unsigned int Width, unsigned int Height);
-	virtual void Write();
 	virtual void Read(GLenum TextureUnit);
+	virtual GLenum GetTextureTarget() { return GL_TEXTURE_2D; }
+	void SetTexture(GLuint NewTexture) { MyShadowMap = NewTexture; }
 	GLuint GetShadowWidth() { return ShadowWidth; }
 	GLuint GetShadowHeight() { return ShadowHeight; }
 
-	~ShadowMap();
+	virtual ~ShadowMap();
 
 protected:
-	GLuint FrameBufferObject;
 	GLuint MyShadowMap;
 	GLuint ShadowWidth;
 	GLuint ShadowHeight;
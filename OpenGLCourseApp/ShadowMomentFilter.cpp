@@ -0,0 +1,157 @@
+#include <algorithm>
+
+#include "ShadowMomentFilter.h"
+
+// Source is read from this unit, 0 is left for defaults
+static const GLuint SourceTextureUnit = 1;
+
+ShadowMomentFilter::ShadowMomentFilter()
+{
+	Settings = { 40.0f, 0.2f, 0.00002f, 2, 2 };
+	for (int bCube = 0; bCube < 2; bCube++)
+	{
+		for (int bFromDepth = 0; bFromDepth < 2; bFromDepth++)
+		{
+			BlurHandles[bCube][bFromDepth] = { 0, INVALID_UNIFORM, INVALID_UNIFORM, INVALID_UNIFORM, INVALID_UNIFORM, INVALID_UNIFORM, INVALID_UNIFORM };
+		}
+	}
+	LitHandles = { 0, INVALID_UNIFORM, INVALID_UNIFORM, INVALID_UNIFORM };
+	SourceSampler = 0;
+	EmptyVAO = 0;
+}
+
+void ShadowMomentFilter::Initialize(AssetManager* Assets, const ShadowMomentSettings& NewSettings)
+{
+	Settings = NewSettings;
+
+	for (int bCube = 0; bCube < 2; bCube++)
+	{
+		for (int bFromDepth = 0; bFromDepth < 2; bFromDepth++)
+		{
+			std::string Defines;
+			Defines += bCube ? "#define MOMENTS_CUBE\n" : "";
+			Defines += bFromDepth ? "#define MOMENTS_FROM_DEPTH\n" : "";
+			BlurShaders[bCube][bFromDepth] = Assets->LoadShader("Shaders/fullscreen.vert", "Shaders/shadow_moments.frag",
+				bCube ? "Shaders/shadow_moments.geom" : "", Defines);
+		}
+	}
+
+	// Depth has to be warped per texel before any filtering, & shadow maps are set up for hardware comparison
+	glGenSamplers(1, &SourceSampler);
+	glSamplerParameteri(SourceSampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glSamplerParameteri(SourceSampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glSamplerParameteri(SourceSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glSamplerParameteri(SourceSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glSamplerParameteri(SourceSampler, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glSamplerParameteri(SourceSampler, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+
+	glGenVertexArrays(1, &EmptyVAO);
+}
+
+void ShadowMomentFilter::Blur(GLuint Source, bool bCube, bool bFromDepth, bool bVertical, GLint TargetX, GLint TargetY, GLsizei TargetWidth, GLsizei TargetHeight)
+{
+	Shader* BlurShader = BlurShaders[bCube][bFromDepth].get();
+	BlurShader->UseShader();
+
+	// A hot reload relinks the program, the old handles may point at other uniforms
+	BlurUniforms& Handles = BlurHandles[bCube][bFromDepth];
+	if (Handles.Generation != BlurShader->GetProgramGeneration())
+	{
+		Handles.Source = BlurShader->FindUniform("Source");
+		Handles.BlurAxis = BlurShader->FindUniform("BlurAxis");
+		Handles.TargetOffset = BlurShader->FindUniform("TargetOffset");
+		Handles.TargetSize = BlurShader->FindUniform("TargetSize");
+		Handles.BlurRadius = BlurShader->FindUniform("BlurRadius");
+		Handles.ShadowExponent = BlurShader->FindUniform("ShadowExponent");
+		Handles.Generation = BlurShader->GetProgramGeneration();
+	}
+
+	BlurShader->SetUniform(Handles.Source, (GLint)SourceTextureUnit);
+	BlurShader->SetUniform(Handles.BlurAxis, bVertical ? glm::vec2(0.0f, 1.0f) : glm::vec2(1.0f, 0.0f));
+	BlurShader->SetUniform(Handles.TargetOffset, glm::vec2((GLfloat)TargetX, (GLfloat)TargetY));
+	BlurShader->SetUniform(Handles.TargetSize, glm::vec2((GLfloat)TargetWidth, (GLfloat)TargetHeight));
+	BlurShader->SetUniform(Handles.BlurRadius, Settings.BlurRadius);
+	BlurShader->SetUniform(Handles.ShadowExponent, Settings.Exponent);
+
+	GLenum Target = bCube ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+	glActiveTexture(GL_TEXTURE0 + SourceTextureUnit);
+	glBindTexture(Target, Source);
+	glBindSampler(SourceTextureUnit, SourceSampler);
+
+	glViewport(TargetX, TargetY, TargetWidth, TargetHeight);
+	glDisable(GL_DEPTH_TEST);
+	glBindVertexArray(EmptyVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
+
+	glBindSampler(SourceTextureUnit, 0);
+	glBindTexture(Target, 0);
+}
+
+GLsizei ShadowMomentFilter::ScaleSize(GLsizei DepthSize) const
+{
+	return std::max(DepthSize / std::max(Settings.ResolutionDivisor, 1), 1);
+}
+
+void ShadowMomentFilter::GenerateMips(GLenum Target, GLuint Moments)
+{
+	glBindTexture(Target, Moments);
+	glGenerateMipmap(Target);
+	glBindTexture(Target, 0);
+}
+
+void ShadowMomentFilter::SetLightingUniforms(Shader* LitShader)
+{
+	if (LitHandles.Generation != LitShader->GetProgramGeneration())
+	{
+		LitHandles.ShadowExponent = LitShader->FindUniform("ShadowExponent");
+		LitHandles.LightBleedReduction = LitShader->FindUniform("LightBleedReduction");
+		LitHandles.VarianceBias = LitShader->FindUniform("VarianceBias");
+		LitHandles.Generation = LitShader->GetProgramGeneration();
+	}
+
+	LitShader->SetUniform(LitHandles.ShadowExponent, Settings.Exponent);
+	LitShader->SetUniform(LitHandles.LightBleedReduction, Settings.LightBleedReduction);
+	LitShader->SetUniform(LitHandles.VarianceBias, Settings.VarianceBias);
+}
+
+void ShadowMomentFilter::GetShaders(std::vector<Shader*>* OutShaders)
+{
+	for (int bCube = 0; bCube < 2; bCube++)
+	{
+		for (int bFromDepth = 0; bFromDepth < 2; bFromDepth++)
+		{
+			if (BlurShaders[bCube][bFromDepth])
+			{
+				OutShaders->push_back(BlurShaders[bCube][bFromDepth].get());
+			}
+		}
+	}
+}
+
+void ShadowMomentFilter::Clear()
+{
+	if (SourceSampler != 0)
+	{
+		glDeleteSamplers(1, &SourceSampler);
+		SourceSampler = 0;
+	}
+	if (EmptyVAO != 0)
+	{
+		glDeleteVertexArrays(1, &EmptyVAO);
+		EmptyVAO = 0;
+	}
+
+	for (int bCube = 0; bCube < 2; bCube++)
+	{
+		for (int bFromDepth = 0; bFromDepth < 2; bFromDepth++)
+		{
+			BlurShaders[bCube][bFromDepth].reset();
+		}
+	}
+}
+
+ShadowMomentFilter::~ShadowMomentFilter()
+{
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "Shader.h"
+#include "AssetManager.h"
+
+// Tunables shared by the moment passes & the lighting that reads them
+struct ShadowMomentSettings
+{
+	GLfloat Exponent;				// Warp strength, higher cuts light bleeding but must keep exp(2 * Exponent) finite
+	GLfloat LightBleedReduction;	// 0 - 1, how much of the Chebyshev bound's tail is clipped away
+	GLfloat VarianceBias;			// Minimum variance in depth units, hides acne on flat receivers
+	GLint BlurRadius;				// Taps either side, per axis
+	GLint ResolutionDivisor;		// Moments maps are this much smaller per axis than the depth maps they come from
+};
+
+// Exponential variance shadow maps (EVSM)
+// Shadow passes still render plain depth, then per shadow map two fullscreen passes warp it into moments
+// (e^cd, e^2cd) & box blur them, one axis each, & the result is mipmapped. Lighting then takes a single
+// trilinear fetch per light & applies Chebyshev's inequality, instead of a PCF kernel.
+// Cube maps are blurred per face, with taps past an edge continuing on the neighbouring face.
+class ShadowMomentFilter
+{
+public:
+	ShadowMomentFilter();
+
+	void Initialize(AssetManager* Assets, const ShadowMomentSettings& NewSettings);
+
+	// Draws one blur axis into the TargetWidth x TargetHeight rectangle at TargetX, TargetY of the bound framebuffer
+	// (the graph binds it), e.g. a tile of an atlas. Source covers just that rectangle.
+	// bFromDepth: Source is a depth shadow map, otherwise moments from the first axis
+	void Blur(GLuint Source, bool bCube, bool bFromDepth, bool bVertical, GLint TargetX, GLint TargetY, GLsizei TargetWidth, GLsizei TargetHeight);
+
+	// Moments map size for a depth map size
+	GLsizei ScaleSize(GLsizei DepthSize) const;
+
+	// Fills the lower mips of a finished moments map
+	void GenerateMips(GLenum Target, GLuint Moments);
+
+	// Uniforms the EVSM lighting permutation needs, the shader must be in use
+	void SetLightingUniforms(Shader* LitShader);
+
+	const ShadowMomentSettings& GetSettings() const { return Settings; }
+	void SetSettings(const ShadowMomentSettings& NewSettings) { Settings = NewSettings; }
+
+	void GetShaders(std::vector<Shader*>* OutShaders);
+
+	void Clear();
+
+	~ShadowMomentFilter();
+
+private:
+	ShadowMomentSettings Settings;
+
+	// Handles of one program, looked up again only when its generation changes
+	struct BlurUniforms
+	{
+		unsigned int Generation;
+		UniformHandle Source;
+		UniformHandle BlurAxis;
+		UniformHandle TargetOffset;
+		UniformHandle TargetSize;
+		UniformHandle BlurRadius;
+		UniformHandle ShadowExponent;
+	};
+
+	struct LightingUniforms
+	{
+		unsigned int Generation;
+		UniformHandle ShadowExponent;
+		UniformHandle LightBleedReduction;
+		UniformHandle VarianceBias;
+	};
+
+	// Indexed [bCube][bFromDepth]
+	std::shared_ptr<Shader> BlurShaders[2][2];
+	BlurUniforms BlurHandles[2][2];
+
+	// Of the last lighting permutation set up, generations are unique so a switch of permutation is noticed too
+	LightingUniforms LitHandles;
+
+	// Reads sources unfiltered & without depth comparison, whatever the textures themselves are set to
+	GLuint SourceSampler;
+	GLuint EmptyVAO;
+};
@@ -0,0 +1,556 @@
+#include <float.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
+#include "ShadowScheduler.h"
+#include "FramePrep.h"
+#include "GPUMemory.h"
+#include "Profiler.h"
+
+// A light has to get this much more important to leave the fallback than it took to enter it
+static const GLfloat FallbackHysteresis = 1.5f;
+
+// Priority multiplier for a light whose map no longer matches where it is
+static const GLfloat MovedPriorityScale = 4.0f;
+
+// 2D then cube, matching the fallback arrays' bCube index
+static const RenderTargetDesc FallbackDepthDescs[2] = { { GL_TEXTURE_2D, 1, 1, GL_DEPTH_COMPONENT, 0 }, { GL_TEXTURE_CUBE_MAP, 1, 1, GL_DEPTH_COMPONENT, 0 } };
+static const RenderTargetDesc FallbackMomentsDescs[2] = { { GL_TEXTURE_2D, 1, 1, GL_RG32F, 0 }, { GL_TEXTURE_CUBE_MAP, 1, 1, GL_RG32F, 0 } };
+
+ShadowScheduler::ShadowScheduler()
+{
+	Settings = { 2, 1.5, 0.01f, 0.02f, 2048, 128, 4096 };
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		StateCounts[i] = 0;
+	}
+	bAtlasRefreshing = false;
+
+	for (unsigned int i = 0; i < 2; i++)
+	{
+		FallbackDepth[i] = 0;
+		FallbackMoments[i] = 0;
+	}
+
+	FrameFaces = 0;
+}
+
+void ShadowScheduler::Initialize(const ShadowSchedulerSettings& NewSettings)
+{
+	Settings = NewSettings;
+
+	for (unsigned int i = 0; i < 2; i++)
+	{
+		FallbackDepth[i] = CreateFallback(FallbackDepthDescs[i]);
+		FallbackMoments[i] = CreateFallback(FallbackMomentsDescs[i]);
+	}
+
+	RefreshTimer.Initialize();
+}
+
+void ShadowScheduler::Schedule(const std::vector<PointLight*>& Lights, const glm::mat4* LightMatrices,
+							   const glm::mat4& View, const glm::mat4& Projection, const glm::vec3& EyePosition)
+{
+	PROFILE_SCOPE("ScheduleShadows");
+
+	RefreshTimer.Update();
+
+	while (Entries.size() > Lights.size())
+	{
+		ReleaseMap(&Entries.back());
+		Entries.pop_back();
+	}
+	while (Entries.size() < Lights.size())
+	{
+		Entries.push_back({ SHADOW_STATE_DISABLED, 0.0f, 0.0f, 0, false, true, glm::mat4(0.0f), 0, 0, { GL_TEXTURE_CUBE_MAP, 0, 0, GL_NONE, 0 }, 0, NO_SHADOW_TILE });
+	}
+
+	// The atlas shrinks with the other shadow maps while over the memory budget, its old tiles are gone
+	GLsizei AtlasSize = GPUMemory::ScaleShadowSize(Settings.AtlasSize);
+	if (AtlasSize != Atlas.GetSize())
+	{
+		Atlas.Reset(AtlasSize, Settings.MinTileSize);
+		for (size_t i = 0; i < Entries.size(); i++)
+		{
+			if (Entries[i].Tile.Size > 0)
+			{
+				Entries[i].Tile = NO_SHADOW_TILE;
+				Entries[i].bValid = false;
+			}
+		}
+	}
+
+	// Score every light, only the ones worth shadowing compete for a refresh
+	Candidates.clear();
+	for (size_t i = 0; i < Lights.size(); i++)
+	{
+		ShadowEntry& Entry = Entries[i];
+		PointLight* Light = Lights[i];
+		Entry.bCube = Light->GetShadowMap()->GetTextureTarget() == GL_TEXTURE_CUBE_MAP;
+
+		if (!Light->IsEnabled())
+		{
+			Entry.State = SHADOW_STATE_DISABLED;
+			ReleaseMap(&Entry);
+			continue;
+		}
+
+		glm::vec3 Color = Light->GetColor();
+		GLfloat Intensity = Light->GetDiffuseIntensity() * glm::max(Color.x, glm::max(Color.y, Color.z));
+		GLfloat Range = Light->CalculateRange(Settings.MinIntensity);
+		GLfloat Distance = glm::length(Light->GetPosition() - EyePosition);
+
+		// Of two lights covering the screen alike, the nearer one shows its shadows in more detail
+		GLfloat Coverage = CalculateCoverage(Light->GetPosition(), Range, View, Projection, EyePosition);
+		Entry.Importance = Range > 0.0f ? Coverage * Intensity * Range / (Range + Distance) : 0.0f;
+
+		GLfloat Threshold = IsShadowed(Entry) ? Settings.MinImportance : Settings.MinImportance * FallbackHysteresis;
+		if (Entry.Importance < Threshold)
+		{
+			Entry.State = SHADOW_STATE_FALLBACK;
+			ReleaseMap(&Entry);
+			continue;
+		}
+
+		GLsizei MaxSize = GPUMemory::ScaleShadowSize(Light->GetShadowMap()->GetShadowWidth());
+		MaxSize = Entry.bCube ? MaxSize : std::min(MaxSize, Atlas.GetSize());
+		Entry.Resolution = CalculateResolution(Entry.Resolution, MaxSize, Coverage);
+
+		Entry.State = SHADOW_STATE_CACHED;
+		Candidates.push_back(i);
+	}
+
+	std::sort(Candidates.begin(), Candidates.end(), [this](size_t A, size_t B)
+	{
+		return Entries[A].Importance > Entries[B].Importance;
+	});
+
+	// Point lights shrink their cube maps to the budget, one of a new size is reallocated empty
+	// A spot light finds out when it gets its tile
+	FitCubeBudget();
+	for (size_t c = 0; c < Candidates.size(); c++)
+	{
+		ShadowEntry& Entry = Entries[Candidates[c]];
+		Entry.bValid = Entry.bValid && (!Entry.bCube || Entry.MapResolution == Entry.Resolution);
+	}
+
+	// The most important spot lights get their tiles first, one that finds the atlas full even after
+	// taking the less important lights' tiles goes unshadowed
+	for (size_t c = 0; c < Candidates.size(); c++)
+	{
+		ShadowEntry& Entry = Entries[Candidates[c]];
+		if (!Entry.bCube && !AssignTile(&Entry, c))
+		{
+			Entry.State = SHADOW_STATE_FALLBACK;
+			ReleaseMap(&Entry);
+		}
+	}
+	Candidates.erase(std::remove_if(Candidates.begin(), Candidates.end(), [this](size_t Index)
+	{
+		return Entries[Index].State == SHADOW_STATE_FALLBACK;
+	}), Candidates.end());
+
+	// A map that was never drawn goes first, otherwise waiting & moving push a light up the queue
+	for (size_t c = 0; c < Candidates.size(); c++)
+	{
+		size_t Index = Candidates[c];
+		ShadowEntry& Entry = Entries[Index];
+		bool bMoved = LightMatrices[Index * 6] != Entry.LastMatrix;
+		Entry.Age++;
+		Entry.Priority = Entry.bValid ? Entry.Importance * (1.0f + Entry.Age) * (bMoved ? MovedPriorityScale : 1.0f) : FLT_MAX;
+	}
+
+	std::sort(Candidates.begin(), Candidates.end(), [this](size_t A, size_t B)
+	{
+		return Entries[A].Priority > Entries[B].Priority;
+	});
+
+	// Refresh in priority order while the count & the predicted GPU time allow
+	double Spent = 0.0;
+	unsigned int Refreshes = 0;
+	FrameFaces = 0;
+	bAtlasRefreshing = false;
+	for (size_t c = 0; c < Candidates.size() && Refreshes < Settings.MaxRefreshes; c++)
+	{
+		size_t Index = Candidates[c];
+		ShadowEntry& Entry = Entries[Index];
+
+		unsigned int Faces = Entry.bCube ? 6 : 1;
+		double Cost = Faces * GetFaceMilliseconds();
+		if (Refreshes > 0 && Spent + Cost > Settings.BudgetMilliseconds)
+		{
+			continue;
+		}
+
+		Entry.State = SHADOW_STATE_REFRESH;
+		Entry.Age = 0;
+		Entry.bValid = true;
+		Entry.LastMatrix = LightMatrices[Index * 6];
+		Spent += Cost;
+		Refreshes++;
+		FrameFaces += Faces;
+		bAtlasRefreshing = bAtlasRefreshing || !Entry.bCube;
+	}
+
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		StateCounts[i] = 0;
+	}
+	for (size_t i = 0; i < Entries.size(); i++)
+	{
+		StateCounts[Entries[i].State]++;
+	}
+}
+
+GLuint ShadowScheduler::AcquireMap(size_t ShadowIndex, const RenderTargetDesc& Desc)
+{
+	ShadowEntry& Entry = Entries[ShadowIndex];
+	if (Entry.Texture && memcmp(&Entry.Desc, &Desc, sizeof(RenderTargetDesc)) == 0)
+	{
+		return Entry.Texture;
+	}
+
+	ReleaseMap(&Entry);
+	Entry.Desc = Desc;
+	Entry.Texture = RenderGraph::CreateTexture(Desc);
+	Entry.MapResolution = Entry.Resolution;
+
+	// Only valid if it is drawn this frame, the commands for that were recorded already
+	Entry.bValid = Entry.State == SHADOW_STATE_REFRESH;
+	return Entry.Texture;
+}
+
+GLuint ShadowScheduler::AcquireAtlas(const RenderTargetDesc& Desc)
+{
+	bool bReallocated = false;
+	GLuint Texture = Atlas.AcquireTexture(Desc, &bReallocated);
+	if (bReallocated)
+	{
+		// Same as a new cube map, only the tiles drawn this frame hold anything
+		for (size_t i = 0; i < Entries.size(); i++)
+		{
+			if (!Entries[i].bCube)
+			{
+				Entries[i].bValid = Entries[i].State == SHADOW_STATE_REFRESH;
+			}
+		}
+	}
+	return Texture;
+}
+
+GLuint ShadowScheduler::GetTexture(size_t ShadowIndex, bool bMoments) const
+{
+	const ShadowEntry& Entry = Entries[ShadowIndex];
+	if (IsShadowed(Entry))
+	{
+		return Entry.bCube ? Entry.Texture : Atlas.GetTexture();
+	}
+	return bMoments ? FallbackMoments[Entry.bCube] : FallbackDepth[Entry.bCube];
+}
+
+glm::mat4 ShadowScheduler::GetTransform(size_t ShadowIndex) const
+{
+	// Any projection works with the fallback, it's the same everywhere
+	const ShadowEntry& Entry = Entries[ShadowIndex];
+	if (!IsShadowed(Entry))
+	{
+		return glm::mat4(1.0f);
+	}
+	return Entry.bCube ? Entry.LastMatrix : Atlas.CalculateTileTransform(Entry.Tile) * Entry.LastMatrix;
+}
+
+glm::vec4 ShadowScheduler::GetTileBounds(size_t ShadowIndex) const
+{
+	const ShadowEntry& Entry = Entries[ShadowIndex];
+	if (!IsShadowed(Entry) || Entry.bCube)
+	{
+		return glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	}
+	return Atlas.CalculateTileBounds(Entry.Tile);
+}
+
+void ShadowScheduler::BeginRefreshTiming()
+{
+	RefreshTimer.Begin();
+}
+
+void ShadowScheduler::EndRefreshTiming()
+{
+	RefreshTimer.End(FrameFaces);
+}
+
+GLfloat ShadowScheduler::CalculateCoverage(const glm::vec3& Position, GLfloat Range,
+										   const glm::mat4& View, const glm::mat4& Projection, const glm::vec3& EyePosition) const
+{
+	if (Range <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	// From inside its range the light reaches everything around the camera
+	if (glm::length(Position - EyePosition) < Range)
+	{
+		return 1.0f;
+	}
+
+	if (!SphereInFrustum(ExtractFrustum(Projection * View), glm::vec4(Position, Range)))
+	{
+		return 0.0f;
+	}
+
+	// Crossing the camera plane the projection blows up, count it as covering everything
+	glm::vec3 Center = glm::vec3(View * glm::vec4(Position, 1.0f));
+	GLfloat Depth = -Center.z;
+	if (Depth <= Range)
+	{
+		return 1.0f;
+	}
+
+	// Bounding rectangle of the projected sphere, clipped to the screen, as a fraction of it
+	GLfloat ExtentX = Projection[0][0] * Range / (Depth - Range);
+	GLfloat ExtentY = Projection[1][1] * Range / (Depth - Range);
+	GLfloat CenterX = Projection[0][0] * Center.x / Depth;
+	GLfloat CenterY = Projection[1][1] * Center.y / Depth;
+
+	GLfloat Width = glm::min(CenterX + ExtentX, 1.0f) - glm::max(CenterX - ExtentX, -1.0f);
+	GLfloat Height = glm::min(CenterY + ExtentY, 1.0f) - glm::max(CenterY - ExtentY, -1.0f);
+	return glm::clamp(glm::max(Width, 0.0f) * glm::max(Height, 0.0f) / 4.0f, 0.0f, 1.0f);
+}
+
+GLsizei ShadowScheduler::CalculateResolution(GLsizei Current, GLsizei MaxSize, GLfloat Coverage) const
+{
+	// The side follows the light's extent on screen, rounded up to a power of two
+	GLfloat Wanted = MaxSize * glm::sqrt(Coverage);
+	GLsizei Resolution = std::max(std::min(Settings.MinTileSize, MaxSize), 1);
+	while (Resolution < MaxSize && Resolution < Wanted)
+	{
+		Resolution *= 2;
+	}
+	Resolution = std::min(Resolution, MaxSize);
+
+	// Shrink only two classes down, a light on the edge of a class would otherwise be redrawn at every crossing
+	if (Current <= MaxSize && Resolution < Current && Resolution * 4 > Current)
+	{
+		return Current;
+	}
+	return Resolution;
+}
+
+void ShadowScheduler::FitCubeBudget()
+{
+	GLsizei BudgetSize = GPUMemory::ScaleShadowSize(Settings.CubeBudgetSize);
+	size_t Budget = (size_t)BudgetSize * BudgetSize;
+
+	size_t Texels = 0;
+	for (size_t c = 0; c < Candidates.size(); c++)
+	{
+		const ShadowEntry& Entry = Entries[Candidates[c]];
+		Texels += Entry.bCube ? (size_t)6 * Entry.Resolution * Entry.Resolution : 0;
+	}
+
+	// Candidates are sorted by importance, the least important cube maps shrink to the smallest class first
+	for (size_t c = Candidates.size(); c-- > 0 && Texels > Budget;)
+	{
+		ShadowEntry& Entry = Entries[Candidates[c]];
+		while (Entry.bCube && Entry.Resolution > Settings.MinTileSize && Texels > Budget)
+		{
+			Texels -= (size_t)6 * Entry.Resolution * Entry.Resolution;
+			Entry.Resolution /= 2;
+			Texels += (size_t)6 * Entry.Resolution * Entry.Resolution;
+		}
+	}
+
+	// Still over with every one at the smallest class, the least important go unshadowed
+	for (size_t c = Candidates.size(); c-- > 0 && Texels > Budget;)
+	{
+		ShadowEntry& Entry = Entries[Candidates[c]];
+		if (Entry.bCube)
+		{
+			Texels -= (size_t)6 * Entry.Resolution * Entry.Resolution;
+			Entry.State = SHADOW_STATE_FALLBACK;
+			ReleaseMap(&Entry);
+		}
+	}
+}
+
+bool ShadowScheduler::AssignTile(ShadowEntry* Entry, size_t Rank)
+{
+	// The tile is reused as long as the size class holds
+	if (Entry->Tile.Size >= Entry->Resolution && Entry->Tile.Size < Entry->Resolution * 2)
+	{
+		return true;
+	}
+
+	ShadowTile NewTile;
+	if (Atlas.Allocate(Entry->Resolution, &NewTile))
+	{
+		Atlas.Release(Entry->Tile);
+		Entry->Tile = NewTile;
+		Entry->bValid = false;
+		return true;
+	}
+
+	// A light shrinking keeps the tile it has rather than take others' for a smaller one,
+	// one growing keeps it when the more important lights leave no room
+	if (Entry->Tile.Size > Entry->Resolution)
+	{
+		return true;
+	}
+	if (EvictTiles(Rank, Atlas.CalculateTileSize(Entry->Resolution)) && Atlas.Allocate(Entry->Resolution, &NewTile))
+	{
+		Atlas.Release(Entry->Tile);
+		Entry->Tile = NewTile;
+		Entry->bValid = false;
+		return true;
+	}
+	if (Entry->Tile.Size > 0)
+	{
+		return true;
+	}
+
+	// Nothing yet, settle for the biggest smaller tile there is room for
+	for (GLsizei Size = Entry->Resolution / 2; Size >= Settings.MinTileSize; Size /= 2)
+	{
+		if (Atlas.Allocate(Size, &NewTile) || (EvictTiles(Rank, Atlas.CalculateTileSize(Size)) && Atlas.Allocate(Size, &NewTile)))
+		{
+			Entry->Tile = NewTile;
+			Entry->bValid = false;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ShadowScheduler::EvictTiles(size_t Rank, GLsizei Size)
+{
+	// Every tile in the atlas belongs to a candidate, the ones ranked before Rank already have theirs for this frame.
+	// Of the tile sized spots none of those overlap, take the one costing the fewest texels of less important lights.
+	GLsizei AtlasSize = Atlas.GetSize();
+	if (Size <= 0 || Size > AtlasSize)
+	{
+		return false;
+	}
+
+	glm::ivec2 Best(-1, -1);
+	size_t BestTexels = SIZE_MAX;
+	for (GLint Y = 0; Y < AtlasSize; Y += Size)
+	{
+		for (GLint X = 0; X < AtlasSize; X += Size)
+		{
+			size_t Texels = 0;
+			bool bBlocked = false;
+			for (size_t c = 0; c < Candidates.size() && !bBlocked; c++)
+			{
+				const ShadowTile& Tile = Entries[Candidates[c]].Tile;
+				if (Tile.Size > 0 && Tile.X < X + Size && X < Tile.X + Tile.Size && Tile.Y < Y + Size && Y < Tile.Y + Tile.Size)
+				{
+					bBlocked = c < Rank;
+					Texels += (size_t)Tile.Size * Tile.Size;
+				}
+			}
+			if (!bBlocked && Texels < BestTexels)
+			{
+				Best = glm::ivec2(X, Y);
+				BestTexels = Texels;
+			}
+		}
+	}
+	if (Best.x < 0)
+	{
+		return false;
+	}
+
+	// The freed spot merges back into a free tile of Size, the lights that lose theirs try again when their turn comes
+	for (size_t c = Rank; c < Candidates.size(); c++)
+	{
+		ShadowEntry& Entry = Entries[Candidates[c]];
+		const ShadowTile& Tile = Entry.Tile;
+		if (Tile.Size > 0 && Tile.X < Best.x + Size && Best.x < Tile.X + Tile.Size && Tile.Y < Best.y + Size && Best.y < Tile.Y + Tile.Size)
+		{
+			ReleaseMap(&Entry);
+		}
+	}
+	return true;
+}
+
+bool ShadowScheduler::IsShadowed(const ShadowEntry& Entry) const
+{
+	bool bHasMap = Entry.bCube ? Entry.Texture != 0 : Entry.Tile.Size > 0 && Atlas.GetTexture() != 0;
+	return (Entry.State == SHADOW_STATE_REFRESH || Entry.State == SHADOW_STATE_CACHED) && Entry.bValid && bHasMap;
+}
+
+void ShadowScheduler::ReleaseMap(ShadowEntry* Entry)
+{
+	if (Entry->Texture)
+	{
+		RenderGraph::DeleteTexture(Entry->Desc, Entry->Texture);
+		Entry->Texture = 0;
+	}
+	if (Entry->Tile.Size > 0)
+	{
+		Atlas.Release(Entry->Tile);
+		Entry->Tile = NO_SHADOW_TILE;
+	}
+	Entry->bValid = false;
+}
+
+GLuint ShadowScheduler::CreateFallback(const RenderTargetDesc& Desc)
+{
+	bool bDepth = Desc.InternalFormat == GL_DEPTH_COMPONENT;
+	GLuint Texture = RenderGraph::CreateTexture(Desc);
+
+	// A cube map is attached layered, so one clear covers all 6 faces
+	GLuint Framebuffer = 0;
+	glGenFramebuffers(1, &Framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+
+	if (bDepth)
+	{
+		// Nothing is nearer than the far plane, every depth compare passes
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, Texture, 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+		glClearDepth(1.0);
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
+	else
+	{
+		// A first moment beyond any warped depth, Chebyshev's bound is never consulted
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, Texture, 0);
+		glClearColor(3.0e38f, 3.0e38f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &Framebuffer);
+	return Texture;
+}
+
+void ShadowScheduler::Clear()
+{
+	for (size_t i = 0; i < Entries.size(); i++)
+	{
+		ReleaseMap(&Entries[i]);
+	}
+	Entries.clear();
+	Atlas.Clear();
+
+	for (unsigned int i = 0; i < 2; i++)
+	{
+		if (FallbackDepth[i])
+		{
+			RenderGraph::DeleteTexture(FallbackDepthDescs[i], FallbackDepth[i]);
+			RenderGraph::DeleteTexture(FallbackMomentsDescs[i], FallbackMoments[i]);
+			FallbackDepth[i] = 0;
+			FallbackMoments[i] = 0;
+		}
+	}
+
+	RefreshTimer.Clear();
+}
+
+ShadowScheduler::~ShadowScheduler()
+{
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <GLM/glm.hpp>
+
+#include "GPUTimer.h"
+#include "PointLight.h"
+#include "RenderGraph.h"
+#include "ShadowAtlas.h"
+
+// What happens to a light's shadow map this frame
+enum ShadowState
+{
+	SHADOW_STATE_REFRESH = 0,		// Redrawn into its persistent map
+	SHADOW_STATE_CACHED,			// Last refresh is reused
+	SHADOW_STATE_FALLBACK,			// Too dim or small on screen to matter, lit unshadowed
+	SHADOW_STATE_DISABLED			// Switched off, no shadow work at all
+};
+
+struct ShadowSchedulerSettings
+{
+	unsigned int MaxRefreshes;			// Shadow maps redrawn per frame at most
+	double BudgetMilliseconds;			// GPU time the refreshes may take, the most important one always runs
+	GLfloat MinImportance;				// Below this a light falls back to unshadowed
+	GLfloat MinIntensity;				// Light weaker than this doesn't count towards a light's range
+	GLsizei AtlasSize;					// Texels a side of the spot light atlas, a power of two
+	GLsizei MinTileSize;				// Smallest map a light is given & the atlas' smallest tile, a power of two
+	GLsizei CubeBudgetSize;				// Every point light cube map face together fits a square this many texels a side
+};
+
+// Picks which point & spot light shadow maps to redraw each frame
+// Every light is scored by how much of the screen its range covers, its distance & its intensity.
+// The highest priority maps are redrawn, up to MaxRefreshes & the GPU time budget measured from
+// earlier refreshes, everything else keeps its last map. A cached map gains priority every frame
+// it waits & a light that moved since its map was drawn gains more, so all of them come round in turn.
+// A map's resolution follows its light's screen coverage in power of two classes, up to the size the light asks for.
+// Spot light maps are tiles of one atlas of fixed size, handed out by importance, a light the atlas has no room
+// for takes the tiles of less important ones where that makes room, & a shrinking light keeps its tile. Point lights keep a cube map each, all of them within a fixed
+// texel budget the least important ones drop resolution classes for first. Neither grows with the light count.
+// Maps live here rather than in the frame graph, as they have to survive the frames they aren't drawn in.
+class ShadowScheduler
+{
+public:
+	ShadowScheduler();
+
+	// Allocates the fallback maps, call with a context
+	void Initialize(const ShadowSchedulerSettings& NewSettings);
+
+	// Decides every light's state, call before recording shadow passes
+	// LightMatrices are the 6 view-projection slots per light from PrepareFrame
+	void Schedule(const std::vector<PointLight*>& Lights, const glm::mat4* LightMatrices,
+				  const glm::mat4& View, const glm::mat4& Projection, const glm::vec3& EyePosition);
+
+	ShadowState GetState(size_t ShadowIndex) const { return Entries[ShadowIndex].State; }
+	bool IsRefreshing(size_t ShadowIndex) const { return Entries[ShadowIndex].State == SHADOW_STATE_REFRESH; }
+
+	// Texels a side of a scheduled light's map, already reduced for the memory & cube map budgets
+	GLsizei GetResolution(size_t ShadowIndex) const { return Entries[ShadowIndex].Resolution; }
+
+	// Persistent cube map of a scheduled point light, reallocated when Desc changes (e.g. the shadow filter or resolution)
+	// A new map holds nothing until it is refreshed, it is read as the fallback until then
+	GLuint AcquireMap(size_t ShadowIndex, const RenderTargetDesc& Desc);
+
+	// Where a scheduled spot light draws in the atlas, valid until the next Schedule
+	ShadowTile GetTile(size_t ShadowIndex) const { return Entries[ShadowIndex].Tile; }
+
+	// Atlas texture in the format Desc asks for, GetAtlasSize() a side or a fraction of it
+	// A new format loses every tile, they read as the fallback until they are refreshed
+	GLuint AcquireAtlas(const RenderTargetDesc& Desc);
+	GLsizei GetAtlasSize() const { return Atlas.GetSize(); }
+	float GetAtlasUsage() const { return Atlas.GetUsage(); }
+
+	// A tile is redrawn this frame, the atlas' mips need rebuilding after it
+	bool IsAtlasRefreshing() const { return bAtlasRefreshing; }
+
+	// Map for the lighting pass to read: the light's own or the atlas, or a fallback that is never in shadow
+	GLuint GetTexture(size_t ShadowIndex, bool bMoments) const;
+
+	// The first view-projection of the light when its map was drawn, identity with the fallback
+	// A cached spot light map has to be projected the way it was drawn, not from where the light is now,
+	// & onto its tile of the atlas
+	glm::mat4 GetTransform(size_t ShadowIndex) const;
+
+	// Texture coordinates of the spot light's tile as min xy, max xy, the whole map with the fallback
+	// The lighting pass keeps its filter taps inside, off the neighbouring lights' tiles
+	glm::vec4 GetTileBounds(size_t ShadowIndex) const;
+
+	// Timestamps around this frame's refreshes, the first refreshing pass begins & the lit pass ends them
+	void BeginRefreshTiming();
+	void EndRefreshTiming();
+
+	unsigned int GetCount(ShadowState State) const { return StateCounts[State]; }
+
+	// Smoothed GPU time of one refreshed face (a spot light map is one, a cube six), 0 until the first query returns
+	double GetFaceMilliseconds() const { return RefreshTimer.GetMillisecondsPerWork(); }
+
+	void Clear();
+
+	~ShadowScheduler();
+
+private:
+	struct ShadowEntry
+	{
+		ShadowState State;
+		GLfloat Importance;
+		GLfloat Priority;
+		unsigned int Age;				// Frames since the map was drawn
+		bool bValid;					// The map holds a refresh
+		bool bCube;						// Point light cube map, or a spot light's 2D map
+		glm::mat4 LastMatrix;			// First face matrix at the last refresh, to notice movement
+		GLsizei Resolution;				// Texels a side the map should have
+		GLsizei MapResolution;			// Resolution the cube map was allocated at
+		RenderTargetDesc Desc;
+		GLuint Texture;					// Cube map only
+		ShadowTile Tile;				// Spot light only, may be smaller than Resolution while the atlas is full
+	};
+
+	ShadowSchedulerSettings Settings;
+	std::vector<ShadowEntry> Entries;
+	std::vector<size_t> Candidates;
+	unsigned int StateCounts[4];
+
+	ShadowAtlas Atlas;
+	bool bAtlasRefreshing;
+
+	// Indexed by bCube
+	GLuint FallbackDepth[2];
+	GLuint FallbackMoments[2];
+
+	// Weighed by the faces refreshed, so it gives the time of one
+	GPUTimer RefreshTimer;
+	unsigned int FrameFaces;
+
+	GLfloat CalculateCoverage(const glm::vec3& Position, GLfloat Range,
+							  const glm::mat4& View, const glm::mat4& Projection, const glm::vec3& EyePosition) const;
+	GLsizei CalculateResolution(GLsizei Current, GLsizei MaxSize, GLfloat Coverage) const;
+	void FitCubeBudget();
+	bool AssignTile(ShadowEntry* Entry, size_t Rank);
+	bool EvictTiles(size_t Rank, GLsizei Size);
+	bool IsShadowed(const ShadowEntry& Entry) const;
+	void ReleaseMap(ShadowEntry* Entry);
+
+	static GLuint CreateFallback(const RenderTargetDesc& Desc);
+};
@@ -0,0 +1,61 @@
+#include "SimulationClock.h"
+#include "Log.h"
+
+SimulationClock::SimulationClock()
+{
+	StepSeconds = 1.0 / 120.0;
+	LastFrameTime = 0.0;
+	Accumulated = 0.0;
+	SimulatedTime = 0.0;
+	MaxStepsPerFrame = 8;
+	StepsThisFrame = 0;
+	StepCount = 0;
+}
+
+void SimulationClock::Initialize(double StartTime, double StepRate, unsigned int MaxSteps)
+{
+	StepSeconds = 1.0 / StepRate;
+	LastFrameTime = StartTime;
+	Accumulated = 0.0;
+	SimulatedTime = StartTime;
+	MaxStepsPerFrame = MaxSteps;
+	StepsThisFrame = 0;
+	StepCount = 0;
+}
+
+void SimulationClock::BeginFrame(double Now)
+{
+	Accumulated += Now - LastFrameTime;
+	LastFrameTime = Now;
+	StepsThisFrame = 0;
+
+	// After a long stall (loading, debugger, window drag) catch up at most MaxSteps & let the rest go
+	double MaxAccumulated = StepSeconds * MaxStepsPerFrame;
+	if (Accumulated > MaxAccumulated)
+	{
+		LOG_RATE_LIMITED(1000, LOG_LEVEL_WARNING, "Simulation fell behind, dropped %.1fms", (Accumulated - MaxAccumulated) * 1000.0);
+		SimulatedTime += Accumulated - MaxAccumulated;
+		Accumulated = MaxAccumulated;
+	}
+}
+
+void SimulationClock::Resync(double Now)
+{
+	// Simulated time still follows real time, input timestamps keep lining up with the steps
+	SimulatedTime += Now - LastFrameTime;
+	LastFrameTime = Now;
+}
+
+bool SimulationClock::Step()
+{
+	if (Accumulated < StepSeconds || StepsThisFrame >= MaxStepsPerFrame)
+	{
+		return false;
+	}
+
+	Accumulated -= StepSeconds;
+	SimulatedTime += StepSeconds;
+	StepsThisFrame++;
+	StepCount++;
+	return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+// Fixed timestep accumulator
+// Real time is fed in once per rendered frame, the simulation then runs as many whole steps as fit.
+// The results only depend on the number of steps, not on how they were spread over frames, & the
+// leftover fraction of a step is the blend factor between the previous & current simulation states.
+class SimulationClock
+{
+public:
+	SimulationClock();
+
+	// StepRate in steps per second, MaxSteps per frame before time is dropped (stops a slow frame spiralling)
+	void Initialize(double StartTime, double StepRate, unsigned int MaxSteps);
+
+	void BeginFrame(double Now);
+
+	// Lets the time since the last frame pass without simulating it, e.g. after sleeping on a still scene
+	// Not counted as debt, so the next frame doesn't run catch-up steps or drop time
+	void Resync(double Now);
+
+	// True while another step is due, advances the simulated time when it returns true
+	bool Step();
+
+	double GetStepSeconds() { return StepSeconds; }
+
+	// Simulated time at the end of the step being run
+	double GetTime() { return SimulatedTime; }
+
+	// 0 = previous state, 1 = current state
+	double GetAlpha() { return Accumulated / StepSeconds; }
+
+	unsigned long long GetStepCount() { return StepCount; }
+
+private:
+	double StepSeconds;
+	double LastFrameTime;
+	double Accumulated;
+	double SimulatedTime;
+	unsigned int MaxStepsPerFrame;
+	unsigned int StepsThisFrame;
+	unsigned long long StepCount;
+};
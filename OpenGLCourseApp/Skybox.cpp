@@ -1,18 +1,15 @@
 #include "Skybox.h"
+#include "GPUMemory.h"
+#include "Log.h"
 
 Skybox::Skybox()
 {
 }
 
-Skybox::Skybox(std::vector<std::string> FaceLocations)
+Skybox::Skybox(std::vector<std::string> FaceLocations, AssetManager* Assets)
 {
 	// set up Skybox Shader
-	SkyShader = new Shader();
-	SkyShader->CreateFromFiles("Shaders/skybox.vert", "Shaders/skybox.frag");
-
-	// Set up Uniforms
-	UniformProjection = SkyShader->GetProjectionLocation();
-	UniformView = SkyShader->GetViewLocation();
+	SkyShader = Assets->LoadShader("Shaders/skybox.vert", "Shaders/skybox.frag", "", "");
 
 	//Texture Setup
 	glGenTextures(1, &TextureID);
@@ -37,6 +34,8 @@ Skybox::Skybox(std::vector<std::string> FaceLocations)
 		// Sends the Texture Data to our bound TextureID
 		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, Width, Height, 0, GL_RGB, GL_UNSIGNED_BYTE, TextureData);
 		stbi_image_free(TextureData);
+
+		GPUMemory::TrackAllocation(GPU_MEMORY_MATERIAL_TEXTURES, GPUMemory::CalculateTextureBytes(Width, Height, GL_RGB, 1, false));
 	}
 	// Setup texture parameters for wrapping & filtering
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -79,13 +78,12 @@ Skybox::Skybox(std::vector<std::string> FaceLocations)
 		1.0f, -1.0f, 1.0f,		0.0f, 0.0f,		0.0f, 0.0f, 0.0f
 	};
 
-	SkyMesh = new Mesh();
-	SkyMesh->CreateMesh(SkyboxVertices, SkyboxIndices, 64, 36);
+	SkyMesh.CreateMesh(SkyboxVertices, SkyboxIndices, 64, 36);
 }
 
 void Skybox::DrawSkybox(glm::mat4 ViewMatrix, glm::mat4 ProjectionMatrix)
 {
-	printf("Draw Skybox Called!\n");
+	LOG_TRACE("Draw Skybox Called!");
 	// Strip transform data from the View Matrix
 	ViewMatrix = glm::mat4(glm::mat3(ViewMatrix));
 
@@ -95,11 +93,9 @@ void Skybox::DrawSkybox(glm::mat4 ViewMatrix, glm::mat4 ProjectionMatrix)
 	// Enable Sky Shader
 	SkyShader->UseShader();
 
-	// Bind the Uniform Perspective / Projection Matrix
-	glUniformMatrix4fv(UniformProjection, 1, GL_FALSE, glm::value_ptr(ProjectionMatrix));
-
-	// Bind the Camera / View Matrix
-	glUniformMatrix4fv(UniformView, 1, GL_FALSE, glm::value_ptr(ViewMatrix));
+	// Bind the Projection & View Matrices, skipped when unchanged since the last draw
+	SkyShader->SetProjection(ProjectionMatrix);
+	SkyShader->SetView(ViewMatrix);
 
 	// Set up the Skybox Texture
 	glActiveTexture(GL_TEXTURE0);
@@ -109,7 +105,7 @@ void Skybox::DrawSkybox(glm::mat4 ViewMatrix, glm::mat4 ProjectionMatrix)
 	SkyShader->ValidateShader();
 
 	// Render Mesh
-	SkyMesh->RenderMesh();
+	SkyMesh.RenderMesh();
 
 	// Re-Enable depth checking for rest of scene
 	glDepthMask(GL_TRUE);
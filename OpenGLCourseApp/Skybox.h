@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -13,23 +14,28 @@
 
 #include "Shader.h"
 #include "Mesh.h"
+#include "AssetManager.h"
 
 class Skybox
 {
 public:
 	Skybox();
-	Skybox(std::vector<std::string> FaceLocations);
+	Skybox(std::vector<std::string> FaceLocations, AssetManager* Assets);
+
+	// The mesh is move-only
+	Skybox(Skybox&& Other) = default;
+	Skybox& operator=(Skybox&& Other) = default;
 
 	void DrawSkybox(glm::mat4 ViewMatrix, glm::mat4 ProjectionMatrix);
 
+	Shader* GetShader() { return SkyShader.get(); }
+
 	~Skybox();
 
 private:
-	Mesh* SkyMesh;
-	Shader* SkyShader;
+	Mesh SkyMesh;
+	std::shared_ptr<Shader> SkyShader;
 
 	GLuint TextureID;
-	GLuint UniformProjection;
-	GLuint UniformView;
 
 };
\ No newline at end of file
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+// 32-bit handle into a SlotMap: low 20 bits slot index, high 12 bits generation
+// Handles are plain values, safe to copy into render queues or hand to worker threads.
+// A handle to a removed object doesn't resolve again when its slot is reused, until the slot's
+// 12-bit generation wraps round after 4095 more removals.
+struct SlotHandle
+{
+	uint32_t Value;
+
+	static const uint32_t IndexBits = 20;
+	static const uint32_t IndexMask = (1u << IndexBits) - 1;
+	static const uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+
+	uint32_t GetIndex() const { return Value & IndexMask; }
+	uint32_t GetGeneration() const { return Value >> IndexBits; }
+
+	bool operator==(const SlotHandle& Other) const { return Value == Other.Value; }
+	bool operator!=(const SlotHandle& Other) const { return Value != Other.Value; }
+};
+
+// Generation 0 is never handed out, so a zeroed handle is always invalid
+const SlotHandle INVALID_SLOT_HANDLE = { 0 };
+
+// Objects stored contiguously with O(1) insert, remove & handle lookup
+// Removal moves the last object into the hole, so iteration over [0, Size()) never skips
+// but the dense order changes. Nothing is locked: inserts & removes belong to one thread,
+// lookups from other threads are fine while no insert or remove can run.
+template <typename T>
+class SlotMap
+{
+public:
+	SlotMap()
+	{
+		FreeHead = NoSlot;
+	}
+
+	SlotHandle Insert(T&& Object)
+	{
+		uint32_t SlotIndex = FreeHead;
+		if (SlotIndex != NoSlot)
+		{
+			FreeHead = Slots[SlotIndex].DenseIndex;
+		}
+		else
+		{
+			SlotIndex = (uint32_t)Slots.size();
+			Slots.push_back({ 0, 0 });
+		}
+
+		Slot& NewSlot = Slots[SlotIndex];
+		NewSlot.Generation = NextGeneration(NewSlot.Generation);
+		NewSlot.DenseIndex = (uint32_t)Objects.size();
+
+		Objects.push_back(std::move(Object));
+		DenseToSlot.push_back(SlotIndex);
+
+		return { (NewSlot.Generation << SlotHandle::IndexBits) | SlotIndex };
+	}
+
+	// nullptr if the handle is stale or was never valid
+	T* Get(SlotHandle Handle)
+	{
+		uint32_t SlotIndex = Handle.GetIndex();
+		if (SlotIndex >= Slots.size() || Slots[SlotIndex].Generation != Handle.GetGeneration())
+		{
+			return nullptr;
+		}
+		return &Objects[Slots[SlotIndex].DenseIndex];
+	}
+
+	bool Contains(SlotHandle Handle)
+	{
+		return Get(Handle) != nullptr;
+	}
+
+	bool Remove(SlotHandle Handle)
+	{
+		if (!Contains(Handle))
+		{
+			return false;
+		}
+
+		uint32_t SlotIndex = Handle.GetIndex();
+		uint32_t DenseIndex = Slots[SlotIndex].DenseIndex;
+		uint32_t LastIndex = (uint32_t)Objects.size() - 1;
+
+		// Fill the hole with the last object & repoint its slot
+		if (DenseIndex != LastIndex)
+		{
+			Objects[DenseIndex] = std::move(Objects[LastIndex]);
+			DenseToSlot[DenseIndex] = DenseToSlot[LastIndex];
+			Slots[DenseToSlot[DenseIndex]].DenseIndex = DenseIndex;
+		}
+		Objects.pop_back();
+		DenseToSlot.pop_back();
+
+		// Bumping the generation invalidates every outstanding copy of the handle
+		Slots[SlotIndex].Generation = NextGeneration(Slots[SlotIndex].Generation);
+		Slots[SlotIndex].DenseIndex = FreeHead;
+		FreeHead = SlotIndex;
+		return true;
+	}
+
+	void Clear()
+	{
+		// Keep the generations, so handles from before the clear stay invalid
+		for (size_t i = 0; i < DenseToSlot.size(); i++)
+		{
+			Slot& OldSlot = Slots[DenseToSlot[i]];
+			OldSlot.Generation = NextGeneration(OldSlot.Generation);
+			OldSlot.DenseIndex = FreeHead;
+			FreeHead = DenseToSlot[i];
+		}
+		Objects.clear();
+		DenseToSlot.clear();
+	}
+
+	void Reserve(size_t Count)
+	{
+		Objects.reserve(Count);
+		DenseToSlot.reserve(Count);
+		Slots.reserve(Count);
+	}
+
+	// Dense access for iteration
+	size_t Size() const { return Objects.size(); }
+	T& operator[](size_t DenseIndex) { return Objects[DenseIndex]; }
+	typename std::vector<T>::iterator begin() { return Objects.begin(); }
+	typename std::vector<T>::iterator end() { return Objects.end(); }
+
+private:
+	static const uint32_t NoSlot = 0xFFFFFFFF;
+
+	struct Slot
+	{
+		uint32_t DenseIndex;		// Next free slot while unused
+		uint32_t Generation;
+	};
+
+	// Skips 0 on wrapping, a free slot must never match a zeroed handle
+	static uint32_t NextGeneration(uint32_t Generation)
+	{
+		Generation = (Generation + 1) & SlotHandle::GenerationMask;
+		return Generation == 0 ? 1 : Generation;
+	}
+
+	std::vector<T> Objects;
+	std::vector<uint32_t> DenseToSlot;
+	std::vector<Slot> Slots;
+	uint32_t FreeHead;
+};
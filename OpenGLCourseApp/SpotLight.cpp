@@ -1,4 +1,8 @@
 #include "SpotLight.h"
+#include "Shader.h"
+
+// Degrees added around the cone, so filter taps at its edge still land inside the shadow map
+static const GLfloat ShadowFieldMargin = 4.0f;
 
 SpotLight::SpotLight() : PointLight()
 {
@@ -20,30 +24,47 @@ SpotLight::SpotLight(GLfloat NewShadowWidth, GLfloat NewShadowHeight,
 	Direction = glm::normalize(glm::vec3(DirX, DirY, DirZ));
 	Edge = NewEdge;
 	ProcessedEdge = cosf(glm::radians(Edge));
+	bEnableFlashlight = true;
+
+	// The cone fits one perspective map, replace the cube the point light constructor made
+	// Edge is the half angle, so the map's field of view is twice that
+	GLfloat FieldOfView = glm::min(2.0f * Edge + ShadowFieldMargin, 170.0f);
+	LightProjection = glm::perspective(glm::radians(FieldOfView), NewShadowWidth / NewShadowHeight, NearPlane, FarPlane);
+
+	delete MyShadowMap;
+	MyShadowMap = new ShadowMap();
+	MyShadowMap->Initialize(NewShadowWidth, NewShadowHeight);
 }
 
-void SpotLight::UseLight(GLuint AmbientIntensityLocation, GLuint AmbientColorLocation,
-	GLuint DiffuseIntensityLocation, GLuint PositionLocation, GLuint DirectionLocation,
-	GLuint ConstantLocation, GLuint LinearLocation, GLuint ExponentLocation,
-	GLuint EdgeLocation)
+void SpotLight::UseLight(Shader* TheShader, UniformHandle AmbientIntensityHandle, UniformHandle AmbientColorHandle,
+	UniformHandle DiffuseIntensityHandle, UniformHandle PositionHandle, UniformHandle DirectionHandle,
+	UniformHandle ConstantHandle, UniformHandle LinearHandle, UniformHandle ExponentHandle,
+	UniformHandle EdgeHandle)
 {
-	glUniform3f(AmbientColorLocation, Color.x, Color.y, Color.z);
+	TheShader->SetUniform(AmbientColorHandle, Color);
 	if (bEnableFlashlight)
 	{
-		glUniform1f(AmbientIntensityLocation, AmbientIntensity);
-		glUniform1f(DiffuseIntensityLocation, DiffuseIntensity);
+		TheShader->SetUniform(AmbientIntensityHandle, AmbientIntensity);
+		TheShader->SetUniform(DiffuseIntensityHandle, DiffuseIntensity);
 	}
 	else
 	{
-		glUniform1f(AmbientIntensityLocation, 0.0f);
-		glUniform1f(DiffuseIntensityLocation, 0.0f);
+		TheShader->SetUniform(AmbientIntensityHandle, 0.0f);
+		TheShader->SetUniform(DiffuseIntensityHandle, 0.0f);
 	}
-	glUniform3f(PositionLocation, Position.x, Position.y, Position.z);
-	glUniform1f(ConstantLocation, Constant);
-	glUniform1f(LinearLocation, Linear);
-	glUniform1f(ExponentLocation, Exponent);
-	glUniform3f(DirectionLocation, Direction.x, Direction.y, Direction.z);
-	glUniform1f(EdgeLocation, ProcessedEdge);
+	TheShader->SetUniform(PositionHandle, Position);
+	TheShader->SetUniform(ConstantHandle, Constant);
+	TheShader->SetUniform(LinearHandle, Linear);
+	TheShader->SetUniform(ExponentHandle, Exponent);
+	TheShader->SetUniform(DirectionHandle, Direction);
+	TheShader->SetUniform(EdgeHandle, ProcessedEdge);
+}
+
+void SpotLight::CalculateLightTransforms(glm::mat4* OutMatrices)
+{
+	// Any up vector will do as long as it isn't along the cone
+	glm::vec3 Up = glm::abs(Direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	OutMatrices[0] = LightProjection * glm::lookAt(Position, Position + Direction, Up);
 }
 
 void SpotLight::SetFlash(glm::vec3 FlashPosition, glm::vec3 FlashDirection)
@@ -16,15 +16,19 @@ public:
 		GLfloat NewConstant, GLfloat NewLinear, GLfloat NewExponent,
 		GLfloat NewEdge);
 
-	// Bind light values for use in the shader (Location here meaning the ID in the shader, not a position)
-	void UseLight(GLuint AmbientIntensityLocation, GLuint AmbientColorLocation,
-		GLuint DiffuseIntensityLocation, GLuint PositionLocation, GLuint DirectionLocation,
-		GLuint ConstantLocation, GLuint LinearLocation, GLuint ExponentLocation,
-		GLuint EdgeLocation);
+	// Set light values on the shader in use, through its cached setters
+	void UseLight(Shader* TheShader, UniformHandle AmbientIntensityHandle, UniformHandle AmbientColorHandle,
+		UniformHandle DiffuseIntensityHandle, UniformHandle PositionHandle, UniformHandle DirectionHandle,
+		UniformHandle ConstantHandle, UniformHandle LinearHandle, UniformHandle ExponentHandle,
+		UniformHandle EdgeHandle);
+
+	// Writes the single view-projection of the cone's perspective shadow map to OutMatrices[0]
+	void CalculateLightTransforms(glm::mat4* OutMatrices) override;
 
 	void SetFlash(glm::vec3 FlashPosition, glm::vec3 FlashDirection);
 
 	void ToggleSpotlight(bool NewSetting);
+	bool IsEnabled() override { return bEnableFlashlight; }
 
 	~SpotLight();
 
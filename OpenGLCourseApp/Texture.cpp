@@ -1,5 +1,40 @@
+#include <utility>
+
 #include "Texture.h"
 #include "CommonValues.h"
+#include "GPUMemory.h"
+#include "Log.h"
+
+// Textures lose at most this many top mips when memory is over budget
+static const unsigned int MaxMipDrop = 2;
+
+// 2x2 box filter, in place: each output pixel is written at or before the first input it reads
+static void HalveImage(unsigned char* Pixels, int* InOutWidth, int* InOutHeight, int Channels)
+{
+	int OldWidth = *InOutWidth;
+	int NewWidth = OldWidth > 1 ? OldWidth / 2 : 1;
+	int NewHeight = *InOutHeight > 1 ? *InOutHeight / 2 : 1;
+	int StepX = OldWidth > 1 ? 1 : 0;
+	int StepY = *InOutHeight > 1 ? 1 : 0;
+
+	for (int y = 0; y < NewHeight; y++)
+	{
+		const unsigned char* Row0 = Pixels + (size_t)(y * 2) * OldWidth * Channels;
+		const unsigned char* Row1 = Pixels + (size_t)(y * 2 + StepY) * OldWidth * Channels;
+		for (int x = 0; x < NewWidth; x++)
+		{
+			for (int c = 0; c < Channels; c++)
+			{
+				int Left = (x * 2) * Channels + c;
+				int Right = (x * 2 + StepX) * Channels + c;
+				Pixels[((size_t)y * NewWidth + x) * Channels + c] = (unsigned char)((Row0[Left] + Row0[Right] + Row1[Left] + Row1[Right] + 2) / 4);
+			}
+		}
+	}
+
+	*InOutWidth = NewWidth;
+	*InOutHeight = NewHeight;
+}
 
 Texture::Texture()
 {
@@ -8,6 +43,7 @@ Texture::Texture()
 	Height = 0;
 	BitDepth = 0;
 	FilePath = "";
+	PendingData = nullptr;
 }
 
 Texture::Texture(const char* FilePath) :
@@ -17,58 +53,77 @@ Texture::Texture(const char* FilePath) :
 	Width = 0;
 	Height = 0;
 	BitDepth = 0;
-	FilePath = FilePath;
+	PendingData = nullptr;
 }
 
-bool Texture::LoadAlphaTexture()
+Texture::Texture(Texture&& Other) noexcept
 {
-	// &OutParams get set and returned by this STBI function
-	unsigned char* TextureData = stbi_load(FilePath, &Width, &Height, &BitDepth, 0);
+	TextureID = 0;
+	Width = 0;
+	Height = 0;
+	BitDepth = 0;
+	PendingData = nullptr;
+	*this = std::move(Other);
+}
 
-	if (!TextureData)
+Texture& Texture::operator=(Texture&& Other) noexcept
+{
+	if (this != &Other)
 	{
-		printf("Failed to find a texture at:  %s\n", FilePath);
-		return false;
+		ClearTexture();
+
+		TextureID = std::exchange(Other.TextureID, 0);
+		Width = std::exchange(Other.Width, 0);
+		Height = std::exchange(Other.Height, 0);
+		BitDepth = std::exchange(Other.BitDepth, 0);
+		FilePath = std::move(Other.FilePath);
+		PendingData = std::exchange(Other.PendingData, nullptr);
 	}
+	return *this;
+}
 
-	// Create the Texture ID
-	glGenTextures(1, &TextureID);
-
-	// Bind the Texture to the new ID
-	glBindTexture(GL_TEXTURE_2D, TextureID);
-
-	// Setup texture parameters for wrapping & filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+bool Texture::LoadAlphaTexture()
+{
+	return DecodeTexture() && UploadTexture(GL_RGBA);
+}
 
-	// We use UNSIGNED_BYTE here for our texture data's unsigned Chars (Byte & Char are interchangeable here)
-	// Sends the Texture Data to our bound TextureID
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, Width, Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, TextureData);
+bool Texture::LoadTexture()
+{
+	return DecodeTexture() && UploadTexture(GL_RGB);
+}
 
-	// Create Mips automatically
-	glGenerateMipmap(GL_TEXTURE_2D);
+bool Texture::DecodeTexture()
+{
+	// &OutParams get set and returned by this STBI function
+	PendingData = stbi_load(FilePath.c_str(), &Width, &Height, &BitDepth, 0);
 
-	// Unbind the Texture from GL_TEXTURE_2D
-	glBindTexture(GL_TEXTURE_2D, 0);
+	if (!PendingData)
+	{
+		printf("Failed to find a texture at:  %s\n", FilePath.c_str());
+		return false;
+	}
 
-	// Clears the loaded data, no longer needed now that it's copied into the TextureID
-	stbi_image_free(TextureData);
 	return true;
 }
 
-bool Texture::LoadTexture()
+bool Texture::UploadTexture(GLenum Format)
 {
-	// &OutParams get set and returned by this STBI function
-	unsigned char* TextureData = stbi_load(FilePath, &Width, &Height, &BitDepth, 0);
-
-	if (!TextureData)
+	if (!PendingData)
 	{
-		printf("Failed to find a texture at:  %s\n", FilePath);
 		return false;
 	}
 
+	// Over budget: skip the top mips rather than failing, the texture just gets blurrier
+	unsigned int MipDrop = GPUMemory::CalculateMipDrop((size_t)Width * Height * BitDepth * 4 / 3, MaxMipDrop);
+	for (unsigned int i = 0; i < MipDrop; i++)
+	{
+		HalveImage(PendingData, &Width, &Height, BitDepth);
+	}
+	if (MipDrop > 0)
+	{
+		LOG_WARNING("Dropped %u mip levels of %s to stay in the GPU memory budget", MipDrop, FilePath.c_str());
+	}
+
 	// Create the Texture ID
 	glGenTextures(1, &TextureID);
 
@@ -83,7 +138,7 @@ bool Texture::LoadTexture()
 
 	// We use UNSIGNED_BYTE here for our texture data's unsigned Chars (Byte & Char are interchangeable here)
 	// Sends the Texture Data to our bound TextureID
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, Width, Height, 0, GL_RGB, GL_UNSIGNED_BYTE, TextureData);
+	glTexImage2D(GL_TEXTURE_2D, 0, Format, Width, Height, 0, Format, GL_UNSIGNED_BYTE, PendingData);
 
 	// Create Mips automatically
 	glGenerateMipmap(GL_TEXTURE_2D);
@@ -92,7 +147,10 @@ bool Texture::LoadTexture()
 	glBindTexture(GL_TEXTURE_2D, 0);
 
 	// Clears the loaded data, no longer needed now that it's copied into the TextureID
-	stbi_image_free(TextureData);
+	stbi_image_free(PendingData);
+	PendingData = nullptr;
+
+	GPUMemory::TrackAllocation(GPU_MEMORY_MATERIAL_TEXTURES, GetByteSize());
 
 	return true;
 }
@@ -104,17 +162,34 @@ void Texture::UseTexture()
 	glBindTexture(GL_TEXTURE_2D, TextureID);
 }
 
+void Texture::RecordTexture(CommandBuffer* Commands)
+{
+	// Same unit as UseTexture
+	Commands->BindTexture(GL_TEXTURE1, GL_TEXTURE_2D, TextureID);
+}
+
 void Texture::ClearTexture()
 {
-	glDeleteTextures(1, &TextureID);
-	TextureID = 0;
+	// Only touch GL when there is something to delete, decoded-only textures may live on worker threads
+	if (TextureID != 0)
+	{
+		GPUMemory::TrackRelease(GPU_MEMORY_MATERIAL_TEXTURES, GetByteSize());
+		glDeleteTextures(1, &TextureID);
+		TextureID = 0;
+	}
 	Width = 0;
 	Height = 0;
 	BitDepth = 0;
 	FilePath = "";
+
+	if (PendingData)
+	{
+		stbi_image_free(PendingData);
+		PendingData = nullptr;
+	}
 }
 
 Texture::~Texture()
 {
 	ClearTexture();
-}
\ No newline at end of file
+}
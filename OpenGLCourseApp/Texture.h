@@ -1,18 +1,40 @@
 #pragma once
 
+#include <string>
+
 #include <GL/glew.h>
 
+#include "CommandBuffer.h"
+
 class Texture
 {
 
 public:
 	Texture();
 	Texture(const char* FilePath);
+
+	// Owns the GL texture & any pending pixels, so it can be moved but not copied
+	Texture(Texture&& Other) noexcept;
+	Texture& operator=(Texture&& Other) noexcept;
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+
 	~Texture();
 
 	bool LoadTexture();
 	bool LoadAlphaTexture();
+
+	// Split loading: Decode is CPU only & safe on worker threads, Upload must run on the GL context thread
+	bool DecodeTexture();
+	bool UploadTexture(GLenum Format);
+
+	bool IsUploaded() { return TextureID != 0; }
+
+	// GPU memory including the mip chain
+	size_t GetByteSize() { return IsUploaded() ? (size_t)Width * Height * BitDepth * 4 / 3 : 0; }
+
 	void UseTexture();
+	void RecordTexture(CommandBuffer* Commands);
 	void ClearTexture();
 
 private:
@@ -20,6 +42,9 @@ private:
 	int Width;
 	int Height;
 	int BitDepth;
-	const char* FilePath;
+	std::string FilePath;
+
+	// Decoded pixels waiting for UploadTexture
+	unsigned char* PendingData;
 };
 
@@ -0,0 +1,66 @@
+#include "Upscaler.h"
+
+Upscaler::Upscaler()
+{
+	UniformGeneration = 0;
+	UniformSceneColor = INVALID_UNIFORM;
+	UniformSourceScale = INVALID_UNIFORM;
+	UniformTexelSize = INVALID_UNIFORM;
+	UniformSharpness = INVALID_UNIFORM;
+	EmptyVAO = 0;
+}
+
+void Upscaler::Initialize(AssetManager* Assets)
+{
+	UpscaleShader = Assets->LoadShader("Shaders/fullscreen.vert", "Shaders/upscale.frag", "", "");
+	glGenVertexArrays(1, &EmptyVAO);
+}
+
+void Upscaler::Draw(GLuint SourceTexture, GLsizei SourceWidth, GLsizei SourceHeight,
+	GLsizei TextureWidth, GLsizei TextureHeight, GLfloat Sharpness)
+{
+	UpscaleShader->UseShader();
+	if (UpscaleShader->GetProgramGeneration() != UniformGeneration)
+	{
+		ResolveUniforms();
+	}
+
+	UpscaleShader->SetUniform(UniformSceneColor, (GLint)1);
+	UpscaleShader->SetUniform(UniformSourceScale, glm::vec2((GLfloat)SourceWidth / TextureWidth, (GLfloat)SourceHeight / TextureHeight));
+	UpscaleShader->SetUniform(UniformTexelSize, glm::vec2(1.0f / TextureWidth, 1.0f / TextureHeight));
+	UpscaleShader->SetUniform(UniformSharpness, Sharpness);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, SourceTexture);
+
+	// One triangle covering the screen, nothing to depth test against
+	glDisable(GL_DEPTH_TEST);
+	glBindVertexArray(EmptyVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
+}
+
+void Upscaler::ResolveUniforms()
+{
+	// A hot reload relinks the program, the old handles may point at other uniforms
+	UniformSceneColor = UpscaleShader->FindUniform("SceneColor");
+	UniformSourceScale = UpscaleShader->FindUniform("SourceScale");
+	UniformTexelSize = UpscaleShader->FindUniform("TexelSize");
+	UniformSharpness = UpscaleShader->FindUniform("Sharpness");
+	UniformGeneration = UpscaleShader->GetProgramGeneration();
+}
+
+void Upscaler::Clear()
+{
+	if (EmptyVAO != 0)
+	{
+		glDeleteVertexArrays(1, &EmptyVAO);
+		EmptyVAO = 0;
+	}
+	UpscaleShader.reset();
+}
+
+Upscaler::~Upscaler()
+{
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+
+#include <GL/glew.h>
+
+#include "Shader.h"
+#include "AssetManager.h"
+
+// Stretches the part of a render target the main pass drew over the whole framebuffer
+// Bilinear upscale plus a sharpen that grows as the source shrinks, clamped to each pixel's neighbours
+// so edges don't ring. At full scale with no sharpening it is a plain copy.
+class Upscaler
+{
+public:
+	Upscaler();
+
+	void Initialize(AssetManager* Assets);
+
+	// Source covers SourceWidth x SourceHeight in the bottom left of a TextureWidth x TextureHeight texture
+	// Sharpness 0 - 1, draws into whatever framebuffer & viewport are bound
+	void Draw(GLuint SourceTexture, GLsizei SourceWidth, GLsizei SourceHeight,
+		GLsizei TextureWidth, GLsizei TextureHeight, GLfloat Sharpness);
+
+	Shader* GetShader() { return UpscaleShader.get(); }
+
+	void Clear();
+
+	~Upscaler();
+
+private:
+	std::shared_ptr<Shader> UpscaleShader;
+
+	// Looked up again only when the program generation changes
+	unsigned int UniformGeneration;
+	UniformHandle UniformSceneColor;
+	UniformHandle UniformSourceScale;
+	UniformHandle UniformTexelSize;
+	UniformHandle UniformSharpness;
+
+	// Core profile draws need a vertex array bound, even though the triangle comes from gl_VertexID
+	GLuint EmptyVAO;
+
+	void ResolveUniforms();
+};